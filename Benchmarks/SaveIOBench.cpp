@@ -0,0 +1,158 @@
+// Throughput of the save I/O backend on a snapshot-sized world: one large
+// synced write through `SaveIOWrite`, then the same world as 64 KiB chunk
+// files read back through `SaveIOReadFiles` in windows of 64, as a snapshot
+// restore does, first with the page cache dropped and then warm. The
+// backend is picked once per process, so `save-io-bench.sh` runs this once
+// with io_uring and once with `CAPITALIST_SAVE_IO=threads`.
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+typedef int32_t (*SaveIOConsume)(void *context, int32_t index, const uint8_t *data, int64_t length);
+
+extern "C" int32_t SaveIOWrite(int32_t fd,
+                               const uint8_t *const *buffers,
+                               const int64_t *lengths,
+                               int32_t count,
+                               int64_t offset,
+                               int32_t sync);
+extern "C" int32_t SaveIOReadFiles(const int32_t *fds,
+                                   const int64_t *capacities,
+                                   int32_t count,
+                                   SaveIOConsume consume,
+                                   void *context);
+extern "C" int32_t SaveIOBackend(void);
+
+namespace {
+constexpr size_t kChunkBytes = 64u << 10;
+constexpr int32_t kWindow = 64;
+
+double seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double mebibytesPerSecond(size_t bytes, double elapsed) {
+    return static_cast<double>(bytes) / (1 << 20) / elapsed;
+}
+
+std::string chunkPath(const std::string &directory, size_t chunk) {
+    return directory + "/chunk-" + std::to_string(chunk);
+}
+
+struct Window {
+    const uint8_t *world;
+    size_t first;
+    bool mismatch;
+};
+
+// Checks each chunk read against the world it was written from.
+int32_t compareChunk(void *context, int32_t index, const uint8_t *data, int64_t length) {
+    auto *window = static_cast<Window *>(context);
+    const uint8_t *expected = window->world + (window->first + static_cast<size_t>(index)) * kChunkBytes;
+    if (length != static_cast<int64_t>(kChunkBytes) || std::memcmp(data, expected, kChunkBytes) != 0) {
+        window->mismatch = true;
+        return -1;
+    }
+    return 0;
+}
+
+// Reads every chunk back in windows, dropping each file from the page
+// cache first when `cold`. Returns the elapsed seconds, or -1 on failure.
+double readChunks(const std::string &directory, const std::vector<uint8_t> &world, size_t chunks, bool cold) {
+    const std::vector<int64_t> capacities(kWindow, static_cast<int64_t>(kChunkBytes) + 1);
+    std::vector<int32_t> fds;
+    const double start = seconds();
+    for (size_t first = 0; first < chunks; first += kWindow) {
+        const size_t count = std::min<size_t>(kWindow, chunks - first);
+        fds.clear();
+        for (size_t chunk = first; chunk < first + count; ++chunk) {
+            const int fd = ::open(chunkPath(directory, chunk).c_str(), O_RDONLY);
+            if (fd < 0) {
+                return -1;
+            }
+            if (cold) {
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            }
+            fds.push_back(fd);
+        }
+        Window window{world.data(), first, false};
+        const int32_t result =
+            SaveIOReadFiles(fds.data(), capacities.data(), static_cast<int32_t>(count), compareChunk, &window);
+        for (int fd : fds) {
+            ::close(fd);
+        }
+        if (result != 0 || window.mismatch) {
+            return -1;
+        }
+    }
+    return seconds() - start;
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <gibibytes> <directory>\n", argv[0]);
+        return 2;
+    }
+    const size_t length = static_cast<size_t>(std::atol(argv[1])) << 30;
+    const std::string directory = argv[2];
+    const size_t chunks = length / kChunkBytes;
+    std::printf("backend: %s, world: %zu MiB\n", SaveIOBackend() == 1 ? "io_uring" : "threads", length >> 20);
+
+    std::vector<uint8_t> world(length);
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (size_t offset = 0; offset < length; offset += sizeof(state)) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::memcpy(world.data() + offset, &state, sizeof(state));
+    }
+
+    const std::string worldPath = directory + "/world";
+    const int fd = ::open(worldPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    const uint8_t *buffers[] = {world.data()};
+    const int64_t lengths[] = {static_cast<int64_t>(length)};
+    double start = seconds();
+    if (fd < 0 || SaveIOWrite(fd, buffers, lengths, 1, 0, 1) != 0) {
+        std::perror(worldPath.c_str());
+        return 1;
+    }
+    std::printf("write + fdatasync:  %8.0f MiB/s\n", mebibytesPerSecond(length, seconds() - start));
+    ::close(fd);
+    ::unlink(worldPath.c_str());
+
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        const std::string path = chunkPath(directory, chunk);
+        const int chunkFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        const uint8_t *chunkBuffers[] = {world.data() + chunk * kChunkBytes};
+        const int64_t chunkLengths[] = {static_cast<int64_t>(kChunkBytes)};
+        if (chunkFd < 0 || SaveIOWrite(chunkFd, chunkBuffers, chunkLengths, 1, 0, 0) != 0) {
+            std::perror(path.c_str());
+            return 1;
+        }
+        ::close(chunkFd);
+    }
+    ::sync();
+
+    const double cold = readChunks(directory, world, chunks, true);
+    const double warm = readChunks(directory, world, chunks, false);
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        ::unlink(chunkPath(directory, chunk).c_str());
+    }
+    if (cold < 0 || warm < 0) {
+        std::fprintf(stderr, "chunk read failed or did not match\n");
+        return 1;
+    }
+    std::printf("chunk restore cold: %8.0f MiB/s\n", mebibytesPerSecond(chunks * kChunkBytes, cold));
+    std::printf("chunk restore warm: %8.0f MiB/s\n", mebibytesPerSecond(chunks * kChunkBytes, warm));
+    return 0;
+}
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Compares the io_uring and thread-pool save I/O backends on a world of
+# GIB gibibytes (default 2), written to and read from DIR (default a new
+# temporary directory). Linux only; needs about twice GIB of free memory
+# and GIB of free disk.
+#
+#   Benchmarks/save-io-bench.sh [GIB] [DIR]
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+sources="$here/../Capitalist World CLI"
+gibibytes=${1:-2}
+binary=$(mktemp)
+if [ $# -ge 2 ]; then
+    directory=$2
+    trap 'rm -f "$binary"' EXIT
+else
+    directory=$(mktemp -d)
+    trap 'rm -f "$binary"; rm -rf "$directory"' EXIT
+fi
+
+${CXX:-c++} -std=gnu++20 -O2 -pthread -o "$binary" "$here/SaveIOBench.cpp" "$sources/SaveIO.cpp"
+
+mkdir -p "$directory"
+"$binary" "$gibibytes" "$directory"
+echo
+CAPITALIST_SAVE_IO=threads "$binary" "$gibibytes" "$directory"
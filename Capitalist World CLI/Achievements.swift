@@ -0,0 +1,236 @@
+import Foundation
+
+/// Achievement conditions, written as declarative rules over player metrics.
+/// A rule is `metric op number` comparisons joined with `and` / `or`
+/// (`and` binds tighter). Names and descriptions live in the string catalog
+/// under `achievement.<id>`.
+enum AchievementRules {
+    static let definitions: [(id: String, source: String)] = [
+        ("first_million", "profit >= 1000000"),
+        ("first_billion", "cash >= 1000000000"),
+        ("first_acquisition", "subsidiaries >= 1"),
+        ("conglomerate", "subsidiaries >= 10"),
+        ("regional_monopoly", "monopolies >= 1"),
+        ("steel_baron", "stock.steel >= 10000"),
+        ("diversified", "stock.grain >= 1000 and stock.coal >= 1000 and stock.steel >= 1000"),
+        ("merchant", "sales >= 10000000"),
+        ("household_name", "awareness >= 0.5"),
+        ("survivor", "days >= 3650 and cash > 0"),
+        ("tycoon", "cash >= 100000000 or subsidiaries >= 5 and profit >= 10000000")
+    ]
+}
+
+enum AchievementRuleError: Error {
+    case invalidRule(id: String, reason: String)
+}
+
+/// Rules compiled into comparisons over a fixed set of metric slots, plus
+/// the reverse index from each slot to the rules that read it.
+struct AchievementPlan {
+    enum Metric: Hashable {
+        case cash
+        case profit
+        case sales
+        case subsidiaries
+        /// Regions in which the player owns every company.
+        case monopolies
+        /// Player's best share of regional brand awareness, 0...1.
+        case awareness
+        case days
+        case stock(Good)
+
+        init?(name: String) {
+            switch name {
+            case "cash":
+                self = .cash
+            case "profit":
+                self = .profit
+            case "sales":
+                self = .sales
+            case "subsidiaries":
+                self = .subsidiaries
+            case "monopolies":
+                self = .monopolies
+            case "awareness":
+                self = .awareness
+            case "days":
+                self = .days
+            default:
+                guard name.hasPrefix("stock."),
+                      let good = Good.allCases.first(where: { $0.key == "good." + name.dropFirst("stock.".count) }) else {
+                    return nil
+                }
+                self = .stock(good)
+            }
+        }
+    }
+
+    struct Condition {
+        enum Comparison: String, CaseIterable {
+            case greaterOrEqual = ">="
+            case lessOrEqual = "<="
+            case greater = ">"
+            case less = "<"
+            case equal = "=="
+        }
+
+        let slot: Int
+        let comparison: Comparison
+        let threshold: Double
+
+        func holds(_ value: Double) -> Bool {
+            switch comparison {
+            case .greaterOrEqual:
+                return value >= threshold
+            case .lessOrEqual:
+                return value <= threshold
+            case .greater:
+                return value > threshold
+            case .less:
+                return value < threshold
+            case .equal:
+                return value == threshold
+            }
+        }
+    }
+
+    struct Rule {
+        let id: String
+        /// Disjunction of conjunctions of indices into `conditions`.
+        let clauses: [[Int]]
+    }
+
+    static let standard: AchievementPlan = {
+        do {
+            return try compile(AchievementRules.definitions)
+        } catch {
+            preconditionFailure("Invalid achievement rules: \(error)")
+        }
+    }()
+
+    let metrics: [Metric]
+    let conditions: [Condition]
+    let rules: [Rule]
+    /// Rule indices reading each metric slot.
+    let dependents: [[Int]]
+
+    static func compile(_ definitions: [(id: String, source: String)]) throws -> AchievementPlan {
+        var metrics: [Metric] = []
+        var slots: [Metric: Int] = [:]
+        var conditions: [Condition] = []
+        var rules: [Rule] = []
+        var dependents: [[Int]] = []
+
+        for definition in definitions {
+            let tokens = definition.source.lowercased().split(separator: " ", omittingEmptySubsequences: true).map(String.init)
+            var clauses: [[Int]] = [[]]
+            var index = 0
+
+            while index < tokens.count {
+                guard index + 2 < tokens.count else {
+                    throw AchievementRuleError.invalidRule(id: definition.id, reason: "incomplete comparison")
+                }
+                guard let metric = Metric(name: tokens[index]) else {
+                    throw AchievementRuleError.invalidRule(id: definition.id, reason: "unknown metric '\(tokens[index])'")
+                }
+                guard let comparison = Condition.Comparison(rawValue: tokens[index + 1]) else {
+                    throw AchievementRuleError.invalidRule(id: definition.id, reason: "unknown operator '\(tokens[index + 1])'")
+                }
+                guard let threshold = Double(tokens[index + 2]) else {
+                    throw AchievementRuleError.invalidRule(id: definition.id, reason: "invalid number '\(tokens[index + 2])'")
+                }
+
+                let slot: Int
+                if let existing = slots[metric] {
+                    slot = existing
+                } else {
+                    slot = metrics.count
+                    slots[metric] = slot
+                    metrics.append(metric)
+                    dependents.append([])
+                }
+                if dependents[slot].last != rules.count {
+                    dependents[slot].append(rules.count)
+                }
+
+                clauses[clauses.count - 1].append(conditions.count)
+                conditions.append(Condition(slot: slot, comparison: comparison, threshold: threshold))
+                index += 3
+
+                guard index < tokens.count else { break }
+                switch tokens[index] {
+                case "and":
+                    break
+                case "or":
+                    clauses.append([])
+                default:
+                    throw AchievementRuleError.invalidRule(id: definition.id, reason: "expected 'and' or 'or', found '\(tokens[index])'")
+                }
+                index += 1
+                if index == tokens.count {
+                    throw AchievementRuleError.invalidRule(id: definition.id, reason: "dangling '\(tokens[index - 1])'")
+                }
+            }
+
+            guard clauses.allSatisfy({ $0.isEmpty == false }) else {
+                throw AchievementRuleError.invalidRule(id: definition.id, reason: "empty rule")
+            }
+            rules.append(Rule(id: definition.id, clauses: clauses))
+        }
+
+        return AchievementPlan(metrics: metrics, conditions: conditions, rules: rules, dependents: dependents)
+    }
+
+    func isSatisfied(_ rule: Int, values: [Double]) -> Bool {
+        rules[rule].clauses.contains { clause in
+            clause.allSatisfy { conditions[$0].holds(values[conditions[$0].slot]) }
+        }
+    }
+}
+
+/// Unlocked achievements of one game. Each update measures the metrics
+/// still read by a locked rule and re-evaluates only the rules depending on
+/// a metric whose value changed since the previous update.
+struct AchievementTracker {
+    let plan: AchievementPlan
+    /// Day each unlocked rule was achieved, keyed by rule id.
+    private(set) var unlocked: [String: Int]
+    private(set) var latest: String?
+    private var values: [Double]
+    private var isLocked: [Bool]
+
+    init(plan: AchievementPlan = .standard, unlocked: [String: Int] = [:]) {
+        self.plan = plan
+        self.unlocked = unlocked
+        latest = unlocked.max { $0.value < $1.value }?.key
+        // NaN compares unequal to everything, so the first update evaluates
+        // every locked rule.
+        values = [Double](repeating: .nan, count: plan.metrics.count)
+        isLocked = plan.rules.map { unlocked[$0.id] == nil }
+    }
+
+    @discardableResult
+    mutating func update(day: Int, measure: (AchievementPlan.Metric) -> Double) -> [String] {
+        var dirty = Set<Int>()
+        for slot in plan.metrics.indices {
+            let readers = plan.dependents[slot]
+            guard readers.contains(where: { isLocked[$0] }) else { continue }
+
+            let value = measure(plan.metrics[slot])
+            if value != values[slot] {
+                values[slot] = value
+                dirty.formUnion(readers)
+            }
+        }
+
+        var newlyUnlocked: [String] = []
+        for rule in dirty.sorted() where isLocked[rule] && plan.isSatisfied(rule, values: values) {
+            isLocked[rule] = false
+            let id = plan.rules[rule].id
+            unlocked[id] = day
+            latest = id
+            newlyUnlocked.append(id)
+        }
+        return newlyUnlocked
+    }
+}
@@ -0,0 +1,166 @@
+import Foundation
+
+/// Writes the active game to the `SaveStore` on a background queue. Worlds
+/// arrive as copy-on-write forks taken between simulated days, so they are
+/// consistent and the simulation keeps running while they are encoded;
+/// `WorldArchive.Encoder` re-encodes only the chunks written since the
+/// previous save, and only the byte ranges they changed are written to the
+/// world file. Saves run one at a time in submission order, so an older
+/// autosave never lands after a newer manual save. Every saved world is
+/// also handed to the `SnapshotStore` as a snapshot of the game.
+final class Autosaver {
+    struct Status {
+        let day: Int
+        let savedAt: Date
+        let failed: Bool
+    }
+
+    static let defaultIntervalDays = 7
+    static let intervalRange = 1...365
+
+    /// Called on the autosave queue after every background save.
+    var onSave: ((Status) -> Void)?
+
+    private let store: SaveStore
+    private let snapshots: SnapshotStore
+    private let queue = DispatchQueue(label: "com.capitalistworld.autosave", qos: .utility)
+    private let statusLock = NSLock()
+    /// Touched only on the autosave queue.
+    private let encoder = WorldArchive.Encoder()
+    /// Metadata of the tracked game as of `track`; touched only on the queue.
+    private var game: Game?
+    /// World file of the last archive `encoder` produced, once stored;
+    /// touched only on the queue.
+    private var storedWorld: SaveStore.StoredWorld?
+    private var status: Status?
+
+    init(store: SaveStore, snapshots: SnapshotStore) {
+        self.store = store
+        self.snapshots = snapshots
+    }
+
+    /// Starts autosaving `game`, or stops with `nil`. Waits for queued saves
+    /// of the previous game to finish.
+    func track(_ game: Game?) {
+        let copy = game.map(Self.copy)
+        queue.sync {
+            self.game = copy
+            encoder.reset()
+            storedWorld = nil
+        }
+        statusLock.lock()
+        status = nil
+        statusLock.unlock()
+    }
+
+    /// Queues a background save of `world`, which must not be the live
+    /// world.
+    func enqueue(_ world: World) {
+        queue.async { [weak self] in
+            guard let self, let game = self.game else { return }
+            let now = Date()
+            game.updatedAt = now
+            game.lastSavedAt = now
+
+            var failed = false
+            do {
+                try self.write(game, world: world)
+            } catch {
+                failed = true
+            }
+            self.report(Status(day: world.day, savedAt: now, failed: failed))
+        }
+    }
+
+    /// Queues a save of `game` with `world`, which must not be the live
+    /// world, after every queued autosave and returns without waiting for
+    /// it. The outcome is reported like an autosave's, through
+    /// `latestStatus` and `onSave`.
+    func save(_ game: Game, world: World) {
+        let copy = Self.copy(game)
+        queue.async { [weak self] in
+            guard let self else { return }
+            var failed = false
+            do {
+                try self.write(copy, world: world)
+            } catch {
+                failed = true
+            }
+            if self.game?.id == copy.id {
+                self.game = copy
+            }
+            self.report(Status(day: world.day, savedAt: copy.lastSavedAt, failed: failed))
+        }
+    }
+
+    /// Saves `game` after every queued autosave, blocking until it is
+    /// durable. Passing `nil` for `world` keeps the stored world.
+    func saveNow(_ game: Game, world: World?) throws {
+        let copy = Self.copy(game)
+        try queue.sync {
+            try write(copy, world: world)
+            if self.game?.id == copy.id {
+                self.game = copy
+            }
+        }
+    }
+
+    /// Blocks until every queued save has finished.
+    func waitForQueuedSaves() {
+        queue.sync {}
+    }
+
+    func latestStatus() -> Status? {
+        statusLock.lock()
+        defer { statusLock.unlock() }
+        return status
+    }
+
+    private func report(_ status: Status) {
+        statusLock.lock()
+        self.status = status
+        statusLock.unlock()
+        onSave?(status)
+    }
+
+    private func write(_ game: Game, world: World?) throws {
+        guard let world else {
+            try store.save(game)
+            return
+        }
+        let data = try encoder.encode(world)
+        game.balance = world.playerCash
+        do {
+            // The changed ranges are relative to the previous archive, so
+            // they only apply on top of the file that holds it.
+            let changes = encoder.lastChanges
+            storedWorld = try store.save(
+                game,
+                worldState: data,
+                changes: changes ?? [],
+                since: changes == nil ? nil : storedWorld
+            )
+        } catch {
+            // The file on disk may not hold the archive the next encode
+            // compares with; start over with a full write.
+            encoder.reset()
+            storedWorld = nil
+            throw error
+        }
+        snapshots.capture(game.id, day: world.day, world: data)
+    }
+
+    private static func copy(_ game: Game) -> Game {
+        Game(
+            id: game.id,
+            name: game.name,
+            playerName: game.playerName,
+            companyName: game.companyName,
+            gameStatus: game.gameStatus,
+            balance: game.balance,
+            createdAt: game.createdAt,
+            updatedAt: game.updatedAt,
+            lastSavedAt: game.lastSavedAt
+        )
+    }
+}
@@ -25,6 +25,7 @@ final class CLIApplication {
     private let promptRenderQueue = DispatchQueue(label: "com.capitalistworld.promptRender")
     private let simulationClock: SimulationClock
     private let terminalMode = TerminalMode()
+    private let commands: CommandTable
 
     private var promptSnapshot: PromptSnapshot
     private var hasRenderedPrompt = false
@@ -32,8 +33,9 @@ final class CLIApplication {
 
     init(gameManager: GameManager) {
         self.gameManager = gameManager
+        commands = CommandTable(keywords: localization.commandKeywords())
 
-        let defaultBalance = 10_000_000.0
+        let defaultBalance = ScenarioPack.shared.startingBalance
         promptSnapshot = PromptSnapshot(
             balanceLabel: localization.promptBalanceLabel(),
             balanceValue: localization.formattedBalance(gameManager.currentGame?.balance ?? defaultBalance),
@@ -44,11 +46,19 @@ final class CLIApplication {
         )
 
         simulationClock = SimulationClock(
-            referenceDate: localization.promptReferenceDate(),
+            referenceDate: ScenarioPack.shared.referenceDate,
             callbackQueue: promptRenderQueue
         )
 
         simulationClock.delegate = self
+        gameManager.forecastEngine.onProgress = { [weak self] _ in
+            guard let self else { return }
+            self.renderPrompt(for: self.simulationClock.currentDate())
+        }
+        gameManager.onAutosave = { [weak self] _ in
+            guard let self else { return }
+            self.renderPrompt(for: self.simulationClock.currentDate())
+        }
     }
 
     func run() {
@@ -56,6 +66,15 @@ final class CLIApplication {
 
         print(localization.appReadyMessage())
 
+        switch gameManager.coreDataImport {
+        case .imported(let count, let source)?:
+            print(localization.coreDataImportedMessage(count: count, from: source))
+        case .failed(let source, let reason)?:
+            print(localization.coreDataImportFailedMessage(source, reason: reason))
+        case nil:
+            break
+        }
+
         if let game = gameManager.currentGame {
             print(localization.previousGameLoadedMessage(gameManager.statusSummary(for: game)))
         }
@@ -68,6 +87,9 @@ final class CLIApplication {
             }
 
             if handleCommand(line) == false { break }
+            if let failure = gameManager.takeWorldLoadFailure() {
+                print(failure.localizedDescription)
+            }
         }
     }
 
@@ -86,7 +108,7 @@ final class CLIApplication {
         guard let keyword = components.first else { return true }
 
         let arguments = components.count > 1 ? String(components[1]).trimmingCharacters(in: .whitespacesAndNewlines) : nil
-        guard let identifier = commandIdentifier(for: String(keyword).lowercased()) else {
+        guard let identifier = commands.identifier(for: keyword) else {
             print(localization.unknownCommandMessage(trimmed))
             return true
         }
@@ -99,11 +121,6 @@ final class CLIApplication {
             }
             return true
         case .start:
-            if let active = gameManager.currentGame, active.gameStatus == .active {
-                print(localization.activeGameInProgressMessage(active.name))
-                return true
-            }
-
             let playerName = readRequiredInput(prompt: localization.playerNamePrompt())
             let companyName = readRequiredInput(prompt: localization.companyNamePrompt())
 
@@ -117,7 +134,7 @@ final class CLIApplication {
         case .save:
             do {
                 let game = try gameManager.saveCurrentGame()
-                print(localization.gameSavedMessage(gameManager.statusSummary(for: game)))
+                print(localization.gameSavingMessage(gameManager.statusSummary(for: game)))
             } catch {
                 print(error.localizedDescription)
             }
@@ -161,6 +178,56 @@ final class CLIApplication {
                 print(error.localizedDescription)
             }
             return true
+        case .exportGame:
+            guard let arguments, arguments.isEmpty == false else {
+                print(localization.exportUsageMessage())
+                return true
+            }
+
+            do {
+                let file = URL(fileURLWithPath: arguments)
+                let game = try gameManager.exportCurrentGame(to: file)
+                print(localization.exportSuccessMessage(game.name, file: file))
+            } catch {
+                print(error.localizedDescription)
+            }
+            return true
+        case .importGame:
+            guard let arguments, arguments.isEmpty == false else {
+                print(localization.importUsageMessage())
+                return true
+            }
+
+            do {
+                let file = URL(fileURLWithPath: arguments)
+                let games = try gameManager.importGames(from: file)
+                if games.count == 1, let game = games.first {
+                    print(localization.importSuccessMessage(gameManager.statusSummary(for: game), id: game.id))
+                } else {
+                    print(localization.importArchiveSuccessMessage(count: games.count, file: file))
+                }
+            } catch {
+                print(error.localizedDescription)
+            }
+            return true
+        case .maintain:
+            let file = arguments.flatMap { $0.isEmpty ? nil : URL(fileURLWithPath: $0) }
+            do {
+                let report = try gameManager.archiveAbandonedGames(to: file) { archived, total in
+                    print(localization.maintenanceProgressMessage(archived: archived, total: total))
+                }
+                if report.archived == 0 {
+                    print(localization.maintenanceEmptyMessage())
+                } else {
+                    print(localization.maintenanceDoneMessage(report))
+                }
+                if report.withoutWorld.isEmpty == false {
+                    print(localization.maintenanceWithoutWorldMessage(report.withoutWorld))
+                }
+            } catch {
+                print(error.localizedDescription)
+            }
+            return true
         case .speed:
             guard let arguments, arguments.isEmpty == false else {
                 let example = localization.speedValueString(for: SimulationClock.Speed.x2.rawValue)
@@ -178,6 +245,77 @@ final class CLIApplication {
             let speedValue = localization.speedValueString(for: newSpeed.rawValue)
             print(localization.speedUpdatedMessage(speedValue))
             return true
+        case .acquire:
+            guard let arguments, arguments.isEmpty == false else {
+                printAcquisitionTargets()
+                return true
+            }
+
+            do {
+                let quote = try gameManager.acquireCompany(matching: arguments)
+                print(localization.acquisitionSuccessMessage(name: quote.name, price: quote.price))
+            } catch {
+                print(error.localizedDescription)
+            }
+            return true
+        case .inventory:
+            printInventory()
+            return true
+        case .order, .sell:
+            guard let arguments, arguments.isEmpty == false else {
+                print(localization.inventoryUsageMessage())
+                return true
+            }
+
+            do {
+                if identifier == .order {
+                    let receipt = try gameManager.purchaseGoods(arguments)
+                    print(localization.purchaseSuccessMessage(receipt))
+                } else {
+                    let receipt = try gameManager.sellGoods(arguments)
+                    print(localization.saleSuccessMessage(receipt))
+                }
+            } catch {
+                print(error.localizedDescription)
+            }
+            return true
+        case .forecast:
+            guard let arguments, arguments.isEmpty == false else {
+                printForecast()
+                return true
+            }
+
+            do {
+                let run = try gameManager.startForecast(arguments)
+                print(localization.forecastStartedMessage(years: run.years, paths: run.paths))
+            } catch {
+                print(error.localizedDescription)
+            }
+            return true
+        case .campaign:
+            handleCampaign(arguments: arguments)
+            return true
+        case .achievements:
+            printAchievements()
+            return true
+        case .history:
+            printHistory()
+            return true
+        case .snapshots:
+            handleSnapshots(arguments: arguments)
+            return true
+        case .profile:
+            handleProfile(arguments: arguments)
+            return true
+        case .autosave:
+            handleAutosave(arguments: arguments)
+            return true
+        case .sandbox:
+            handleSandbox(arguments: arguments)
+            return true
+        case .scenario:
+            handleScenario(arguments: arguments)
+            return true
         case .exit:
             if let game = gameManager.currentGame {
                 print(localization.exitWarningMessage(gameManager.statusSummary(for: game)))
@@ -187,14 +325,257 @@ final class CLIApplication {
         }
     }
 
-    private func commandIdentifier(for keyword: String) -> CommandIdentifier? {
-        for identifier in CommandIdentifier.allCases {
-            let aliases = localization.aliases(for: identifier)
-            if aliases.contains(keyword) {
-                return identifier
+    private func printAcquisitionTargets() {
+        do {
+            let quotes = try gameManager.acquisitionQuotes()
+            guard quotes.isEmpty == false else {
+                print(localization.acquisitionEmptyMessage())
+                return
+            }
+
+            let engine = gameManager.simulation.valuationEngine
+            print(localization.acquisitionHeaderMessage(
+                discountRate: engine.discountRate,
+                sensitivityBasisPoints: engine.sensitivityBasisPoints
+            ))
+            for (index, quote) in quotes.enumerated() {
+                print(localization.acquisitionEntryMessage(
+                    index: index + 1,
+                    name: quote.name,
+                    price: quote.price,
+                    lowPrice: quote.lowPrice,
+                    highPrice: quote.highPrice
+                ))
             }
+            print(localization.acquisitionUsageMessage())
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func printInventory() {
+        do {
+            let lines = try gameManager.inventoryReport()
+            print(localization.inventoryHeaderMessage(method: gameManager.inventoryCostingMethod))
+            lines.forEach { print(localization.inventoryEntryMessage($0)) }
+            print(localization.inventoryUsageMessage())
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func printForecast() {
+        let engine = gameManager.forecastEngine
+        if let report = engine.latestReport() {
+            print(localization.forecastHeaderMessage(report))
+            for year in 0..<report.years {
+                print(localization.forecastEntryMessage(
+                    year: year + 1,
+                    balance: report.balanceBands[year],
+                    profits: report.profitBands[year]
+                ))
+            }
+        } else if let progress = engine.latestProgress() {
+            print(localization.forecastRunningMessage(progress))
+        } else {
+            print(localization.forecastNoneMessage())
+        }
+    }
+
+    private func handleProfile(arguments: String?) {
+        let simulation = gameManager.simulation
+        let components = (arguments ?? "").lowercased().split(separator: " ", omittingEmptySubsequences: true).map(String.init)
+
+        guard let subcommand = components.first else {
+            let speed = SimulationClock.Speed(rawValue: simulationClock.currentSpeedRawValue()) ?? .x0
+            let report = simulation.profileReport(at: speed)
+            print(localization.profileHeaderMessage(
+                speed: speed.rawValue,
+                budgetNanoseconds: report.budgetNanoseconds,
+                budgetShare: report.budgetShare
+            ))
+
+            let measured = report.statistics.filter { $0.samples > 0 }
+            guard measured.isEmpty == false else {
+                print(localization.profileEmptyMessage())
+                return
+            }
+            for statistics in measured {
+                let overBudget = report.budgetNanoseconds.map { Double(statistics.p99Nanoseconds) > $0 } ?? false
+                print(localization.profileEntryMessage(statistics, overBudget: overBudget))
+            }
+            return
+        }
+
+        if localization.subcommandAliases("profile.reset.aliases").contains(subcommand), components.count == 1 {
+            simulation.resetProfile()
+            print(localization.profileResetMessage())
+        } else if localization.subcommandAliases("profile.budget.aliases").contains(subcommand),
+                  components.count == 2,
+                  let percent = Double(components[1].replacingOccurrences(of: ",", with: ".")),
+                  SystemProfiler.budgetShareRange.contains(percent / 100) {
+            simulation.setProfileBudgetShare(percent / 100)
+            print(localization.profileBudgetUpdatedMessage(percent / 100))
+        } else {
+            print(localization.profileUsageMessage())
+        }
+    }
+
+    private func handleAutosave(arguments: String?) {
+        let argument = (arguments ?? "").lowercased()
+        guard argument.isEmpty == false else {
+            print(localization.autosaveStatusMessage(
+                intervalDays: gameManager.autosaveIntervalDays,
+                latest: gameManager.latestAutosave()
+            ))
+            return
+        }
+
+        if localization.subcommandAliases("autosave.off.aliases").contains(argument) {
+            gameManager.setAutosaveInterval(nil)
+        } else if let days = Int(argument), Autosaver.intervalRange.contains(days) {
+            gameManager.setAutosaveInterval(days)
+        } else {
+            print(localization.autosaveUsageMessage())
+            return
+        }
+        print(localization.autosaveUpdatedMessage(intervalDays: gameManager.autosaveIntervalDays))
+    }
+
+    private func printAchievements() {
+        do {
+            let lines = try gameManager.achievementReport()
+            print(localization.achievementsHeaderMessage(unlocked: lines.filter { $0.unlockedDay != nil }.count, total: lines.count))
+            lines.forEach { print(localization.achievementEntryMessage($0)) }
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func printHistory() {
+        do {
+            let months = try gameManager.monthlyHistory()
+            guard months.isEmpty == false else {
+                print(localization.historyEmptyMessage())
+                return
+            }
+
+            print(localization.historyHeaderMessage(months: months.count))
+            months.forEach { print(localization.historyEntryMessage($0)) }
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func handleSnapshots(arguments: String?) {
+        let components = (arguments ?? "").split(separator: " ", omittingEmptySubsequences: true).map(String.init)
+
+        do {
+            guard let subcommand = components.first?.lowercased() else {
+                let snapshots = try gameManager.snapshotReport()
+                guard snapshots.isEmpty == false else {
+                    print(localization.snapshotsEmptyMessage())
+                    return
+                }
+
+                print(localization.snapshotsHeaderMessage(snapshots))
+                for (index, snapshot) in snapshots.enumerated() {
+                    print(localization.snapshotEntryMessage(position: index + 1, snapshot: snapshot))
+                }
+                print(localization.snapshotsUsageMessage())
+                return
+            }
+
+            guard localization.subcommandAliases("snapshots.restore.aliases").contains(subcommand),
+                  components.count == 2 else {
+                print(localization.snapshotsUsageMessage())
+                return
+            }
+            let snapshot = try gameManager.restoreSnapshot(components[1])
+            print(localization.snapshotRestoredMessage(snapshot))
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func handleCampaign(arguments: String?) {
+        do {
+            guard let arguments, arguments.isEmpty == false else {
+                let report = try gameManager.marketingReport()
+                print(localization.marketingHeaderMessage())
+                report.regions.forEach { print(localization.marketingRegionMessage($0)) }
+                if report.campaigns.isEmpty {
+                    print(localization.marketingNoCampaignsMessage())
+                }
+                for campaign in report.campaigns {
+                    print(localization.marketingCampaignMessage(campaign, regionName: report.regionNames[Int(campaign.region)]))
+                }
+                print(localization.campaignUsageMessage())
+                return
+            }
+
+            let components = arguments.split(separator: " ", maxSplits: 1, omittingEmptySubsequences: true).map(String.init)
+            if let subcommand = components.first?.lowercased(),
+               localization.subcommandAliases("campaign.stop.aliases").contains(subcommand) {
+                guard components.count == 2 else {
+                    print(localization.campaignUsageMessage())
+                    return
+                }
+                try gameManager.stopCampaign(components[1])
+                print(localization.campaignStoppedMessage(components[1]))
+                return
+            }
+
+            let launched = try gameManager.launchCampaign(arguments)
+            print(localization.campaignLaunchedMessage(launched.campaign, regionName: launched.regionName))
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func handleSandbox(arguments: String?) {
+        let subcommand = arguments?.lowercased() ?? ""
+
+        do {
+            if subcommand.isEmpty {
+                try gameManager.beginSandbox()
+                print(localization.sandboxStartedMessage())
+            } else if localization.subcommandAliases("sandbox.merge.aliases").contains(subcommand) {
+                try gameManager.endSandbox(keepChanges: true)
+                print(localization.sandboxMergedMessage())
+            } else if localization.subcommandAliases("sandbox.discard.aliases").contains(subcommand) {
+                try gameManager.endSandbox(keepChanges: false)
+                print(localization.sandboxDiscardedMessage())
+            } else {
+                print(localization.sandboxUsageMessage())
+            }
+        } catch {
+            print(error.localizedDescription)
+        }
+    }
+
+    private func handleScenario(arguments: String?) {
+        guard let arguments, arguments.isEmpty == false else {
+            print(localization.scenarioSummaryMessage(ScenarioPack.shared))
+            return
+        }
+
+        let components = arguments.split(separator: " ", omittingEmptySubsequences: true).map(String.init)
+        guard let subcommand = components.first?.lowercased(),
+              localization.subcommandAliases("scenario.compile.aliases").contains(subcommand),
+              components.count == 2 || components.count == 3 else {
+            print(localization.scenarioUsageMessage())
+            return
+        }
+
+        let source = URL(fileURLWithPath: components[1])
+        let pack = components.count == 3 ? URL(fileURLWithPath: components[2]) : ScenarioPack.installedPackURL()
+        do {
+            try ScenarioPack.compile(source: source, to: pack)
+            print(localization.scenarioCompiledMessage(pack))
+        } catch {
+            print(error.localizedDescription)
         }
-        return nil
     }
 
     private func readRequiredInput(prompt: String) -> String {
@@ -233,11 +614,13 @@ final class CLIApplication {
     private func printPrompt() {
         ResumePromptUpdates()
 
-        let promptText = "capitalist> "
-        let defaultBalance = 10_000_000.0
-        let balanceValue = gameManager.currentGame?.balance ?? defaultBalance
+        let isSandbox = gameManager.simulation.currentSnapshot()?.isSandbox ?? false
+        let promptText = isSandbox ? "capitalist [\(localization.promptSandboxTag())]> " : "capitalist> "
+        let defaultBalance = ScenarioPack.shared.startingBalance
+        let balanceValue = gameManager.simulation.currentSnapshot()?.balance ?? gameManager.currentGame?.balance ?? defaultBalance
         let balanceText = localization.formattedBalance(balanceValue)
-        let profitsText = localization.formattedBalance(0)
+        let profitsValue = gameManager.simulation.currentSnapshot()?.profits ?? 0
+        let profitsText = localization.formattedBalance(profitsValue)
 
         let balanceLabel = localization.promptBalanceLabel()
         let profitsLabel = localization.promptProfitsLabel()
@@ -264,17 +647,38 @@ final class CLIApplication {
         let work = { [weak self] in
             guard let self else { return }
 
+            let snapshot = self.gameManager.simulation.currentSnapshot()
+            if let snapshot {
+                self.promptSnapshot.balanceValue = self.localization.formattedBalance(snapshot.balance)
+                self.promptSnapshot.profitsValue = self.localization.formattedBalance(snapshot.profits)
+            }
+
             let dateText = self.localization.promptFormattedDate(from: date)
             let speedValue = self.localization.speedValueString(for: self.simulationClock.currentSpeedRawValue())
             let separator = String(repeating: " ", count: 4)
 
-            let columns = [
+            var columns = [
                 (self.promptSnapshot.balanceLabel, self.promptSnapshot.balanceValue),
                 (self.promptSnapshot.profitsLabel, self.promptSnapshot.profitsValue),
                 (self.promptSnapshot.dateLabel, dateText),
                 (self.promptSnapshot.speedLabel, speedValue)
             ]
 
+            if let progress = self.gameManager.forecastEngine.latestProgress() {
+                columns.append((self.localization.promptForecastLabel(), self.localization.promptForecastValue(progress)))
+            }
+
+            if let autosave = self.gameManager.latestAutosave() {
+                columns.append((self.localization.promptAutosaveLabel(), self.localization.promptAutosaveValue(autosave)))
+            }
+
+            if let snapshot, let latest = snapshot.latestAchievement {
+                columns.append((
+                    self.localization.promptAchievementsLabel(),
+                    self.localization.promptAchievementsValue(unlocked: snapshot.achievementsUnlocked, latest: latest)
+                ))
+            }
+
             let statusLine = columns
                 .map { "\($0.0): \($0.1)" }
                 .joined(separator: separator)
@@ -309,6 +713,7 @@ final class CLIApplication {
 
 extension CLIApplication: SimulationClockDelegate {
     func simulationClock(_ clock: SimulationClock, didAdvanceTo date: Date) {
+        gameManager.simulation.advance(to: date)
         renderPrompt(for: date)
     }
 }
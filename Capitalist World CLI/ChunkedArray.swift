@@ -0,0 +1,107 @@
+import Foundation
+
+/// Array stored as fixed-size chunks with two-level copy-on-write. Copying
+/// the value is O(1); the first write after a copy duplicates the chunk table
+/// (one reference per chunk) and the touched chunk only, so a forked world
+/// pays memory just for the chunks it modifies.
+struct ChunkedArray<Element>: RandomAccessCollection, MutableCollection {
+    typealias Index = Int
+    typealias Indices = Range<Int>
+
+    private static var chunkShift: Int { 12 }
+    private static var chunkSize: Int { 1 << chunkShift }
+    private static var chunkMask: Int { chunkSize - 1 }
+
+    private var chunks: [[Element]] = []
+    private(set) var count = 0
+
+    init() {}
+
+    init<S: Sequence>(_ elements: S) where S.Element == Element {
+        elements.forEach { append($0) }
+    }
+
+    /// Slices `elements` into chunks with one bulk copy per chunk.
+    init(_ elements: [Element]) {
+        chunks = stride(from: 0, to: elements.count, by: Self.chunkSize).map { start in
+            var chunk: [Element] = []
+            chunk.reserveCapacity(Self.chunkSize)
+            chunk.append(contentsOf: elements[start..<min(start + Self.chunkSize, elements.count)])
+            return chunk
+        }
+        count = elements.count
+    }
+
+    init(repeating element: Element, count: Int) {
+        self.init(repeatElement(element, count: count))
+    }
+
+    var startIndex: Int { 0 }
+    var endIndex: Int { count }
+
+    subscript(position: Int) -> Element {
+        get {
+            precondition(position >= 0 && position < count, "ChunkedArray index out of range")
+            return chunks[position >> Self.chunkShift][position & Self.chunkMask]
+        }
+        set {
+            precondition(position >= 0 && position < count, "ChunkedArray index out of range")
+            chunks[position >> Self.chunkShift][position & Self.chunkMask] = newValue
+        }
+    }
+
+    mutating func append(_ element: Element) {
+        if count & Self.chunkMask == 0 {
+            var chunk: [Element] = []
+            chunk.reserveCapacity(Self.chunkSize)
+            chunks.append(chunk)
+        }
+        chunks[chunks.count - 1].append(element)
+        count += 1
+    }
+
+    /// Number of storage chunks. Arrays of equal count share chunk
+    /// boundaries, so parallel arrays can be swept chunk by chunk.
+    var chunkCount: Int { chunks.count }
+
+    /// Calls `body` with the contiguous storage of chunk `chunk` and the
+    /// index of its first element.
+    func withUnsafeChunk<R>(_ chunk: Int, _ body: (UnsafeBufferPointer<Element>, Int) throws -> R) rethrows -> R {
+        try chunks[chunk].withUnsafeBufferPointer { try body($0, chunk << Self.chunkShift) }
+    }
+
+    /// Whether chunk `chunk` is still the very storage `other` holds, i.e.
+    /// neither side has written to it since one was copied from the other.
+    /// Only meaningful while `other` is alive, which keeps the storage from
+    /// being freed and reused.
+    func sharesChunk(_ chunk: Int, with other: ChunkedArray) -> Bool {
+        guard chunk < chunks.count, chunk < other.chunks.count else { return false }
+        return chunks[chunk].withUnsafeBufferPointer { mine in
+            other.chunks[chunk].withUnsafeBufferPointer { theirs in
+                mine.baseAddress == theirs.baseAddress && mine.count == theirs.count
+            }
+        }
+    }
+
+    /// Removes the elements at `offsets` (ascending), keeping the order of
+    /// the rest. Rebuilds every chunk from the first removed offset on.
+    mutating func remove(atSortedOffsets offsets: [Int]) {
+        guard let first = offsets.first else { return }
+
+        // Chunks before the first removal are unchanged and stay shared.
+        let untouched = first >> Self.chunkShift
+        var kept = ChunkedArray()
+        kept.chunks = Array(chunks[0..<untouched])
+        kept.count = untouched << Self.chunkShift
+
+        var cursor = 0
+        for index in kept.count..<count {
+            if cursor < offsets.count, offsets[cursor] == index {
+                cursor += 1
+                continue
+            }
+            kept.append(self[index])
+        }
+        self = kept
+    }
+}
@@ -0,0 +1,180 @@
+import Foundation
+
+/// Command keywords of every language in a perfect hash built once at
+/// startup: a keyword's hash picks a bucket, the bucket's displacement picks
+/// the one slot the keyword can be in, and a byte compare confirms it.
+/// Keys are stored lowercased and precomposed, and ASCII input is folded
+/// while it is hashed, so resolving a typed command allocates nothing.
+struct CommandTable {
+    private struct Entry {
+        var start: Int32 = 0
+        var length: Int32 = 0
+        /// `nil` for a free slot.
+        var identifier: CommandIdentifier?
+    }
+
+    /// Keyword bytes of every entry, back to back.
+    private let keys: [UInt8]
+    private let entries: [Entry]
+    /// Per bucket, the displacement that moved its keywords to free slots.
+    private let displacements: [UInt32]
+    private let seed: UInt64
+    private let slotMask: UInt32
+    private let bucketShift: UInt64
+
+    /// Displacements tried per bucket before the build starts over with
+    /// another seed.
+    private static let displacementLimit: UInt32 = 1 << 16
+
+    /// Table of `keywords`. A keyword listed twice keeps its first command.
+    init(keywords: [(keyword: String, identifier: CommandIdentifier)]) {
+        var seen = Set<String>()
+        var unique: [(bytes: [UInt8], identifier: CommandIdentifier)] = []
+        for (keyword, identifier) in keywords {
+            let normalized = keyword.lowercased().precomposedStringWithCanonicalMapping
+            guard normalized.isEmpty == false, seen.insert(normalized).inserted else { continue }
+            unique.append((Array(normalized.utf8), identifier))
+        }
+
+        // Half-empty slots and about two keywords per bucket keep the
+        // displacement search short for a few hundred keywords.
+        var slotCount = 2
+        while slotCount < unique.count * 2 {
+            slotCount <<= 1
+        }
+        let bucketCount = slotCount / 4 > 1 ? slotCount / 4 : 2
+        let slotMask = UInt32(slotCount - 1)
+        let bucketShift = UInt64(64 - bucketCount.trailingZeroBitCount)
+        let bytes = unique.map(\.bytes)
+
+        var seed: UInt64 = 0
+        var placement = Self.place(bytes, seed: seed, slotMask: slotMask, bucketShift: bucketShift, bucketCount: bucketCount)
+        while placement == nil {
+            seed += 1
+            placement = Self.place(bytes, seed: seed, slotMask: slotMask, bucketShift: bucketShift, bucketCount: bucketCount)
+        }
+        let (slots, displacements) = placement!
+        self.seed = seed
+        self.slotMask = slotMask
+        self.bucketShift = bucketShift
+        self.displacements = displacements
+
+        var keys: [UInt8] = []
+        var entries = [Entry](repeating: Entry(), count: slotCount)
+        for (slot, index) in slots.enumerated() where index >= 0 {
+            let keyword = unique[Int(index)]
+            entries[slot] = Entry(start: Int32(keys.count), length: Int32(keyword.bytes.count), identifier: keyword.identifier)
+            keys.append(contentsOf: keyword.bytes)
+        }
+        self.keys = keys
+        self.entries = entries
+    }
+
+    /// Command typed as `keyword`, in any case and any catalog language.
+    func identifier(for keyword: Substring) -> CommandIdentifier? {
+        if let found = keyword.utf8.withContiguousStorageIfAvailable({ find($0) }),
+           found.identifier != nil || found.isASCII {
+            return found.identifier
+        }
+        // Non-ASCII input may need Unicode case folding or composition that
+        // byte folding cannot do; keywords like that are rare enough to
+        // lowercase the slow way.
+        var normalized = keyword.lowercased().precomposedStringWithCanonicalMapping
+        return normalized.withUTF8 { find($0).identifier }
+    }
+
+    private func find(_ bytes: UnsafeBufferPointer<UInt8>) -> (identifier: CommandIdentifier?, isASCII: Bool) {
+        var high: UInt8 = 0
+        var hash = Self.basis ^ seed
+        for byte in bytes {
+            high |= byte
+            hash = (hash ^ UInt64(Self.fold(byte))) &* Self.prime
+        }
+        let isASCII = high < 0x80
+        hash = Self.mix(hash)
+
+        let displacement = displacements[Int(hash >> bucketShift)]
+        let entry = entries[Self.slot(hash, displacement, slotMask)]
+        guard let identifier = entry.identifier, Int(entry.length) == bytes.count else {
+            return (nil, isASCII)
+        }
+        let start = Int(entry.start)
+        for index in 0..<bytes.count where Self.fold(bytes[index]) != keys[start + index] {
+            return (nil, isASCII)
+        }
+        return (identifier, isASCII)
+    }
+
+    /// Key index per slot, -1 for free ones, and the displacement of each
+    /// bucket; `nil` if some bucket found no free slots under `seed`.
+    private static func place(
+        _ keys: [[UInt8]],
+        seed: UInt64,
+        slotMask: UInt32,
+        bucketShift: UInt64,
+        bucketCount: Int
+    ) -> (slots: [Int32], displacements: [UInt32])? {
+        let hashes = keys.map { key -> UInt64 in
+            var hash = basis ^ seed
+            for byte in key {
+                hash = (hash ^ UInt64(byte)) &* prime
+            }
+            return mix(hash)
+        }
+        var buckets = [[Int]](repeating: [], count: bucketCount)
+        for (index, hash) in hashes.enumerated() {
+            buckets[Int(hash >> bucketShift)].append(index)
+        }
+
+        var slots = [Int32](repeating: -1, count: Int(slotMask) + 1)
+        var displacements = [UInt32](repeating: 0, count: bucketCount)
+        // Fullest buckets first, while most slots are still free.
+        for bucket in buckets.indices.sorted(by: { buckets[$0].count > buckets[$1].count }) {
+            let members = buckets[bucket]
+            guard members.isEmpty == false else { break }
+
+            var displacement: UInt32 = 0
+            var taken: [Int] = []
+            search: while true {
+                guard displacement < displacementLimit else { return nil }
+                taken.removeAll(keepingCapacity: true)
+                for index in members {
+                    let candidate = slot(hashes[index], displacement, slotMask)
+                    if slots[candidate] >= 0 || taken.contains(candidate) {
+                        displacement += 1
+                        continue search
+                    }
+                    taken.append(candidate)
+                }
+                break
+            }
+            for (index, candidate) in zip(members, taken) {
+                slots[candidate] = Int32(index)
+            }
+            displacements[bucket] = displacement
+        }
+        return (slots, displacements)
+    }
+
+    // FNV-1a, finished with a multiply so the bucket bits at the top and the
+    // slot bits at the bottom both depend on every byte.
+    private static let basis: UInt64 = 0xcbf2_9ce4_8422_2325
+    private static let prime: UInt64 = 0x0000_0100_0000_01b3
+
+    @inline(__always)
+    private static func mix(_ hash: UInt64) -> UInt64 {
+        (hash ^ (hash >> 32)) &* 0x9e37_79b9_7f4a_7c15
+    }
+
+    @inline(__always)
+    private static func slot(_ hash: UInt64, _ displacement: UInt32, _ mask: UInt32) -> Int {
+        let base = UInt32(truncatingIfNeeded: hash)
+        let step = UInt32(truncatingIfNeeded: hash >> 32) | 1
+        return Int((base &+ displacement &* step) & mask)
+    }
+
+    @inline(__always)
+    private static func fold(_ byte: UInt8) -> UInt8 {
+        byte &- 0x41 < 26 ? byte | 0x20 : byte
+    }
+}
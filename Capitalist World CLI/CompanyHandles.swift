@@ -0,0 +1,101 @@
+import Foundation
+
+/// Stable reference to a company. Company arrays are compacted when firms
+/// are liquidated, so dense indices move; an ID keeps pointing at the same
+/// company until it is gone, after which its generation no longer matches.
+struct CompanyID: Hashable, Codable {
+    let slot: Int32
+    let generation: UInt32
+}
+
+/// Generation-checked handle table mapping `CompanyID`s to dense indices.
+struct CompanyHandleTable {
+    struct State: Codable {
+        var denseSlots: [Int32]
+        var generations: [UInt32]
+    }
+
+    /// Dense index → slot.
+    private var denseSlots: [Int32]
+    /// Slot → dense index, or -1 for a free slot.
+    private var slotIndices: [Int32]
+    private var generations: [UInt32]
+    private var freeSlots: [Int32]
+
+    /// Identity mapping for `count` companies.
+    init(count: Int) {
+        denseSlots = (0..<count).map { Int32($0) }
+        slotIndices = denseSlots
+        generations = [UInt32](repeating: 0, count: count)
+        freeSlots = []
+    }
+
+    init(state: State) {
+        denseSlots = state.denseSlots
+        generations = state.generations
+        slotIndices = [Int32](repeating: -1, count: state.generations.count)
+        for (index, slot) in state.denseSlots.enumerated() {
+            slotIndices[Int(slot)] = Int32(index)
+        }
+        freeSlots = slotIndices.indices.filter { slotIndices[$0] == -1 }.map { Int32($0) }
+    }
+
+    var state: State {
+        State(denseSlots: denseSlots, generations: generations)
+    }
+
+    func id(of index: Int) -> CompanyID {
+        let slot = denseSlots[index]
+        return CompanyID(slot: slot, generation: generations[Int(slot)])
+    }
+
+    /// Current dense index of `id`, or `nil` once that company is gone.
+    func index(of id: CompanyID) -> Int? {
+        let slot = Int(id.slot)
+        guard slotIndices.indices.contains(slot),
+              generations[slot] == id.generation,
+              slotIndices[slot] >= 0 else {
+            return nil
+        }
+        return Int(slotIndices[slot])
+    }
+
+    /// Registers a company appended at the end of the dense arrays.
+    @discardableResult
+    mutating func append() -> CompanyID {
+        let slot: Int32
+        if let reused = freeSlots.popLast() {
+            slot = reused
+        } else {
+            slot = Int32(generations.count)
+            generations.append(0)
+            slotIndices.append(-1)
+        }
+        slotIndices[Int(slot)] = Int32(denseSlots.count)
+        denseSlots.append(slot)
+        return CompanyID(slot: slot, generation: generations[Int(slot)])
+    }
+
+    /// Mirrors an order-preserving compaction of the dense arrays: frees the
+    /// slots of `removed` (ascending dense indices) and renumbers the rest.
+    mutating func compact(removing removed: [Int]) {
+        var next = 0
+        var cursor = 0
+        var kept: [Int32] = []
+        kept.reserveCapacity(denseSlots.count - removed.count)
+
+        for (index, slot) in denseSlots.enumerated() {
+            if cursor < removed.count, removed[cursor] == index {
+                cursor += 1
+                generations[Int(slot)] &+= 1
+                slotIndices[Int(slot)] = -1
+                freeSlots.append(slot)
+                continue
+            }
+            slotIndices[Int(slot)] = Int32(next)
+            kept.append(slot)
+            next += 1
+        }
+        denseSlots = kept
+    }
+}
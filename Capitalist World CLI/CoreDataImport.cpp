@@ -0,0 +1,147 @@
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" int64_t SaveStorePut(void *handle,
+                                const uint8_t *id,
+                                int32_t status,
+                                double balance,
+                                double createdAt,
+                                double updatedAt,
+                                double lastSavedAt,
+                                const char *name,
+                                int32_t nameLength,
+                                const char *playerName,
+                                int32_t playerNameLength,
+                                const char *companyName,
+                                int32_t companyNameLength,
+                                const uint8_t *world,
+                                int64_t worldLength);
+extern "C" int32_t SaveStoreCommit(void *handle, int64_t sequence);
+extern "C" void *SaveStoreListingOpen(void *handle);
+extern "C" void SaveStoreListingClose(void *listing);
+extern "C" int32_t SaveStoreListingFind(void *listing, const uint8_t *id);
+
+namespace {
+// Core Data keeps dates as seconds since 2001-01-01; the store uses the
+// Unix epoch.
+constexpr double kReferenceDateOffset = 978307200;
+constexpr int kIDBytes = 16;
+
+// Table and columns Core Data derived from the `Game` entity of the first
+// releases: the entity and attribute names, upper-cased and prefixed with
+// Z. UUIDs are 16-byte blobs.
+constexpr const char *kSelectGames = R"sql(
+SELECT ZID, ZNAME, ZPLAYERNAME, ZCOMPANYNAME, ZSTATUS, ZBALANCE, ZCREATEDAT, ZUPDATEDAT, ZLASTSAVEDAT
+FROM ZGAME
+)sql";
+
+void setError(char *buffer, int32_t capacity, const std::string &message) {
+    if (buffer == nullptr || capacity <= 0) {
+        return;
+    }
+    std::snprintf(buffer, static_cast<size_t>(capacity), "%s", message.c_str());
+}
+
+struct LegacyGame {
+    uint8_t id[kIDBytes];
+    int32_t status;
+    double balance;
+    double createdAt;
+    double updatedAt;
+    double lastSavedAt;
+    std::string name;
+    std::string playerName;
+    std::string companyName;
+};
+
+// Text of a column that may be NULL.
+std::string text(sqlite3_stmt *statement, int column) {
+    const auto *value = reinterpret_cast<const char *>(sqlite3_column_text(statement, column));
+    if (value == nullptr) {
+        return std::string();
+    }
+    return std::string(value, static_cast<size_t>(sqlite3_column_bytes(statement, column)));
+}
+
+// Reads every game of the Core Data store at `path`. Rows without a valid
+// id are skipped.
+bool readGames(const char *path, std::vector<LegacyGame> &games, std::string &error) {
+    sqlite3 *db = nullptr;
+    if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        error = db != nullptr ? sqlite3_errmsg(db) : "out of memory";
+        sqlite3_close(db);
+        return false;
+    }
+    sqlite3_stmt *select = nullptr;
+    int result = sqlite3_prepare_v2(db, kSelectGames, -1, &select, nullptr);
+    if (result == SQLITE_OK) {
+        while ((result = sqlite3_step(select)) == SQLITE_ROW) {
+            const void *id = sqlite3_column_blob(select, 0);
+            if (id == nullptr || sqlite3_column_bytes(select, 0) != kIDBytes) {
+                continue;
+            }
+            LegacyGame game;
+            std::memcpy(game.id, id, kIDBytes);
+            game.status = text(select, 4) == "abandoned" ? 1 : 0;
+            game.balance = sqlite3_column_double(select, 5);
+            game.createdAt = sqlite3_column_double(select, 6) + kReferenceDateOffset;
+            game.updatedAt = sqlite3_column_double(select, 7) + kReferenceDateOffset;
+            game.lastSavedAt = sqlite3_column_double(select, 8) + kReferenceDateOffset;
+            game.name = text(select, 1);
+            game.playerName = text(select, 2);
+            game.companyName = text(select, 3);
+            games.push_back(std::move(game));
+        }
+    }
+    if (result != SQLITE_DONE) {
+        error = sqlite3_errmsg(db);
+    }
+    sqlite3_finalize(select);
+    sqlite3_close(db);
+    return result == SQLITE_DONE;
+}
+}  // namespace
+
+// Copies the games of the Core Data store at `path`, which the first
+// releases saved to, into the store and commits them together. Games keep
+// their ids and have no world; one is generated when they are played.
+// Games the store already has are skipped, so an import that stopped after
+// its commit can run again without touching them. The Core Data store is
+// only read. Returns how many games were added, or -1 with `errorBuffer`
+// set and nothing added.
+extern "C" int32_t SaveStoreImportCoreData(void *handle, const char *path, char *errorBuffer, int32_t errorCapacity) {
+    // Every row is read before the first put: a put is journaled by the
+    // next commit of anyone, so a half-read store must add nothing.
+    std::vector<LegacyGame> games;
+    std::string error;
+    if (!readGames(path, games, error)) {
+        setError(errorBuffer, errorCapacity, error);
+        return -1;
+    }
+
+    void *listing = SaveStoreListingOpen(handle);
+    int64_t sequence = -1;
+    int32_t imported = 0;
+    for (const LegacyGame &game : games) {
+        if (SaveStoreListingFind(listing, game.id) >= 0) {
+            continue;
+        }
+        sequence = SaveStorePut(handle, game.id, game.status, game.balance, game.createdAt, game.updatedAt,
+                                game.lastSavedAt, game.name.data(), static_cast<int32_t>(game.name.size()),
+                                game.playerName.data(), static_cast<int32_t>(game.playerName.size()),
+                                game.companyName.data(), static_cast<int32_t>(game.companyName.size()), nullptr, 0);
+        ++imported;
+    }
+    SaveStoreListingClose(listing);
+    if (imported > 0 && SaveStoreCommit(handle, sequence) != 0) {
+        setError(errorBuffer, errorCapacity, "cannot commit imported games");
+        return -1;
+    }
+    return imported;
+}
@@ -0,0 +1,130 @@
+import Foundation
+
+/// Seasonal and weather-driven demand per region and good.
+///
+/// Seasonal curves are evaluated once per world into per-day-of-year tables
+/// stored as Q4.12 fixed point, so the daily market update is a table lookup
+/// plus one weather anomaly per region drawn from a deterministic stream.
+final class DemandModel {
+    static let daysPerYear = 365
+    private static let fixedPointShift = 12
+    private static let fixedPointOne = Double(1 << fixedPointShift)
+    /// Largest weather swing, as a share of demand, for a fully sensitive good.
+    private static let weatherAmplitude = 0.15
+    /// Regions shift the national seasonal peak by up to this many days.
+    private static let regionalPhaseSpread = 30.0
+
+    let regionCount: Int
+    private let goodCount = Good.allCases.count
+    private let seed: UInt64
+    /// Layout: `seasonal[(region * goodCount + good) * daysPerYear + dayOfYear]`.
+    private let seasonal: [UInt16]
+
+    init(regionCount: Int, seed: UInt64) {
+        self.regionCount = regionCount
+        self.seed = seed
+
+        var generator = SeededGenerator(seed: seed ^ 0x5EA5_0DA1_5EA5_0DA1)
+        var table = [UInt16](repeating: 0, count: regionCount * goodCount * Self.daysPerYear)
+
+        for region in 0..<regionCount {
+            let phase = Double.random(in: -Self.regionalPhaseSpread...Self.regionalPhaseSpread, using: &generator)
+            let intensity = Double.random(in: 0.7...1.3, using: &generator)
+
+            for good in Good.allCases {
+                let amplitude = Self.seasonalAmplitude(of: good) * intensity
+                let peak = Self.seasonalPeakDay(of: good) + phase
+                let base = (region * goodCount + good.rawValue) * Self.daysPerYear
+
+                for day in 0..<Self.daysPerYear {
+                    let angle = 2 * Double.pi * (Double(day) - peak) / Double(Self.daysPerYear)
+                    let multiplier = max(1 + amplitude * cos(angle), 0)
+                    table[base + day] = UInt16(min((multiplier * Self.fixedPointOne).rounded(), Double(UInt16.max)))
+                }
+            }
+        }
+
+        seasonal = table
+    }
+
+    /// One weather anomaly per region for `day`, in [-1, 1]. Drawn from a
+    /// stream keyed by (seed, day, region), so any day can be recomputed.
+    func weatherAnomalies(day: Int) -> [Double] {
+        (0..<regionCount).map { region in
+            var generator = SeededGenerator(seed: seed ^ (UInt64(truncatingIfNeeded: day) &* 0x9E37_79B9_7F4A_7C15) ^ UInt64(region))
+            // Sum of two uniforms: triangular, so mild days dominate.
+            return Double.random(in: -0.5...0.5, using: &generator) + Double.random(in: -0.5...0.5, using: &generator)
+        }
+    }
+
+    /// Fills `demand[region * goodCount + good]` with the demand multiplier
+    /// for `dayOfYear` under the given weather.
+    func fillDemand(_ demand: inout [Double], dayOfYear: Int, weather: [Double]) {
+        let day = ((dayOfYear % Self.daysPerYear) + Self.daysPerYear) % Self.daysPerYear
+        if demand.count != regionCount * goodCount {
+            demand = [Double](repeating: 1, count: regionCount * goodCount)
+        }
+
+        for region in 0..<regionCount {
+            let anomaly = weather[region] * Self.weatherAmplitude
+            for good in Good.allCases {
+                let cell = region * goodCount + good.rawValue
+                let seasonalFactor = Double(seasonal[cell * Self.daysPerYear + day]) / Self.fixedPointOne
+                demand[cell] = seasonalFactor * (1 + anomaly * Self.weatherSensitivity(of: good))
+            }
+        }
+    }
+
+    private static func seasonalAmplitude(of good: Good) -> Double {
+        switch good {
+        case .grain:
+            return 0.25
+        case .coal:
+            return 0.35
+        case .lumber:
+            return 0.2
+        case .textiles:
+            return 0.15
+        case .steel:
+            return 0.05
+        case .oil:
+            return 0.2
+        }
+    }
+
+    /// Day of year with the highest demand: heating fuels peak in winter,
+    /// construction in summer, grain after harvest.
+    private static func seasonalPeakDay(of good: Good) -> Double {
+        switch good {
+        case .grain:
+            return 270
+        case .coal:
+            return 15
+        case .lumber:
+            return 180
+        case .textiles:
+            return 320
+        case .steel:
+            return 150
+        case .oil:
+            return 20
+        }
+    }
+
+    private static func weatherSensitivity(of good: Good) -> Double {
+        switch good {
+        case .grain:
+            return 1
+        case .coal:
+            return 0.8
+        case .lumber:
+            return 0.4
+        case .textiles:
+            return 0.3
+        case .steel:
+            return 0.1
+        case .oil:
+            return 0.6
+        }
+    }
+}
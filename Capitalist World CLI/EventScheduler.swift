@@ -0,0 +1,72 @@
+import Foundation
+
+/// Events keyed by the simulated day they fire on, kept in a binary min-heap.
+/// Events due on the same day fire in the order they were scheduled.
+struct EventScheduler<Event: Codable>: Codable {
+    private struct Entry: Codable {
+        let day: Int
+        let sequence: UInt64
+        let event: Event
+
+        func firesBefore(_ other: Entry) -> Bool {
+            day != other.day ? day < other.day : sequence < other.sequence
+        }
+    }
+
+    private var heap: [Entry] = []
+    private var nextSequence: UInt64 = 0
+
+    var count: Int { heap.count }
+    var isEmpty: Bool { heap.isEmpty }
+
+    /// Day of the earliest pending event.
+    var nextDay: Int? { heap.first?.day }
+
+    mutating func schedule(_ event: Event, on day: Int) {
+        heap.append(Entry(day: day, sequence: nextSequence, event: event))
+        nextSequence &+= 1
+        siftUp(from: heap.count - 1)
+    }
+
+    /// Removes and returns the earliest event due on or before `day`.
+    mutating func popDue(through day: Int) -> Event? {
+        guard let first = heap.first, first.day <= day else { return nil }
+
+        let last = heap.removeLast()
+        if heap.isEmpty == false {
+            heap[0] = last
+            siftDown(from: 0)
+        }
+        return first.event
+    }
+
+    private mutating func siftUp(from index: Int) {
+        var child = index
+        while child > 0 {
+            let parent = (child - 1) / 2
+            guard heap[child].firesBefore(heap[parent]) else { return }
+            heap.swapAt(child, parent)
+            child = parent
+        }
+    }
+
+    private mutating func siftDown(from index: Int) {
+        var parent = index
+        while true {
+            let left = parent * 2 + 1
+            let right = left + 1
+            var earliest = parent
+
+            if left < heap.count, heap[left].firesBefore(heap[earliest]) {
+                earliest = left
+            }
+            if right < heap.count, heap[right].firesBefore(heap[earliest]) {
+                earliest = right
+            }
+            guard earliest != parent else { return }
+
+            heap.swapAt(parent, earliest)
+            parent = earliest
+        }
+    }
+}
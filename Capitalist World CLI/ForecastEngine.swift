@@ -0,0 +1,239 @@
+import Foundation
+
+/// Monte Carlo projection of the player's company. Paths run in parallel in
+/// the background, each with its own RNG stream, and progress is published
+/// as chunks of paths complete.
+final class ForecastEngine {
+    static let yearRange = 1...50
+    static let pathRange = 1...100_000
+
+    /// Inputs captured from the world. Only companies whose profits reach
+    /// the player move the forecast, so only theirs are kept: paths skip
+    /// the shocks of every other company. A seed reproduces its bands only
+    /// under the same draw order, so bands saved by a build that drew
+    /// shocks for every company do not match this one's.
+    struct Scenario {
+        let seed: UInt64
+        let playerCash: Double
+        let playerProfit: Double
+        let revenue: [Double]
+        let costs: [Double]
+        let growth: [Double]
+
+        init(capturing world: World) {
+            let companies = (0..<world.companyCount).filter {
+                world.beneficiary(of: $0) == World.playerCompanyIndex
+            }
+            seed = world.generator.state ^ UInt64(world.day)
+            playerCash = world.playerCash
+            playerProfit = world.ledger.profit
+            revenue = companies.map { world.companyRevenue[$0] }
+            costs = companies.map { world.companyCosts[$0] }
+            growth = companies.map { world.companyGrowth[$0] }
+        }
+    }
+
+    struct Band {
+        let p10: Double
+        let p50: Double
+        let p90: Double
+    }
+
+    struct Progress {
+        let completedPaths: Int
+        let totalPaths: Int
+        let medianFinalBalance: Double?
+
+        var isComplete: Bool { completedPaths == totalPaths }
+    }
+
+    struct Report {
+        let years: Int
+        let paths: Int
+        let balanceBands: [Band]
+        let profitBands: [Band]
+    }
+
+    private static let monthsPerYear = 12
+    private static let pathsPerChunk = 64
+    /// Monthly standard deviation of revenue and cost shocks.
+    private static let monthlyVolatility = 0.03
+    private static let marginShockShare = 0.25
+
+    var onProgress: ((Progress) -> Void)?
+
+    private let workQueue = DispatchQueue(label: "com.capitalistworld.forecast", qos: .utility)
+    private let lock = NSLock()
+    private var generation = 0
+    private var progress: Progress?
+    private var report: Report?
+    private var completedFinals: [Double] = []
+
+    func start(scenario: Scenario, years: Int, paths: Int) {
+        lock.lock()
+        generation += 1
+        let runGeneration = generation
+        progress = Progress(completedPaths: 0, totalPaths: paths, medianFinalBalance: nil)
+        report = nil
+        completedFinals = []
+        completedFinals.reserveCapacity(paths)
+        lock.unlock()
+
+        workQueue.async { [weak self] in
+            self?.run(scenario: scenario, years: years, paths: paths, generation: runGeneration)
+        }
+    }
+
+    func latestProgress() -> Progress? {
+        lock.lock()
+        defer { lock.unlock() }
+        return progress
+    }
+
+    func latestReport() -> Report? {
+        lock.lock()
+        defer { lock.unlock() }
+        return report
+    }
+
+    private func run(scenario: Scenario, years: Int, paths: Int, generation runGeneration: Int) {
+        // Path-major results: balances[path * years + year].
+        var balances = [Double](repeating: 0, count: paths * years)
+        var profits = [Double](repeating: 0, count: paths * years)
+
+        let chunkCount = (paths + Self.pathsPerChunk - 1) / Self.pathsPerChunk
+
+        balances.withUnsafeMutableBufferPointer { balanceBuffer in
+            profits.withUnsafeMutableBufferPointer { profitBuffer in
+                let balanceBase = balanceBuffer.baseAddress!
+                let profitBase = profitBuffer.baseAddress!
+
+                DispatchQueue.concurrentPerform(iterations: chunkCount) { chunk in
+                    guard isCurrent(runGeneration) else { return }
+
+                    let lower = chunk * Self.pathsPerChunk
+                    let upper = min(lower + Self.pathsPerChunk, paths)
+                    var chunkFinals: [Double] = []
+                    chunkFinals.reserveCapacity(upper - lower)
+
+                    for path in lower..<upper {
+                        simulatePath(
+                            path,
+                            scenario: scenario,
+                            years: years,
+                            balances: balanceBase + path * years,
+                            profits: profitBase + path * years
+                        )
+                        chunkFinals.append(balanceBase[path * years + years - 1])
+                    }
+
+                    publishChunk(chunkFinals, totalPaths: paths, generation: runGeneration)
+                }
+            }
+        }
+
+        guard isCurrent(runGeneration) else { return }
+
+        var balanceBands: [Band] = []
+        var profitBands: [Band] = []
+        var column = [Double](repeating: 0, count: paths)
+        for year in 0..<years {
+            for path in 0..<paths {
+                column[path] = balances[path * years + year]
+            }
+            balanceBands.append(Self.band(of: &column))
+
+            for path in 0..<paths {
+                column[path] = profits[path * years + year]
+            }
+            profitBands.append(Self.band(of: &column))
+        }
+
+        lock.lock()
+        if generation == runGeneration {
+            report = Report(years: years, paths: paths, balanceBands: balanceBands, profitBands: profitBands)
+        }
+        lock.unlock()
+    }
+
+    /// Steps one path month by month, recording the player's year-end cash
+    /// and cumulative profit.
+    private func simulatePath(
+        _ path: Int,
+        scenario: Scenario,
+        years: Int,
+        balances: UnsafeMutablePointer<Double>,
+        profits: UnsafeMutablePointer<Double>
+    ) {
+        var generator = SeededGenerator(seed: scenario.seed ^ (UInt64(path) &* 0x9E37_79B9_7F4A_7C15))
+        var revenue = scenario.revenue
+        var costs = scenario.costs
+        var cash = scenario.playerCash
+        var profit = scenario.playerProfit
+
+        for year in 0..<years {
+            for _ in 0..<Self.monthsPerYear {
+                for company in 0..<revenue.count {
+                    // Revenue and costs share the demand shock; a smaller
+                    // cost-only shock moves the margin.
+                    let drift = scenario.growth[company] / Double(Self.monthsPerYear)
+                    let demandShock = Self.normal(using: &generator) * Self.monthlyVolatility
+                    let marginShock = Self.normal(using: &generator) * Self.monthlyVolatility * Self.marginShockShare
+                    revenue[company] *= 1 + drift + demandShock
+                    costs[company] *= 1 + drift + demandShock + marginShock
+
+                    let monthly = (revenue[company] - costs[company]) / Double(Self.monthsPerYear)
+                    cash += monthly
+                    profit += monthly
+                }
+            }
+            balances[year] = cash
+            profits[year] = profit
+        }
+    }
+
+    private func publishChunk(_ chunkFinals: [Double], totalPaths: Int, generation runGeneration: Int) {
+        lock.lock()
+        guard generation == runGeneration else {
+            lock.unlock()
+            return
+        }
+
+        // Re-sorting on every chunk would be quadratic for large runs, so the
+        // streamed median is refreshed roughly every 5% of paths.
+        let previousCount = completedFinals.count
+        completedFinals.append(contentsOf: chunkFinals)
+        let refreshStep = max(totalPaths / 20, 1)
+        var median = progress?.medianFinalBalance
+        if median == nil || completedFinals.count == totalPaths || completedFinals.count / refreshStep != previousCount / refreshStep {
+            median = completedFinals.sorted()[completedFinals.count / 2]
+        }
+        let update = Progress(completedPaths: completedFinals.count, totalPaths: totalPaths, medianFinalBalance: median)
+        progress = update
+        let handler = onProgress
+        lock.unlock()
+
+        handler?(update)
+    }
+
+    private func isCurrent(_ runGeneration: Int) -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return generation == runGeneration
+    }
+
+    private static func band(of values: inout [Double]) -> Band {
+        values.sort()
+        let percentile = { (fraction: Double) -> Double in
+            values[Int((Double(values.count - 1) * fraction).rounded())]
+        }
+        return Band(p10: percentile(0.1), p50: percentile(0.5), p90: percentile(0.9))
+    }
+
+    /// Standard normal sample (Box-Muller).
+    private static func normal(using generator: inout SeededGenerator) -> Double {
+        let u1 = Double.random(in: Double.ulpOfOne..<1, using: &generator)
+        let u2 = Double.random(in: 0..<1, using: &generator)
+        return (-2 * log(u1)).squareRoot() * cos(2 * .pi * u2)
+    }
+}
@@ -0,0 +1,210 @@
+import Foundation
+
+/// In-memory lookup over saved games, kept current as games are created,
+/// saved and abandoned so `load` never scans or lowercases the whole list.
+/// UUID prefixes resolve through a radix trie and names through case-folded
+/// maps, both in time proportional to the key. Ties go to the most recently
+/// updated game, as the list shows them. Recency is a doubly linked list
+/// threaded through the entries, so an update moves one game to the front
+/// in constant time however many games there are.
+final class GameIndex {
+    private struct Entry {
+        var game: Game
+        /// Next more and next less recently updated games.
+        var newer: UUID?
+        var older: UUID?
+    }
+
+    private var entries: [UUID: Entry] = [:]
+    /// Head of the recency list; `list` numbers games from it.
+    private var newest: UUID?
+    private var prefixes = UUIDPrefixTrie()
+    private var byName: [String: [UUID]] = [:]
+    private var byPlayer: [String: [UUID]] = [:]
+    private var byCompany: [String: [UUID]] = [:]
+
+    /// Builds the index from `games` in any order.
+    init(games: [Game]) {
+        for game in games.sorted(by: { $0.updatedAt < $1.updatedAt }) {
+            update(game)
+        }
+    }
+
+    var count: Int { entries.count }
+
+    var isEmpty: Bool { entries.isEmpty }
+
+    /// Every game, most recently updated first.
+    var orderedGames: [Game] {
+        var games: [Game] = []
+        games.reserveCapacity(entries.count)
+        var next = newest
+        while let id = next, let entry = entries[id] {
+            games.append(entry.game)
+            next = entry.older
+        }
+        return games
+    }
+
+    /// Game shown at 1-based `position` by `list`, found by walking from
+    /// the newest game.
+    func game(atPosition position: Int) -> Game? {
+        guard position >= 1, position <= entries.count else { return nil }
+        var next = newest
+        for _ in 1..<position {
+            next = next.flatMap { entries[$0]?.older }
+        }
+        return next.flatMap { entries[$0]?.game }
+    }
+
+    /// Registers a new game or records that `game` was just updated, which
+    /// makes it the most recent one.
+    func update(_ game: Game) {
+        if let entry = entries[game.id] {
+            unlink(entry)
+        } else {
+            byName[Self.fold(game.name), default: []].append(game.id)
+            byPlayer[Self.fold(game.playerName), default: []].append(game.id)
+            byCompany[Self.fold(game.companyName), default: []].append(game.id)
+        }
+
+        entries[game.id] = Entry(game: game, newer: nil, older: newest)
+        if let previous = newest {
+            entries[previous]?.newer = game.id
+        }
+        newest = game.id
+        prefixes.touch(game.id)
+    }
+
+    /// Takes `entry` out of the recency list, joining its neighbours.
+    private func unlink(_ entry: Entry) {
+        if let newer = entry.newer {
+            entries[newer]?.older = entry.older
+        } else {
+            newest = entry.older
+        }
+        if let older = entry.older {
+            entries[older]?.newer = entry.newer
+        }
+    }
+
+    /// Most recently updated game whose UUID starts with `key` or whose
+    /// name, player or company equals it, ignoring case.
+    func match(_ key: String) -> Game? {
+        let folded = Self.fold(key)
+        var candidates = [byName[folded], byPlayer[folded], byCompany[folded]]
+            .flatMap { $0 ?? [] }
+        if let nibbles = UUIDPrefixTrie.nibbles(ofPrefix: key), let id = prefixes.newest(withPrefix: nibbles) {
+            candidates.append(id)
+        }
+        return candidates
+            .compactMap { entries[$0]?.game }
+            .max { $0.updatedAt < $1.updatedAt }
+    }
+
+    private static func fold(_ value: String) -> String {
+        value.folding(options: .caseInsensitive, locale: nil)
+    }
+}
+
+/// Path-compressed trie over the 32 hex digits of UUIDs. Every node keeps
+/// the most recently touched UUID below it; since a touch always makes a
+/// game the newest, updating the nodes along its path keeps that exact.
+struct UUIDPrefixTrie {
+    private struct Node {
+        /// Hex digits on the edge leading into this node.
+        var edge: [UInt8]
+        /// Child per next hex digit, or -1; empty until the node branches.
+        var children: [Int32]
+        var newest: UUID?
+    }
+
+    private static let digitCount = 32
+    /// Offsets of the hyphens in `UUID.uuidString`.
+    private static let hyphenOffsets: Set<Int> = [8, 13, 18, 23]
+
+    private var nodes = [Node(edge: [], children: [], newest: nil)]
+
+    /// Inserts `id` or marks it as the most recently updated UUID.
+    mutating func touch(_ id: UUID) {
+        let key = Self.nibbles(of: id)
+        var node = 0
+        var depth = 0
+
+        while true {
+            nodes[node].newest = id
+            guard depth < Self.digitCount else { return }
+
+            let digit = Int(key[depth])
+            if nodes[node].children.isEmpty {
+                nodes[node].children = [Int32](repeating: -1, count: 16)
+            }
+            let child = Int(nodes[node].children[digit])
+            guard child >= 0 else {
+                nodes[node].children[digit] = Int32(nodes.count)
+                nodes.append(Node(edge: Array(key[depth...]), children: [], newest: id))
+                return
+            }
+
+            let edge = nodes[child].edge
+            var common = 0
+            while common < edge.count, key[depth + common] == edge[common] {
+                common += 1
+            }
+
+            if common < edge.count {
+                // Split the edge: a new branch node takes the shared digits
+                // and adopts the old child under its first differing digit.
+                let branch = nodes.count
+                var children = [Int32](repeating: -1, count: 16)
+                children[Int(edge[common])] = Int32(child)
+                nodes.append(Node(edge: Array(edge[..<common]), children: children, newest: id))
+                nodes[child].edge = Array(edge[common...])
+                nodes[node].children[digit] = Int32(branch)
+                node = branch
+            } else {
+                node = child
+            }
+            depth += common
+        }
+    }
+
+    /// Most recently touched UUID starting with the hex digits `prefix`.
+    func newest(withPrefix prefix: [UInt8]) -> UUID? {
+        var node = 0
+        var depth = 0
+        while depth < prefix.count {
+            guard nodes[node].children.isEmpty == false else { return nil }
+            let child = Int(nodes[node].children[Int(prefix[depth])])
+            guard child >= 0 else { return nil }
+
+            let edge = nodes[child].edge
+            let compared = min(edge.count, prefix.count - depth)
+            guard edge[..<compared].elementsEqual(prefix[depth..<depth + compared]) else { return nil }
+            depth += edge.count
+            node = child
+        }
+        return nodes[node].newest
+    }
+
+    /// Hex digits of a prefix of `UUID.uuidString` (hyphens where the
+    /// canonical form has them, any case), or `nil` if it cannot be one.
+    static func nibbles(ofPrefix text: String) -> [UInt8]? {
+        var digits: [UInt8] = []
+        for (offset, character) in text.enumerated() {
+            if hyphenOffsets.contains(offset) {
+                guard character == "-" else { return nil }
+                continue
+            }
+            guard let value = character.hexDigitValue else { return nil }
+            digits.append(UInt8(value))
+        }
+        return digits.isEmpty || digits.count > digitCount ? nil : digits
+    }
+
+    private static func nibbles(of id: UUID) -> [UInt8] {
+        withUnsafeBytes(of: id.uuid) { bytes in
+            bytes.flatMap { [$0 >> 4, $0 & 0x0F] }
+        }
+    }
+}
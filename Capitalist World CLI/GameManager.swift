@@ -1,18 +1,25 @@
 import Foundation
-import CoreData
 
 enum GameManagerError: LocalizedError {
-    case activeGameInProgress(String)
     case noActiveGame
     case noGamesAvailable
     case invalidSelection(String)
     case persistenceFailure(Error)
+    case acquisitionTargetNotFound(String)
+    case insufficientFunds(required: Double, available: Double)
+    case invalidTradeArguments(String)
+    case insufficientStock(Good, available: Double)
+    case invalidForecastArguments(String)
+    case sandboxActive
+    case sandboxAlreadyActive
+    case noSandbox
+    case invalidCampaignArguments(String)
+    case campaignNotFound(String)
+    case invalidSnapshot(String)
 
     var errorDescription: String? {
         let localization = Localization.shared
         switch self {
-        case .activeGameInProgress(let name):
-            return localization.activeGameInProgressMessage(name)
         case .noActiveGame:
             return localization.noActiveGameMessage()
         case .noGamesAvailable:
@@ -21,78 +28,222 @@ enum GameManagerError: LocalizedError {
             return localization.invalidLoadMessage(input)
         case .persistenceFailure(let error):
             return localization.persistenceFailureMessage(error)
+        case .acquisitionTargetNotFound(let input):
+            return localization.acquisitionTargetNotFoundMessage(input)
+        case .insufficientFunds(let required, let available):
+            return localization.insufficientFundsMessage(required: required, available: available)
+        case .invalidTradeArguments(let input):
+            return localization.invalidTradeArgumentsMessage(input)
+        case .insufficientStock(let good, let available):
+            return localization.insufficientStockMessage(good: good, available: available)
+        case .invalidForecastArguments(let input):
+            return localization.invalidForecastMessage(input)
+        case .sandboxActive:
+            return localization.sandboxActiveMessage()
+        case .sandboxAlreadyActive:
+            return localization.sandboxAlreadyActiveMessage()
+        case .noSandbox:
+            return localization.noSandboxMessage()
+        case .invalidCampaignArguments(let input):
+            return localization.invalidCampaignMessage(input)
+        case .campaignNotFound(let input):
+            return localization.campaignNotFoundMessage(input)
+        case .invalidSnapshot(let input):
+            return localization.invalidSnapshotMessage(input)
         }
     }
 }
 
+struct InventoryLine {
+    let warehouseName: String
+    let good: Good
+    let quantity: Double
+    let carryingValue: Double
+    let marketPrice: Double
+}
+
+struct TradeReceipt {
+    let good: Good
+    let quantity: Double
+    let unitPrice: Double
+
+    var total: Double { quantity * unitPrice }
+}
+
+struct BrandAwarenessLine {
+    let regionName: String
+    let awareness: Double
+    let share: Double
+}
+
+struct MarketingReport {
+    let regions: [BrandAwarenessLine]
+    let campaigns: [Marketing.Campaign]
+    let regionNames: [String]
+}
+
+struct AchievementLine {
+    let id: String
+    let unlockedDay: Int?
+}
+
+struct MaintenanceReport {
+    let archived: Int
+    let remaining: Int
+    let archive: URL
+    /// Archived games whose damaged world was left behind.
+    let withoutWorld: [Game]
+}
+
 final class GameManager {
     static let shared = GameManager()
-
-    private let stack = CoreDataStack()
+    /// Months shown by the history command.
+    private static let historyMonths = 12
+    /// Games moved to the cold archive per journal commit by maintenance.
+    private static let maintenanceBatchSize = 256
+
+    private let store: SaveStore
+    /// Built from the full listing the first time games are listed or
+    /// looked up; startup needs only the latest active game.
+    private lazy var index = GameIndex(games: store.fetchAllGames().map { game in
+        game.id == currentGame?.id ? currentGame ?? game : game
+    })
     private let localization = Localization.shared
-    private let startingBalance: Double = 10_000_000
+    private let startingBalance = ScenarioPack.shared.startingBalance
     private(set) var currentGame: Game?
+    let simulation: Simulation
+    let forecastEngine = ForecastEngine()
+    private let slots: SaveSlots
+    private let history: HistoryStore
+    private let snapshots: SnapshotStore
+    /// Games brought over from the Core Data store of the first releases at
+    /// this start, if there were any to import.
+    let coreDataImport: SaveStore.CoreDataImport?
+    /// Simulated days between autosaves, or `nil` when they are off.
+    private(set) var autosaveIntervalDays: Int? = Autosaver.defaultIntervalDays
 
     private init() {
-        currentGame = try? fetchMostRecentActiveGame()
+        let store = SaveStore()
+        self.store = store
+        snapshots = SnapshotStore(directory: store.directory)
+        slots = SaveSlots(store: store, snapshots: snapshots)
+        history = HistoryStore(directory: store.directory)
+        simulation = Simulation(referenceDate: ScenarioPack.shared.referenceDate)
+        // Before picking the game to resume, which may be an imported one.
+        coreDataImport = store.importCoreDataGames()
+        currentGame = store.latestActiveGame()
+        if let currentGame {
+            let id = currentGame.id
+            let companyName = currentGame.companyName
+            let balance = currentGame.balance
+            simulation.load(deferred: {
+                do {
+                    return try Self.makeWorld(id: id, companyName: companyName, balance: balance, from: store)
+                } catch let error as SaveStoreError {
+                    throw error
+                } catch {
+                    throw SaveStoreError.worldDamaged(store.directory)
+                }
+            })
+            slots.play(currentGame, parking: nil)
+        }
+        track(currentGame)
+        simulation.setMonthEndHandler { [history] world in
+            history.record(world)
+        }
     }
 
-    @discardableResult
-    func startGame(named name: String?, playerName: String, companyName: String) throws -> Game {
-        if let activeGame = currentGame, activeGame.gameStatus == .active {
-            throw GameManagerError.activeGameInProgress(activeGame.name)
-        }
+    /// Why the world of the resumed game could not be loaded, if a
+    /// simulated day or a command that reads no errors hit it first.
+    /// Returned once.
+    func takeWorldLoadFailure() -> Error? {
+        simulation.takeLoadFailure()
+    }
 
-        let context = stack.context
-        let game = Game(context: context)
-        game.id = UUID()
+    /// Called on a slot's writer queue after each background save.
+    var onAutosave: ((Autosaver.Status) -> Void)? {
+        get { slots.onSave }
+        set { slots.onSave = newValue }
+    }
 
+    /// Starts a new game and puts it in play. The game in play, if any,
+    /// stays open in its slot.
+    @discardableResult
+    func startGame(named name: String?, playerName: String, companyName: String) throws -> Game {
         let trimmedName = name?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
-        game.name = trimmedName.isEmpty ? localization.defaultGameName(for: Date()) : trimmedName
-
         let trimmedPlayer = playerName.trimmingCharacters(in: .whitespacesAndNewlines)
-        game.playerName = trimmedPlayer.isEmpty ? playerName : trimmedPlayer
-
         let trimmedCompany = companyName.trimmingCharacters(in: .whitespacesAndNewlines)
-        game.companyName = trimmedCompany.isEmpty ? companyName : trimmedCompany
-
-        game.gameStatus = .active
-        game.balance = startingBalance
         let now = Date()
-        game.createdAt = now
-        game.updatedAt = now
-        game.lastSavedAt = now
+        let game = Game(
+            id: UUID(),
+            name: trimmedName.isEmpty ? localization.defaultGameName(for: now) : trimmedName,
+            playerName: trimmedPlayer.isEmpty ? playerName : trimmedPlayer,
+            companyName: trimmedCompany.isEmpty ? companyName : trimmedCompany,
+            gameStatus: .active,
+            balance: startingBalance,
+            createdAt: now,
+            updatedAt: now,
+            lastSavedAt: now
+        )
+
+        let world = World.generate(seed: game.id, playerCompanyName: game.companyName, startingBalance: startingBalance)
 
         do {
-            try stack.saveIfNeeded()
+            try slots.slot(for: game).autosaver.saveNow(game, world: world)
+            try play(game, world: world)
         } catch {
             throw GameManagerError.persistenceFailure(error)
         }
 
-        currentGame = game
+        index.update(game)
         return game
     }
 
+    /// Queues a save of the game in play and returns without waiting for
+    /// the write; the prompt's autosave column reports when it is on disk
+    /// or that it failed.
     @discardableResult
     func saveCurrentGame() throws -> Game {
+        let (game, world) = try forkCurrentGame()
+        let autosaver = slots.slot(for: game).autosaver
+        if let world {
+            autosaver.save(game, world: world)
+        } else {
+            do {
+                try autosaver.saveNow(game, world: nil)
+            } catch {
+                throw GameManagerError.persistenceFailure(error)
+            }
+        }
+
+        index.update(game)
+        return game
+    }
+
+    /// Stamps the game in play as saved now and forks its world for the
+    /// autosave queue. The fork is O(1); encoding and the fsync run on the
+    /// queue while the simulation keeps stepping the live world.
+    private func forkCurrentGame() throws -> (Game, World?) {
         guard let game = currentGame, game.gameStatus == .active else {
             throw GameManagerError.noActiveGame
         }
+        guard simulation.isSandboxActive == false else {
+            throw GameManagerError.sandboxActive
+        }
 
         let now = Date()
         game.lastSavedAt = now
         game.updatedAt = now
-        game.balance = startingBalance
 
-        do {
-            try stack.saveIfNeeded()
-        } catch {
-            throw GameManagerError.persistenceFailure(error)
+        let world = simulation.forkWorld()
+        if let world {
+            game.balance = world.playerCash
         }
-
-        return game
+        return (game, world)
     }
 
+    /// Abandons the game in play and closes its slot; other open games stay
+    /// open.
     func abandonCurrentGame() throws {
         guard let game = currentGame, game.gameStatus == .active else {
             throw GameManagerError.noActiveGame
@@ -100,20 +251,22 @@ final class GameManager {
 
         game.gameStatus = .abandoned
         game.updatedAt = Date()
+        track(nil)
 
         do {
-            try stack.saveIfNeeded()
+            try slots.slot(for: game).autosaver.saveNow(game, world: nil)
         } catch {
             throw GameManagerError.persistenceFailure(error)
         }
 
+        slots.close(game)
+        index.update(game)
         currentGame = nil
+        simulation.load(nil)
     }
 
     func fetchAllGames() throws -> [Game] {
-        let request: NSFetchRequest<Game> = Game.fetchRequest()
-        request.sortDescriptors = [NSSortDescriptor(key: "updatedAt", ascending: false)]
-        return try stack.context.fetch(request)
+        index.orderedGames
     }
 
     @discardableResult
@@ -123,66 +276,554 @@ final class GameManager {
             throw GameManagerError.invalidSelection(input)
         }
 
-        let games = try fetchAllGames()
-        guard games.isEmpty == false else {
+        guard index.isEmpty == false else {
             throw GameManagerError.noGamesAvailable
         }
 
-        if let index = Int(trimmed), index >= 1, index <= games.count {
-            return try activateGame(games[index - 1])
+        if let position = Int(trimmed), let game = index.game(atPosition: position) {
+            return try activateGame(game)
         }
 
-        let lowercased = trimmed.lowercased()
-        if let match = games.first(where: { game in
-            game.id.uuidString.lowercased().hasPrefix(lowercased) ||
-            game.name.lowercased() == lowercased ||
-            game.playerName.lowercased() == lowercased ||
-            game.companyName.lowercased() == lowercased
-        }) {
+        if let match = index.match(trimmed) {
             return try activateGame(match)
         }
 
         throw GameManagerError.invalidSelection(trimmed)
     }
 
+    /// Saves the current game and writes it to `file` for another machine.
+    /// Runs on the calling thread, waiting for the save; the simulation
+    /// keeps stepping meanwhile.
+    func exportCurrentGame(to file: URL) throws -> Game {
+        let (game, world) = try forkCurrentGame()
+        do {
+            try slots.slot(for: game).autosaver.saveNow(game, world: world)
+        } catch {
+            throw GameManagerError.persistenceFailure(error)
+        }
+        index.update(game)
+        try store.export(game, to: file)
+        return game
+    }
+
+    /// Adds the games exported or archived to `file` to the saved games
+    /// without loading them.
+    func importGames(from file: URL) throws -> [Game] {
+        let games = try store.importGames(from: file)
+        for game in games {
+            index.update(game)
+        }
+        return games
+    }
+
+    /// Cold archive maintenance uses unless given another file.
+    var defaultArchive: URL {
+        store.directory.appendingPathComponent("archive.cwex")
+    }
+
+    /// Moves every abandoned game out of the saved games into the cold
+    /// archive at `file`, in batches, then vacuums the store: the catalog
+    /// is rewritten without them and their worlds, snapshots and monthly
+    /// history deleted.
+    /// `progress` gets the games archived so far and the total after each
+    /// batch. Archived games come back with the import command; those whose
+    /// world was damaged come back with a new one.
+    func archiveAbandonedGames(to file: URL?, progress: (Int, Int) -> Void) throws -> MaintenanceReport {
+        let archive = file ?? defaultArchive
+        let abandoned = index.orderedGames.filter { $0.gameStatus == .abandoned && $0.id != currentGame?.id }
+        guard abandoned.isEmpty == false else {
+            return MaintenanceReport(archived: 0, remaining: index.count, archive: archive, withoutWorld: [])
+        }
+
+        var archived: Set<UUID> = []
+        defer {
+            if archived.isEmpty == false {
+                index = GameIndex(games: index.orderedGames.filter { archived.contains($0.id) == false })
+            }
+        }
+        let withoutWorld: [Game]
+        do {
+            withoutWorld = try store.archive(abandoned, to: archive, batchSize: Self.maintenanceBatchSize) { batch in
+                for game in batch {
+                    archived.insert(game.id)
+                    snapshots.drop(game.id)
+                }
+                history.drop(batch.map(\.id))
+                progress(archived.count, abandoned.count)
+            }
+            try store.compact()
+        } catch {
+            throw GameManagerError.persistenceFailure(error)
+        }
+        return MaintenanceReport(
+            archived: archived.count,
+            remaining: index.count - archived.count,
+            archive: archive,
+            withoutWorld: withoutWorld
+        )
+    }
+
+    /// Independent companies the player can buy, priced from their DCF
+    /// valuation plus a control premium.
+    func acquisitionQuotes() throws -> [Simulation.AcquisitionQuote] {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        return try perform { world in
+            simulation.acquisitionTargets(in: world).map { simulation.acquisitionQuote(for: $0, in: world) }
+        } ?? []
+    }
+
+    @discardableResult
+    func acquireCompany(matching input: String) throws -> Simulation.AcquisitionQuote {
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        let quotes = try acquisitionQuotes()
+
+        let selected: Simulation.AcquisitionQuote?
+        if let index = Int(trimmed), index >= 1, index <= quotes.count {
+            selected = quotes[index - 1]
+        } else {
+            let lowercased = trimmed.lowercased()
+            selected = quotes.first { $0.name.lowercased() == lowercased }
+        }
+
+        guard let selected else {
+            throw GameManagerError.acquisitionTargetNotFound(trimmed)
+        }
+
+        let acquired = try perform { world -> Simulation.AcquisitionQuote in
+            // Re-quote on the simulation queue: days may have passed since
+            // listing, and liquidations may have moved or removed the target.
+            guard let index = world.companyIndex(of: selected.companyID),
+                  world.companyOwner[index] == World.independentOwner else {
+                throw GameManagerError.acquisitionTargetNotFound(trimmed)
+            }
+
+            let quote = simulation.acquisitionQuote(for: index, in: world)
+            guard world.playerCash >= quote.price else {
+                throw GameManagerError.insufficientFunds(required: quote.price, available: world.playerCash)
+            }
+
+            world.transferOwnership(of: quote.companyIndex, to: World.playerCompanyIndex, price: quote.price)
+            return quote
+        }
+
+        guard let acquired else {
+            throw GameManagerError.noActiveGame
+        }
+        return acquired
+    }
+
+    var inventoryCostingMethod: InventoryLedger.CostingMethod {
+        simulation.perform { $0.inventory.method } ?? .fifo
+    }
+
+    /// Stock held in the player's warehouses, including movements queued
+    /// for today's batch.
+    func inventoryReport() throws -> [InventoryLine] {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        return try perform { world in
+            world.warehouses(ownedBy: World.playerCompanyIndex).flatMap { warehouse in
+                Good.allCases.map { good in
+                    let pair = world.pairIndex(warehouse: warehouse, good: good)
+                    return InventoryLine(
+                        warehouseName: world.warehouseNames[warehouse],
+                        good: good,
+                        quantity: world.inventory.availableQuantity(pair: pair),
+                        carryingValue: world.inventory.carryingValue(pair: pair),
+                        marketPrice: world.goodPrices[good.rawValue]
+                    )
+                }
+            }
+        } ?? []
+    }
+
+    /// Buys goods at the market asking price into the player's first
+    /// warehouse. The receipt is costed in tonight's inventory batch.
+    @discardableResult
+    func purchaseGoods(_ input: String) throws -> TradeReceipt {
+        let (good, quantity) = try parseTrade(input)
+
+        let receipt = try perform { world -> TradeReceipt in
+            guard let warehouse = world.warehouses(ownedBy: World.playerCompanyIndex).first else {
+                throw GameManagerError.noActiveGame
+            }
+
+            let receipt = TradeReceipt(good: good, quantity: quantity, unitPrice: world.goodPrices[good.rawValue])
+            guard world.playerCash >= receipt.total else {
+                throw GameManagerError.insufficientFunds(required: receipt.total, available: world.playerCash)
+            }
+
+            world.playerCash -= receipt.total
+            world.inventory.queueReceipt(
+                pair: world.pairIndex(warehouse: warehouse, good: good),
+                quantity: quantity,
+                unitCost: receipt.unitPrice
+            )
+            return receipt
+        }
+
+        guard let receipt else {
+            throw GameManagerError.noActiveGame
+        }
+        return receipt
+    }
+
+    /// Sells goods from the player's warehouses at the market bid price.
+    /// Revenue is booked now; cost of goods sold when the batch settles.
+    @discardableResult
+    func sellGoods(_ input: String) throws -> TradeReceipt {
+        let (good, quantity) = try parseTrade(input)
+
+        let receipt = try perform { world -> TradeReceipt in
+            let pairs = world.warehouses(ownedBy: World.playerCompanyIndex).map {
+                world.pairIndex(warehouse: $0, good: good)
+            }
+            let available = pairs.reduce(0) { $0 + world.inventory.availableQuantity(pair: $1) }
+            guard available >= quantity else {
+                throw GameManagerError.insufficientStock(good, available: available)
+            }
+
+            var remaining = quantity
+            for pair in pairs where remaining > 0 {
+                let taken = min(remaining, world.inventory.availableQuantity(pair: pair))
+                if taken > 0 {
+                    world.inventory.queueIssue(pair: pair, quantity: taken)
+                    remaining -= taken
+                }
+            }
+
+            let receipt = TradeReceipt(good: good, quantity: quantity, unitPrice: world.sellPrice(of: good))
+            world.playerCash += receipt.total
+            world.ledger.revenue += receipt.total
+            return receipt
+        }
+
+        guard let receipt else {
+            throw GameManagerError.noActiveGame
+        }
+        return receipt
+    }
+
+    /// Starts a Monte Carlo forecast from "<years> <paths>" in the
+    /// background. Results are read back through `forecastEngine`.
+    func startForecast(_ input: String) throws -> (years: Int, paths: Int) {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        let components = trimmed.split(separator: " ", omittingEmptySubsequences: true)
+        guard components.count == 2,
+              let years = Int(components[0]), ForecastEngine.yearRange.contains(years),
+              let paths = Int(components[1]), ForecastEngine.pathRange.contains(paths) else {
+            throw GameManagerError.invalidForecastArguments(trimmed)
+        }
+
+        let scenario = try perform { ForecastEngine.Scenario(capturing: $0) }
+
+        guard let scenario else {
+            throw GameManagerError.noActiveGame
+        }
+
+        forecastEngine.start(scenario: scenario, years: years, paths: paths)
+        return (years, paths)
+    }
+
+    /// Player's awareness per region and campaigns not yet finished.
+    func marketingReport() throws -> MarketingReport {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        let report = try perform { world in
+            let player = World.playerCompanyIndex
+            return MarketingReport(
+                regions: world.regionNames.indices.map { region in
+                    BrandAwarenessLine(
+                        regionName: world.regionNames[region],
+                        awareness: world.marketing.awareness(brand: player, region: region),
+                        share: world.marketing.share(brand: player, region: region)
+                    )
+                },
+                campaigns: world.marketing.campaigns.values
+                    .filter { $0.brand == Int32(player) }
+                    .sorted { $0.id < $1.id },
+                regionNames: world.regionNames
+            )
+        }
+
+        guard let report else {
+            throw GameManagerError.noActiveGame
+        }
+        return report
+    }
+
+    /// Schedules a campaign from "<daily budget> <days> <region>", starting
+    /// tomorrow. The region is matched by name or 1-based number.
+    @discardableResult
+    func launchCampaign(_ input: String) throws -> (campaign: Marketing.Campaign, regionName: String) {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        let components = trimmed.split(separator: " ", maxSplits: 2, omittingEmptySubsequences: true)
+        guard components.count == 3,
+              let dailySpend = Double(components[0]), dailySpend > 0, dailySpend.isFinite,
+              let days = Int(components[1]), days > 0 else {
+            throw GameManagerError.invalidCampaignArguments(trimmed)
+        }
+        let regionInput = String(components[2]).lowercased()
+
+        let launched = try perform { world -> (campaign: Marketing.Campaign, regionName: String) in
+            let region: Int?
+            if let number = Int(regionInput), world.regionNames.indices.contains(number - 1) {
+                region = number - 1
+            } else {
+                region = world.regionNames.firstIndex { $0.lowercased() == regionInput }
+            }
+            guard let region else {
+                throw GameManagerError.invalidCampaignArguments(trimmed)
+            }
+
+            let total = dailySpend * Double(days)
+            guard world.playerCash >= total else {
+                throw GameManagerError.insufficientFunds(required: total, available: world.playerCash)
+            }
+
+            let campaign = world.marketing.launchCampaign(
+                brand: World.playerCompanyIndex,
+                region: region,
+                dailySpend: dailySpend,
+                startDay: world.day + 1,
+                days: days
+            )
+            return (campaign, world.regionNames[region])
+        }
+
+        guard let launched else {
+            throw GameManagerError.noActiveGame
+        }
+        return launched
+    }
+
+    /// Ends one of the player's campaigns at the next simulated day.
+    func stopCampaign(_ input: String) throws {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        let stopped = try perform { world -> Bool in
+            guard let id = Int(trimmed),
+                  world.marketing.campaigns[id]?.brand == Int32(World.playerCompanyIndex) else {
+                return false
+            }
+            return world.marketing.stopCampaign(id, on: world.day + 1)
+        }
+
+        guard stopped == true else {
+            throw GameManagerError.campaignNotFound(trimmed)
+        }
+    }
+
+    /// Every achievement in rule order with the day it was unlocked, if any.
+    func achievementReport() throws -> [AchievementLine] {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        let unlocked = try perform { $0.achievements.unlocked } ?? [:]
+        return AchievementRules.definitions.map { AchievementLine(id: $0.id, unlockedDay: unlocked[$0.id]) }
+    }
+
+    /// Player results of the latest closed months, most recent first.
+    func monthlyHistory() throws -> [HistoryStore.Month] {
+        guard let game = currentGame, game.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+        return try history.months(of: game.id, count: Self.historyMonths)
+    }
+
+    /// Saved snapshots of the active game, newest first.
+    func snapshotReport() throws -> [SnapshotStore.Snapshot] {
+        guard let game = currentGame, game.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+        return try snapshots.snapshots(of: game.id)
+    }
+
+    /// Rewinds the active game to the snapshot at `input`, a 1-based
+    /// position in `snapshotReport()`, and saves it. The snapshots after it
+    /// are kept, so a rewind can itself be undone.
+    @discardableResult
+    func restoreSnapshot(_ input: String) throws -> SnapshotStore.Snapshot {
+        guard let game = currentGame, game.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+        guard simulation.isSandboxActive == false else {
+            throw GameManagerError.sandboxActive
+        }
+
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        let available = try snapshots.snapshots(of: game.id)
+        guard let position = Int(trimmed), available.indices.contains(position - 1) else {
+            throw GameManagerError.invalidSnapshot(trimmed)
+        }
+
+        let snapshot = available[position - 1]
+        let world = try World.decode(snapshots.world(of: game.id, snapshot: snapshot))
+        simulation.load(world)
+        try saveCurrentGame()
+        return snapshot
+    }
+
+    func beginSandbox() throws {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+        guard simulation.beginSandbox() else {
+            throw GameManagerError.sandboxAlreadyActive
+        }
+    }
+
+    func endSandbox(keepChanges: Bool) throws {
+        guard simulation.endSandbox(keepChanges: keepChanges) else {
+            throw GameManagerError.noSandbox
+        }
+    }
+
+    /// Autosaves the active game every `days` simulated days; `nil` turns
+    /// autosave off.
+    func setAutosaveInterval(_ days: Int?) {
+        autosaveIntervalDays = days
+        track(currentGame)
+    }
+
+    /// Latest background save of the game in play; callable from any
+    /// thread.
+    func latestAutosave() -> Autosaver.Status? {
+        slots.current?.autosaver.latestStatus()
+    }
+
     func statusSummary(for game: Game) -> String {
-        localization.statusSummary(
+        var lastSaved = game.lastSavedAt
+        if game.id == currentGame?.id, let autosave = latestAutosave(), autosave.failed == false {
+            lastSaved = max(lastSaved, autosave.savedAt)
+        }
+        return localization.statusSummary(
             name: game.name,
             playerName: game.playerName,
             companyName: game.companyName,
             balance: game.balance,
-            lastSaved: game.lastSavedAt
+            lastSaved: lastSaved
         )
     }
 
     private func activateGame(_ game: Game) throws -> Game {
         let now = Date()
-        if currentGame?.objectID != game.objectID {
-            currentGame = game
-        }
+        let isSwitchingGame = currentGame?.id != game.id
 
         if game.gameStatus != .active {
             game.gameStatus = .active
         }
-        if game.balance != startingBalance {
-            game.balance = startingBalance
-        }
         game.updatedAt = now
 
         do {
-            try stack.saveIfNeeded()
+            if isSwitchingGame {
+                try play(game)
+            }
+            try slots.slot(for: game).autosaver.saveNow(game, world: nil)
         } catch {
             throw GameManagerError.persistenceFailure(error)
         }
 
+        index.update(game)
         return game
     }
 
-    private func fetchMostRecentActiveGame() throws -> Game? {
-        let request: NSFetchRequest<Game> = Game.fetchRequest()
-        request.predicate = NSPredicate(format: "status == %@", GameStatus.active.rawValue)
-        request.sortDescriptors = [NSSortDescriptor(key: "updatedAt", ascending: false)]
-        request.fetchLimit = 1
-        return try stack.context.fetch(request).first
+    /// Puts `game` in play with `world`, the world parked in its slot, or
+    /// the one in the store, in that order, and parks the world of the game
+    /// that was in play in that game's slot.
+    private func play(_ game: Game, world: World? = nil) throws {
+        let slot = slots.slot(for: game)
+        var next = world ?? slots.parkedWorld(of: game)
+        if next == nil {
+            // A world evicted from the slot may still be on its way to the
+            // store.
+            slot.autosaver.waitForQueuedSaves()
+            next = try makeWorld(for: game)
+        }
+
+        // Month-end history and autosaves of the world leaving play must not
+        // land under the new game.
+        track(nil)
+        let previous = simulation.exchange(next)
+        slots.play(game, parking: previous)
+        currentGame = game
+        track(game)
+    }
+
+    /// Runs `body` on the world in play. A deferred load that failed is
+    /// thrown here rather than read as a missing world.
+    private func perform<T>(_ body: (World) throws -> T) throws -> T? {
+        if let result = try simulation.perform(body) {
+            return result
+        }
+        if let failure = simulation.takeLoadFailure() {
+            throw failure
+        }
+        return nil
+    }
+
+    /// Points autosaves and month-end history at `game`, or stops both.
+    /// Autosaves go to the writer of the game's slot.
+    private func track(_ game: Game?) {
+        history.track(game?.id)
+        guard let game, let days = autosaveIntervalDays else {
+            simulation.setAutosave(every: 0) { _ in }
+            return
+        }
+        let autosaver = slots.slot(for: game).autosaver
+        simulation.setAutosave(every: days) { world in
+            autosaver.enqueue(world)
+        }
+    }
+
+    /// Restores the saved world of `game`, or generates one for saves that
+    /// predate world persistence.
+    private func makeWorld(for game: Game) throws -> World {
+        try Self.makeWorld(id: game.id, companyName: game.companyName, balance: game.balance, from: store)
+    }
+
+    /// Takes values rather than the `Game` so it can run on the simulation
+    /// queue while the game is edited on the main thread.
+    private static func makeWorld(id: UUID, companyName: String, balance: Double, from store: SaveStore) throws -> World {
+        if let data = try store.worldState(for: id) {
+            return try World.decode(data)
+        }
+        return World.generate(seed: id, playerCompanyName: companyName, startingBalance: balance)
+    }
+
+    /// Parses "<quantity> <good>" in either language.
+    private func parseTrade(_ input: String) throws -> (Good, Double) {
+        guard currentGame?.gameStatus == .active else {
+            throw GameManagerError.noActiveGame
+        }
+
+        let trimmed = input.trimmingCharacters(in: .whitespacesAndNewlines)
+        let components = trimmed.split(separator: " ", maxSplits: 1, omittingEmptySubsequences: true)
+        guard components.count == 2,
+              let quantity = Double(components[0]), quantity > 0, quantity.isFinite,
+              let good = localization.good(named: String(components[1])) else {
+            throw GameManagerError.invalidTradeArguments(trimmed)
+        }
+
+        return (good, quantity)
     }
 }
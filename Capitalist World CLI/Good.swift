@@ -0,0 +1,44 @@
+import Foundation
+
+enum Good: Int, CaseIterable, Codable {
+    case grain
+    case coal
+    case lumber
+    case textiles
+    case steel
+    case oil
+
+    var key: String {
+        switch self {
+        case .grain:
+            return "good.grain"
+        case .coal:
+            return "good.coal"
+        case .lumber:
+            return "good.lumber"
+        case .textiles:
+            return "good.textiles"
+        case .steel:
+            return "good.steel"
+        case .oil:
+            return "good.oil"
+        }
+    }
+
+    var basePrice: Double {
+        switch self {
+        case .grain:
+            return 12
+        case .coal:
+            return 18
+        case .lumber:
+            return 25
+        case .textiles:
+            return 40
+        case .steel:
+            return 65
+        case .oil:
+            return 90
+        }
+    }
+}
@@ -0,0 +1,276 @@
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace {
+constexpr int kSchemaVersion = 1;
+// Rows bound per multi-row INSERT. Six parameters each stays under the
+// 999-parameter limit of older SQLite builds.
+constexpr int kRowsPerInsert = 128;
+constexpr int64_t kMmapBytes = 256ll << 20;
+constexpr int kCacheKibibytes = 16 << 10;
+
+// Both tables are keyed by game first so one game's months are contiguous
+// in the B-tree; WITHOUT ROWID stores rows in that order directly instead
+// of behind a separate rowid index.
+constexpr const char *kSchema = R"sql(
+CREATE TABLE IF NOT EXISTS company_month (
+    game BLOB NOT NULL,
+    day INTEGER NOT NULL,
+    company INTEGER NOT NULL,
+    cash REAL NOT NULL,
+    revenue REAL NOT NULL,
+    costs REAL NOT NULL,
+    PRIMARY KEY (game, day, company)
+) WITHOUT ROWID;
+CREATE TABLE IF NOT EXISTS ledger_month (
+    game BLOB NOT NULL,
+    day INTEGER NOT NULL,
+    revenue REAL NOT NULL,
+    cost_of_goods_sold REAL NOT NULL,
+    subsidiary_income REAL NOT NULL,
+    marketing_expense REAL NOT NULL,
+    PRIMARY KEY (game, day)
+) WITHOUT ROWID;
+)sql";
+
+std::string companyInsertSQL(int rows) {
+    std::string sql = "INSERT OR REPLACE INTO company_month VALUES ";
+    for (int row = 0; row < rows; ++row) {
+        sql += row == 0 ? "(?,?,?,?,?,?)" : ",(?,?,?,?,?,?)";
+    }
+    return sql;
+}
+
+void setError(char *buffer, int32_t capacity, const std::string &message) {
+    if (buffer == nullptr || capacity <= 0) {
+        return;
+    }
+    std::snprintf(buffer, static_cast<size_t>(capacity), "%s", message.c_str());
+}
+
+// Runs a statement to completion and resets it for the next use.
+bool run(sqlite3_stmt *statement) {
+    const int result = sqlite3_step(statement);
+    sqlite3_reset(statement);
+    return result == SQLITE_DONE;
+}
+
+// One connection with every statement prepared up front. Writes of a month
+// go through one transaction, and company rows through multi-row inserts,
+// so a month of thousands of companies costs one WAL sync and a few dozen
+// statement executions.
+struct History {
+    sqlite3 *db = nullptr;
+    sqlite3_stmt *begin = nullptr;
+    sqlite3_stmt *commit = nullptr;
+    sqlite3_stmt *rollback = nullptr;
+    sqlite3_stmt *insertCompanies = nullptr;
+    sqlite3_stmt *insertCompany = nullptr;
+    sqlite3_stmt *insertLedger = nullptr;
+    sqlite3_stmt *selectLedger = nullptr;
+    sqlite3_stmt *deleteCompanies = nullptr;
+    sqlite3_stmt *deleteLedger = nullptr;
+
+    ~History() {
+        for (sqlite3_stmt *statement : {begin, commit, rollback, insertCompanies, insertCompany, insertLedger,
+                                        selectLedger, deleteCompanies, deleteLedger}) {
+            sqlite3_finalize(statement);
+        }
+        sqlite3_close(db);
+    }
+
+    bool prepare(const std::string &sql, sqlite3_stmt *&statement) {
+        return sqlite3_prepare_v3(db, sql.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &statement, nullptr) == SQLITE_OK;
+    }
+
+    // WAL lets the prompt read history while a month is written, and
+    // `synchronous=NORMAL` syncs only at checkpoints: a power loss can
+    // drop the latest months but never corrupts the database.
+    bool configure() {
+        const std::string pragmas = "PRAGMA journal_mode=WAL;"
+                                    "PRAGMA synchronous=NORMAL;"
+                                    "PRAGMA temp_store=MEMORY;"
+                                    "PRAGMA mmap_size=" +
+                                    std::to_string(kMmapBytes) +
+                                    ";"
+                                    "PRAGMA cache_size=-" +
+                                    std::to_string(kCacheKibibytes) + ";";
+        if (sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return false;
+        }
+
+        sqlite3_stmt *version = nullptr;
+        if (!prepare("PRAGMA user_version", version)) {
+            return false;
+        }
+        const int current = sqlite3_step(version) == SQLITE_ROW ? sqlite3_column_int(version, 0) : -1;
+        sqlite3_finalize(version);
+        if (current < 0 || current > kSchemaVersion) {
+            return false;
+        }
+        if (current < kSchemaVersion) {
+            const std::string migrate =
+                std::string("BEGIN;") + kSchema + "PRAGMA user_version=" + std::to_string(kSchemaVersion) + ";COMMIT;";
+            if (sqlite3_exec(db, migrate.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+                return false;
+            }
+        }
+
+        return prepare("BEGIN IMMEDIATE", begin) && prepare("COMMIT", commit) && prepare("ROLLBACK", rollback) &&
+               prepare(companyInsertSQL(kRowsPerInsert), insertCompanies) &&
+               prepare(companyInsertSQL(1), insertCompany) &&
+               prepare("INSERT OR REPLACE INTO ledger_month VALUES (?,?,?,?,?,?)", insertLedger) &&
+               prepare("SELECT day, revenue, cost_of_goods_sold, subsidiary_income, marketing_expense "
+                       "FROM ledger_month WHERE game = ? ORDER BY day DESC LIMIT ?",
+                       selectLedger) &&
+               prepare("DELETE FROM company_month WHERE game = ?", deleteCompanies) &&
+               prepare("DELETE FROM ledger_month WHERE game = ?", deleteLedger);
+    }
+
+    // Binds rows [first, first + count) starting at parameter 1 and runs
+    // `statement`.
+    static bool insertRows(sqlite3_stmt *statement,
+                           const uint8_t *game,
+                           int32_t day,
+                           const int64_t *companies,
+                           const double *cash,
+                           const double *revenue,
+                           const double *costs,
+                           int32_t first,
+                           int32_t count) {
+        int parameter = 1;
+        for (int32_t row = first; row < first + count; ++row) {
+            sqlite3_bind_blob(statement, parameter++, game, 16, SQLITE_STATIC);
+            sqlite3_bind_int(statement, parameter++, day);
+            sqlite3_bind_int64(statement, parameter++, companies[row]);
+            sqlite3_bind_double(statement, parameter++, cash[row]);
+            sqlite3_bind_double(statement, parameter++, revenue[row]);
+            sqlite3_bind_double(statement, parameter++, costs[row]);
+        }
+        return run(statement);
+    }
+};
+
+History *asHistory(void *handle) {
+    return static_cast<History *>(handle);
+}
+}  // namespace
+
+extern "C" void *HistoryStoreOpen(const char *path, char *errorBuffer, int32_t errorCapacity) {
+    auto history = std::make_unique<History>();
+    const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(path, &history->db, flags, nullptr) != SQLITE_OK || !history->configure()) {
+        setError(errorBuffer, errorCapacity, std::string(path) + ": " + sqlite3_errmsg(history->db));
+        return nullptr;
+    }
+    return history.release();
+}
+
+extern "C" void HistoryStoreClose(void *handle) {
+    delete asHistory(handle);
+}
+
+// Records the month ending on `day` for game `id`: one row per company and
+// the player's cumulative ledger, replacing rows a reloaded game wrote for
+// the same day. All or nothing in one transaction. Returns 0 or -1.
+extern "C" int32_t HistoryStoreRecordMonth(void *handle,
+                                           const uint8_t *id,
+                                           int32_t day,
+                                           int32_t companyCount,
+                                           const int64_t *companies,
+                                           const double *cash,
+                                           const double *revenue,
+                                           const double *costs,
+                                           double ledgerRevenue,
+                                           double costOfGoodsSold,
+                                           double subsidiaryIncome,
+                                           double marketingExpense) {
+    History *history = asHistory(handle);
+    if (history == nullptr || !run(history->begin)) {
+        return -1;
+    }
+
+    bool ok = true;
+    int32_t row = 0;
+    for (; ok && companyCount - row >= kRowsPerInsert; row += kRowsPerInsert) {
+        ok = History::insertRows(history->insertCompanies, id, day, companies, cash, revenue, costs, row, kRowsPerInsert);
+    }
+    for (; ok && row < companyCount; ++row) {
+        ok = History::insertRows(history->insertCompany, id, day, companies, cash, revenue, costs, row, 1);
+    }
+
+    if (ok) {
+        sqlite3_stmt *ledger = history->insertLedger;
+        sqlite3_bind_blob(ledger, 1, id, 16, SQLITE_STATIC);
+        sqlite3_bind_int(ledger, 2, day);
+        sqlite3_bind_double(ledger, 3, ledgerRevenue);
+        sqlite3_bind_double(ledger, 4, costOfGoodsSold);
+        sqlite3_bind_double(ledger, 5, subsidiaryIncome);
+        sqlite3_bind_double(ledger, 6, marketingExpense);
+        ok = run(ledger) && run(history->commit);
+    }
+    if (!ok) {
+        run(history->rollback);
+        return -1;
+    }
+    return 0;
+}
+
+// Deletes every month of the `count` games whose 16-byte IDs are packed in
+// `ids`, in one transaction. Returns 0 or -1.
+extern "C" int32_t HistoryStoreDrop(void *handle, const uint8_t *ids, int32_t count) {
+    History *history = asHistory(handle);
+    if (history == nullptr || !run(history->begin)) {
+        return -1;
+    }
+
+    bool ok = true;
+    for (int32_t index = 0; ok && index < count; ++index) {
+        const uint8_t *id = ids + static_cast<size_t>(index) * 16;
+        for (sqlite3_stmt *statement : {history->deleteCompanies, history->deleteLedger}) {
+            sqlite3_bind_blob(statement, 1, id, 16, SQLITE_STATIC);
+            ok = ok && run(statement);
+        }
+    }
+    if (!ok || !run(history->commit)) {
+        run(history->rollback);
+        return -1;
+    }
+    return 0;
+}
+
+// Fills up to `limit` ledger rows of game `id`, latest month first.
+// Returns the number of rows, or -1 on error.
+extern "C" int32_t HistoryStoreLedger(void *handle,
+                                      const uint8_t *id,
+                                      int32_t limit,
+                                      int32_t *days,
+                                      double *revenue,
+                                      double *costOfGoodsSold,
+                                      double *subsidiaryIncome,
+                                      double *marketingExpense) {
+    History *history = asHistory(handle);
+    if (history == nullptr) {
+        return -1;
+    }
+
+    sqlite3_stmt *select = history->selectLedger;
+    sqlite3_bind_blob(select, 1, id, 16, SQLITE_STATIC);
+    sqlite3_bind_int(select, 2, limit);
+    int32_t count = 0;
+    int result = SQLITE_ROW;
+    while (count < limit && (result = sqlite3_step(select)) == SQLITE_ROW) {
+        days[count] = sqlite3_column_int(select, 0);
+        revenue[count] = sqlite3_column_double(select, 1);
+        costOfGoodsSold[count] = sqlite3_column_double(select, 2);
+        subsidiaryIncome[count] = sqlite3_column_double(select, 3);
+        marketingExpense[count] = sqlite3_column_double(select, 4);
+        ++count;
+    }
+    sqlite3_reset(select);
+    return result == SQLITE_ROW || result == SQLITE_DONE ? count : -1;
+}
@@ -0,0 +1,201 @@
+import Foundation
+
+@_silgen_name("HistoryStoreOpen")
+private func HistoryStoreOpen(
+    _ path: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> OpaquePointer?
+@_silgen_name("HistoryStoreClose")
+private func HistoryStoreClose(_ handle: OpaquePointer)
+@_silgen_name("HistoryStoreRecordMonth")
+private func HistoryStoreRecordMonth(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ day: Int32,
+    _ companyCount: Int32,
+    _ companies: UnsafePointer<Int64>,
+    _ cash: UnsafePointer<Double>,
+    _ revenue: UnsafePointer<Double>,
+    _ costs: UnsafePointer<Double>,
+    _ ledgerRevenue: Double,
+    _ costOfGoodsSold: Double,
+    _ subsidiaryIncome: Double,
+    _ marketingExpense: Double
+) -> Int32
+@_silgen_name("HistoryStoreLedger")
+private func HistoryStoreLedger(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ limit: Int32,
+    _ days: UnsafeMutablePointer<Int32>,
+    _ revenue: UnsafeMutablePointer<Double>,
+    _ costOfGoodsSold: UnsafeMutablePointer<Double>,
+    _ subsidiaryIncome: UnsafeMutablePointer<Double>,
+    _ marketingExpense: UnsafeMutablePointer<Double>
+) -> Int32
+@_silgen_name("HistoryStoreDrop")
+private func HistoryStoreDrop(_ handle: OpaquePointer, _ ids: UnsafePointer<UInt8>, _ count: Int32) -> Int32
+
+enum HistoryStoreError: LocalizedError {
+    case unavailable(String)
+
+    var errorDescription: String? {
+        switch self {
+        case .unavailable(let reason):
+            return Localization.shared.historyUnavailableMessage(reason)
+        }
+    }
+}
+
+/// Month-end history of every game in a SQLite database next to the saves:
+/// each company's cash, revenue and costs, and the player's ledger. Months
+/// are written on a background queue from world forks, one transaction
+/// each, in the order the simulation closed them.
+final class HistoryStore {
+    /// Player results of one month, derived from consecutive cumulative
+    /// ledgers.
+    struct Month {
+        let day: Int
+        let revenue: Double
+        let profit: Double
+    }
+
+    private struct LedgerRow {
+        let day: Int
+        let ledger: World.Ledger
+    }
+
+    private let queue = DispatchQueue(label: "com.capitalistworld.history", qos: .utility)
+    private let path: String
+    private let handle: OpaquePointer?
+    private let openError: String
+    /// Touched only on the history queue.
+    private var gameID: UUID?
+
+    /// Opens `history.sqlite` in `directory`. A database that cannot be
+    /// opened disables history rather than the game.
+    init(directory: URL) {
+        path = directory.appendingPathComponent("history.sqlite").path
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        handle = path.withCString { HistoryStoreOpen($0, &errorBuffer, Int32(errorBuffer.count)) }
+        openError = String(cString: errorBuffer)
+    }
+
+    deinit {
+        if let handle {
+            queue.sync { HistoryStoreClose(handle) }
+        }
+    }
+
+    /// Records months of the game with `id` from now on, or stops with
+    /// `nil`. Waits for months of the previous game to be written.
+    func track(_ id: UUID?) {
+        queue.sync { gameID = id }
+    }
+
+    /// Queues the month that just closed in `world`, which must not be the
+    /// live world. A failed write loses that month only.
+    func record(_ world: World) {
+        queue.async { [weak self] in
+            guard let self, let handle = self.handle, let gameID = self.gameID else { return }
+            let companies = (0..<world.companyCount).map { index -> Int64 in
+                let id = world.companyID(of: index)
+                return Int64(id.slot) << 32 | Int64(id.generation)
+            }
+            let cash = Array(world.companyCash)
+            let revenue = Array(world.companyRevenue)
+            let costs = Array(world.companyCosts)
+            let ledger = world.ledger
+
+            _ = withUnsafeBytes(of: gameID.uuid) { idBytes in
+                HistoryStoreRecordMonth(
+                    handle,
+                    idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                    Int32(world.day),
+                    Int32(companies.count),
+                    companies,
+                    cash,
+                    revenue,
+                    costs,
+                    ledger.revenue,
+                    ledger.costOfGoodsSold,
+                    ledger.subsidiaryIncome,
+                    ledger.marketingExpense
+                )
+            }
+        }
+    }
+
+    /// Queues deletion of every month of `ids`, after any month of them
+    /// still queued. A failed delete leaves those months behind.
+    func drop(_ ids: [UUID]) {
+        guard handle != nil, ids.isEmpty == false else { return }
+        queue.async { [weak self] in
+            guard let self, let handle = self.handle else { return }
+            let packed = ids.flatMap { id in withUnsafeBytes(of: id.uuid) { Array($0) } }
+            _ = HistoryStoreDrop(handle, packed, Int32(ids.count))
+        }
+    }
+
+    /// Up to `count` most recent closed months of the game with `id`,
+    /// latest first. Includes months still queued for writing.
+    func months(of id: UUID, count: Int) throws -> [Month] {
+        guard let handle else {
+            throw HistoryStoreError.unavailable(openError)
+        }
+
+        // One extra row gives the oldest month its opening ledger. Only the
+        // first month of a game opens from zero; any other month without a
+        // predecessor predates history and is left out.
+        let rows = try queue.sync { try ledgerRows(handle, id: id, limit: count + 1) }
+        return rows.indices.prefix(count).compactMap { index in
+            let opening: World.Ledger
+            if index + 1 < rows.count {
+                opening = rows[index + 1].ledger
+            } else if rows[index].day <= World.daysPerMonth {
+                opening = World.Ledger()
+            } else {
+                return nil
+            }
+            let closing = rows[index].ledger
+            return Month(
+                day: rows[index].day,
+                revenue: closing.revenue - opening.revenue,
+                profit: closing.profit - opening.profit
+            )
+        }
+    }
+
+    private func ledgerRows(_ handle: OpaquePointer, id: UUID, limit: Int) throws -> [LedgerRow] {
+        var days = [Int32](repeating: 0, count: limit)
+        var revenue = [Double](repeating: 0, count: limit)
+        var costOfGoodsSold = [Double](repeating: 0, count: limit)
+        var subsidiaryIncome = [Double](repeating: 0, count: limit)
+        var marketingExpense = [Double](repeating: 0, count: limit)
+        let count = withUnsafeBytes(of: id.uuid) { idBytes in
+            HistoryStoreLedger(
+                handle,
+                idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                Int32(limit),
+                &days,
+                &revenue,
+                &costOfGoodsSold,
+                &subsidiaryIncome,
+                &marketingExpense
+            )
+        }
+        guard count >= 0 else {
+            throw HistoryStoreError.unavailable(path)
+        }
+
+        return (0..<Int(count)).map { row in
+            var ledger = World.Ledger()
+            ledger.revenue = revenue[row]
+            ledger.costOfGoodsSold = costOfGoodsSold[row]
+            ledger.subsidiaryIncome = subsidiaryIncome[row]
+            ledger.marketingExpense = marketingExpense[row]
+            return LedgerRow(day: Int(days[row]), ledger: ledger)
+        }
+    }
+}
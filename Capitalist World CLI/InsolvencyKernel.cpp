@@ -0,0 +1,40 @@
+#include <cstdint>
+
+// Scans one chunk of the company arrays for firms whose cash plus credit
+// line is exhausted. Only independent firms (owner < 0) can fail; owned
+// companies pass their results to their parent. The test is evaluated
+// branch-free for every lane and the survivors are compressed afterwards,
+// so the loop vectorizes. Writes the absolute indices (`baseIndex` +
+// offset) of insolvent firms to `insolvent` and returns how many.
+extern "C" int32_t FindInsolventCompanies(const double *__restrict cash,
+                                          const double *__restrict creditLimit,
+                                          const int32_t *__restrict owner,
+                                          int32_t count,
+                                          int32_t baseIndex,
+                                          int32_t *__restrict insolvent) {
+    constexpr int32_t kBlock = 64;
+    uint8_t flags[kBlock];
+    int32_t found = 0;
+
+    for (int32_t blockStart = 0; blockStart < count; blockStart += kBlock) {
+        const int32_t blockCount = count - blockStart < kBlock ? count - blockStart : kBlock;
+
+        uint8_t any = 0;
+        for (int32_t lane = 0; lane < blockCount; ++lane) {
+            const int32_t index = blockStart + lane;
+            const uint8_t failed = static_cast<uint8_t>((cash[index] + creditLimit[index] < 0.0) & (owner[index] < 0));
+            flags[lane] = failed;
+            any |= failed;
+        }
+
+        if (any == 0) {
+            continue;
+        }
+        for (int32_t lane = 0; lane < blockCount; ++lane) {
+            if (flags[lane] != 0) {
+                insolvent[found++] = baseIndex + blockStart + lane;
+            }
+        }
+    }
+    return found;
+}
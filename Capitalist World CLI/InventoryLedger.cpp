@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace {
+enum class CostingMethod : int32_t {
+    fifo = 0,
+    weightedAverage = 1,
+};
+
+constexpr int32_t kNoLayer = -1;
+constexpr double kQuantityEpsilon = 1e-9;
+// Pairs are stored in chunks of this many, each with its own lot pool, so
+// a clone shares every chunk and a batch copies only the chunks it writes.
+constexpr int32_t kPairChunkShift = 10;
+constexpr int32_t kPairChunkMask = (1 << kPairChunkShift) - 1;
+
+// One receipt lot. Lots of every SKU-location pair in a chunk share the
+// chunk's pool and are chained into per-pair FIFO queues, so receiving
+// stock never allocates once the pool has grown to its working size.
+struct CostLayer {
+    double quantity;
+    double unitCost;
+    int32_t next;
+};
+
+struct PairState {
+    int32_t head = kNoLayer;
+    int32_t tail = kNoLayer;
+    double quantity = 0;
+    double totalCost = 0;
+};
+
+struct PairChunk {
+    std::vector<PairState> pairs;
+    std::vector<CostLayer> layers;
+    int32_t freeList = kNoLayer;
+    int32_t activeLayers = 0;
+
+    int32_t allocateLayer(double quantity, double unitCost) {
+        ++activeLayers;
+        if (freeList != kNoLayer) {
+            const int32_t index = freeList;
+            freeList = layers[index].next;
+            layers[index] = CostLayer{quantity, unitCost, kNoLayer};
+            return index;
+        }
+        layers.push_back(CostLayer{quantity, unitCost, kNoLayer});
+        return static_cast<int32_t>(layers.size() - 1);
+    }
+
+    void releaseLayer(int32_t index) {
+        --activeLayers;
+        layers[index].next = freeList;
+        freeList = index;
+    }
+
+    void receive(CostingMethod method, PairState &state, double quantity, double unitCost) {
+        state.quantity += quantity;
+        state.totalCost += quantity * unitCost;
+
+        if (method != CostingMethod::fifo) {
+            return;
+        }
+
+        if (state.tail != kNoLayer && layers[state.tail].unitCost == unitCost) {
+            layers[state.tail].quantity += quantity;
+            return;
+        }
+
+        const int32_t layer = allocateLayer(quantity, unitCost);
+        if (state.tail == kNoLayer) {
+            state.head = layer;
+        } else {
+            layers[state.tail].next = layer;
+        }
+        state.tail = layer;
+    }
+
+    double issue(CostingMethod method, PairState &state, double quantity) {
+        quantity = std::min(quantity, state.quantity);
+        if (quantity <= 0) {
+            return 0;
+        }
+
+        double cost = 0;
+        if (method == CostingMethod::weightedAverage) {
+            cost = state.totalCost * (quantity / state.quantity);
+        } else {
+            double remaining = quantity;
+            while (remaining > kQuantityEpsilon && state.head != kNoLayer) {
+                CostLayer &layer = layers[state.head];
+                const double taken = std::min(remaining, layer.quantity);
+                cost += taken * layer.unitCost;
+                layer.quantity -= taken;
+                remaining -= taken;
+
+                if (layer.quantity <= kQuantityEpsilon) {
+                    const int32_t exhausted = state.head;
+                    state.head = layer.next;
+                    releaseLayer(exhausted);
+                }
+            }
+            if (state.head == kNoLayer) {
+                state.tail = kNoLayer;
+            }
+        }
+
+        state.quantity -= quantity;
+        state.totalCost -= cost;
+        if (state.quantity <= kQuantityEpsilon) {
+            state.quantity = 0;
+            state.totalCost = 0;
+        }
+        return cost;
+    }
+};
+
+// Chunks are immutable while shared: clones hold the same chunks, and the
+// first batch that writes to a shared chunk replaces it with a private copy.
+struct Inventory {
+    CostingMethod method = CostingMethod::fifo;
+    int32_t pairCount = 0;
+    std::vector<std::shared_ptr<PairChunk>> chunks;
+    std::vector<int32_t> order;
+
+    const PairState *pair(int32_t index) const {
+        if (index < 0 || index >= pairCount) {
+            return nullptr;
+        }
+        const PairChunk &chunk = *chunks[static_cast<size_t>(index >> kPairChunkShift)];
+        return &chunk.pairs[static_cast<size_t>(index & kPairChunkMask)];
+    }
+
+    // Chunk `index`, copied first if another inventory shares it. A count
+    // of one means no other inventory can reach the chunk any more; the
+    // fence orders this side's writes after the reads the last other owner
+    // made before releasing it.
+    PairChunk &writableChunk(size_t index) {
+        std::shared_ptr<PairChunk> &chunk = chunks[index];
+        if (chunk.use_count() > 1) {
+            chunk = std::make_shared<PairChunk>(*chunk);
+        } else {
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *chunk;
+    }
+
+    // Visits batch lines grouped by pair while keeping submission order
+    // within a pair, which FIFO layering depends on. Only the chunks of the
+    // pairs visited are made writable.
+    template <typename Visitor>
+    void visitByPair(const int32_t *pairIndices, int32_t count, Visitor visit) {
+        order.resize(static_cast<size_t>(count));
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [pairIndices](int32_t lhs, int32_t rhs) {
+            return pairIndices[lhs] < pairIndices[rhs];
+        });
+        PairChunk *chunk = nullptr;
+        int32_t chunkIndex = -1;
+        for (const int32_t line : order) {
+            const int32_t pair = pairIndices[line];
+            if (pair < 0 || pair >= pairCount) {
+                continue;
+            }
+            if (pair >> kPairChunkShift != chunkIndex) {
+                chunkIndex = pair >> kPairChunkShift;
+                chunk = &writableChunk(static_cast<size_t>(chunkIndex));
+            }
+            visit(line, *chunk, chunk->pairs[static_cast<size_t>(pair & kPairChunkMask)]);
+        }
+    }
+};
+
+Inventory *asInventory(void *handle) {
+    return static_cast<Inventory *>(handle);
+}
+}  // namespace
+
+extern "C" void *InventoryCreate(int32_t costingMethod, int32_t pairCount) {
+    auto *inventory = new Inventory();
+    inventory->method = costingMethod == static_cast<int32_t>(CostingMethod::weightedAverage)
+                            ? CostingMethod::weightedAverage
+                            : CostingMethod::fifo;
+    inventory->pairCount = std::max(pairCount, 0);
+    for (int32_t first = 0; first < inventory->pairCount; first += kPairChunkMask + 1) {
+        auto chunk = std::make_shared<PairChunk>();
+        chunk->pairs.resize(static_cast<size_t>(std::min(kPairChunkMask + 1, inventory->pairCount - first)));
+        inventory->chunks.push_back(std::move(chunk));
+    }
+    return inventory;
+}
+
+// Clone used when a forked world first writes to its inventory. Shares
+// every chunk with `handle`; each side copies a chunk when it first writes
+// to it, so cloning costs one reference per chunk.
+extern "C" void *InventoryClone(void *handle) {
+    Inventory *inventory = asInventory(handle);
+    if (inventory == nullptr) {
+        return nullptr;
+    }
+    auto *clone = new Inventory();
+    clone->method = inventory->method;
+    clone->pairCount = inventory->pairCount;
+    clone->chunks = inventory->chunks;
+    return clone;
+}
+
+extern "C" void InventoryDestroy(void *handle) {
+    delete asInventory(handle);
+}
+
+extern "C" void InventoryApplyReceipts(void *handle,
+                                       const int32_t *pairIndices,
+                                       const double *quantities,
+                                       const double *unitCosts,
+                                       int32_t count) {
+    Inventory *inventory = asInventory(handle);
+    if (inventory == nullptr || count <= 0) {
+        return;
+    }
+
+    inventory->visitByPair(pairIndices, count, [&](int32_t line, PairChunk &chunk, PairState &state) {
+        if (quantities[line] > 0) {
+            chunk.receive(inventory->method, state, quantities[line], unitCosts[line]);
+        }
+    });
+}
+
+// Issues stock and returns the total cost of goods issued. Lines asking for
+// more than is on hand issue what is available. `issuedCosts` may be null.
+extern "C" double InventoryApplyIssues(void *handle,
+                                       const int32_t *pairIndices,
+                                       const double *quantities,
+                                       int32_t count,
+                                       double *issuedCosts) {
+    Inventory *inventory = asInventory(handle);
+    if (inventory == nullptr || count <= 0) {
+        return 0;
+    }
+
+    double total = 0;
+    inventory->visitByPair(pairIndices, count, [&](int32_t line, PairChunk &chunk, PairState &state) {
+        const double cost = chunk.issue(inventory->method, state, quantities[line]);
+        if (issuedCosts != nullptr) {
+            issuedCosts[line] = cost;
+        }
+        total += cost;
+    });
+    return total;
+}
+
+extern "C" double InventoryOnHand(void *handle, int32_t pairIndex) {
+    Inventory *inventory = asInventory(handle);
+    const PairState *state = inventory == nullptr ? nullptr : inventory->pair(pairIndex);
+    return state == nullptr ? 0 : state->quantity;
+}
+
+extern "C" double InventoryCarryingValue(void *handle, int32_t pairIndex) {
+    Inventory *inventory = asInventory(handle);
+    const PairState *state = inventory == nullptr ? nullptr : inventory->pair(pairIndex);
+    return state == nullptr ? 0 : state->totalCost;
+}
+
+// Number of records `InventoryExportLayers` will produce.
+extern "C" int32_t InventoryLayerCount(void *handle) {
+    Inventory *inventory = asInventory(handle);
+    if (inventory == nullptr) {
+        return 0;
+    }
+    int32_t count = 0;
+    for (const auto &chunk : inventory->chunks) {
+        if (inventory->method == CostingMethod::fifo) {
+            count += chunk->activeLayers;
+            continue;
+        }
+        count += static_cast<int32_t>(std::count_if(chunk->pairs.begin(), chunk->pairs.end(), [](const PairState &state) {
+            return state.quantity > 0;
+        }));
+    }
+    return count;
+}
+
+// Writes every cost layer, oldest first within each pair, so replaying the
+// records as receipts rebuilds an identical inventory. Weighted-average
+// inventories export one record per pair at its average cost.
+extern "C" int32_t InventoryExportLayers(void *handle,
+                                         int32_t *pairIndices,
+                                         double *quantities,
+                                         double *unitCosts,
+                                         int32_t capacity) {
+    Inventory *inventory = asInventory(handle);
+    if (inventory == nullptr) {
+        return 0;
+    }
+
+    int32_t written = 0;
+    for (int32_t pair = 0; pair < inventory->pairCount && written < capacity; ++pair) {
+        const PairChunk &chunk = *inventory->chunks[static_cast<size_t>(pair >> kPairChunkShift)];
+        const PairState &state = chunk.pairs[static_cast<size_t>(pair & kPairChunkMask)];
+        if (state.quantity <= 0) {
+            continue;
+        }
+
+        if (inventory->method == CostingMethod::weightedAverage) {
+            pairIndices[written] = pair;
+            quantities[written] = state.quantity;
+            unitCosts[written] = state.totalCost / state.quantity;
+            ++written;
+            continue;
+        }
+
+        for (int32_t layer = state.head; layer != kNoLayer && written < capacity; layer = chunk.layers[layer].next) {
+            pairIndices[written] = pair;
+            quantities[written] = chunk.layers[layer].quantity;
+            unitCosts[written] = chunk.layers[layer].unitCost;
+            ++written;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,194 @@
+import Foundation
+
+@_silgen_name("InventoryCreate")
+private func InventoryCreate(_ costingMethod: Int32, _ pairCount: Int32) -> OpaquePointer
+@_silgen_name("InventoryClone")
+private func InventoryClone(_ handle: OpaquePointer) -> OpaquePointer
+@_silgen_name("InventoryDestroy")
+private func InventoryDestroy(_ handle: OpaquePointer)
+@_silgen_name("InventoryApplyReceipts")
+private func InventoryApplyReceipts(
+    _ handle: OpaquePointer,
+    _ pairIndices: UnsafePointer<Int32>,
+    _ quantities: UnsafePointer<Double>,
+    _ unitCosts: UnsafePointer<Double>,
+    _ count: Int32
+)
+@_silgen_name("InventoryApplyIssues")
+private func InventoryApplyIssues(
+    _ handle: OpaquePointer,
+    _ pairIndices: UnsafePointer<Int32>,
+    _ quantities: UnsafePointer<Double>,
+    _ count: Int32,
+    _ issuedCosts: UnsafeMutablePointer<Double>?
+) -> Double
+@_silgen_name("InventoryOnHand")
+private func InventoryOnHand(_ handle: OpaquePointer, _ pairIndex: Int32) -> Double
+@_silgen_name("InventoryCarryingValue")
+private func InventoryCarryingValue(_ handle: OpaquePointer, _ pairIndex: Int32) -> Double
+@_silgen_name("InventoryLayerCount")
+private func InventoryLayerCount(_ handle: OpaquePointer) -> Int32
+@_silgen_name("InventoryExportLayers")
+private func InventoryExportLayers(
+    _ handle: OpaquePointer,
+    _ pairIndices: UnsafeMutablePointer<Int32>,
+    _ quantities: UnsafeMutablePointer<Double>,
+    _ unitCosts: UnsafeMutablePointer<Double>,
+    _ capacity: Int32
+) -> Int32
+
+/// Physical stock per SKU-location pair (warehouse × good) with FIFO or
+/// weighted-average costing. Movements are queued during the day and applied
+/// to the cost layers in one batch by `processDailyBatch()`.
+final class InventoryLedger {
+    /// Owns the native inventory. Forks share one handle until either side
+    /// applies a batch, at which point the writer clones it. The native side
+    /// keeps pairs in chunks shared between clones, so the clone copies
+    /// only the chunks that batch writes.
+    private final class Handle {
+        let pointer: OpaquePointer
+
+        init(_ pointer: OpaquePointer) {
+            self.pointer = pointer
+        }
+
+        deinit {
+            InventoryDestroy(pointer)
+        }
+    }
+
+    enum CostingMethod: Int32, Codable {
+        case fifo = 0
+        case weightedAverage = 1
+    }
+
+    struct Layer: Codable {
+        let pair: Int32
+        let quantity: Double
+        let unitCost: Double
+    }
+
+    let method: CostingMethod
+    let pairCount: Int
+
+    private var storage: Handle
+    private var handle: OpaquePointer { storage.pointer }
+    private var receiptPairs: [Int32] = []
+    private var receiptQuantities: [Double] = []
+    private var receiptCosts: [Double] = []
+    private var issuePairs: [Int32] = []
+    private var issueQuantities: [Double] = []
+    private var pendingDelta: [Int32: Double] = [:]
+
+    init(method: CostingMethod, pairCount: Int, layers: [Layer] = []) {
+        self.method = method
+        self.pairCount = pairCount
+        storage = Handle(InventoryCreate(method.rawValue, Int32(pairCount)))
+
+        layers.forEach { queueReceipt(pair: Int($0.pair), quantity: $0.quantity, unitCost: $0.unitCost) }
+        _ = processDailyBatch()
+    }
+
+    private init(forking source: InventoryLedger) {
+        method = source.method
+        pairCount = source.pairCount
+        storage = source.storage
+        receiptPairs = source.receiptPairs
+        receiptQuantities = source.receiptQuantities
+        receiptCosts = source.receiptCosts
+        issuePairs = source.issuePairs
+        issueQuantities = source.issueQuantities
+        pendingDelta = source.pendingDelta
+    }
+
+    /// O(1) fork; the first batch applied by either copy clones the chunk
+    /// table and copies the chunks of the pairs it moves.
+    func fork() -> InventoryLedger {
+        InventoryLedger(forking: self)
+    }
+
+    func queueReceipt(pair: Int, quantity: Double, unitCost: Double) {
+        receiptPairs.append(Int32(pair))
+        receiptQuantities.append(quantity)
+        receiptCosts.append(unitCost)
+        pendingDelta[Int32(pair), default: 0] += quantity
+    }
+
+    func queueIssue(pair: Int, quantity: Double) {
+        issuePairs.append(Int32(pair))
+        issueQuantities.append(quantity)
+        pendingDelta[Int32(pair), default: 0] -= quantity
+    }
+
+    /// On-hand quantity including movements queued for today's batch.
+    func availableQuantity(pair: Int) -> Double {
+        InventoryOnHand(handle, Int32(pair)) + (pendingDelta[Int32(pair)] ?? 0)
+    }
+
+    func carryingValue(pair: Int) -> Double {
+        InventoryCarryingValue(handle, Int32(pair))
+    }
+
+    /// Applies queued receipts, then issues, and returns the cost of goods
+    /// issued.
+    @discardableResult
+    func processDailyBatch() -> Double {
+        if receiptPairs.isEmpty == false || issuePairs.isEmpty == false,
+           isKnownUniquelyReferenced(&storage) == false {
+            storage = Handle(InventoryClone(handle))
+        }
+
+        if receiptPairs.isEmpty == false {
+            receiptPairs.withUnsafeBufferPointer { pairs in
+                receiptQuantities.withUnsafeBufferPointer { quantities in
+                    receiptCosts.withUnsafeBufferPointer { costs in
+                        InventoryApplyReceipts(handle, pairs.baseAddress!, quantities.baseAddress!, costs.baseAddress!, Int32(pairs.count))
+                    }
+                }
+            }
+        }
+
+        var costOfGoods = 0.0
+        if issuePairs.isEmpty == false {
+            costOfGoods = issuePairs.withUnsafeBufferPointer { pairs in
+                issueQuantities.withUnsafeBufferPointer { quantities in
+                    InventoryApplyIssues(handle, pairs.baseAddress!, quantities.baseAddress!, Int32(pairs.count), nil)
+                }
+            }
+        }
+
+        receiptPairs.removeAll(keepingCapacity: true)
+        receiptQuantities.removeAll(keepingCapacity: true)
+        receiptCosts.removeAll(keepingCapacity: true)
+        issuePairs.removeAll(keepingCapacity: true)
+        issueQuantities.removeAll(keepingCapacity: true)
+        pendingDelta.removeAll(keepingCapacity: true)
+        return costOfGoods
+    }
+
+    /// Cost layers in FIFO order. Queued movements are not included; callers
+    /// flush the batch first.
+    func exportLayers() -> [Layer] {
+        let capacity = Int(InventoryLayerCount(handle))
+        guard capacity > 0 else { return [] }
+
+        var pairs = [Int32](repeating: 0, count: capacity)
+        var quantities = [Double](repeating: 0, count: capacity)
+        var costs = [Double](repeating: 0, count: capacity)
+        let written = pairs.withUnsafeMutableBufferPointer { pairBuffer in
+            quantities.withUnsafeMutableBufferPointer { quantityBuffer in
+                costs.withUnsafeMutableBufferPointer { costBuffer in
+                    InventoryExportLayers(
+                        handle,
+                        pairBuffer.baseAddress!,
+                        quantityBuffer.baseAddress!,
+                        costBuffer.baseAddress!,
+                        Int32(capacity)
+                    )
+                }
+            }
+        }
+
+        return (0..<Int(written)).map { Layer(pair: pairs[$0], quantity: quantities[$0], unitCost: costs[$0]) }
+    }
+}
@@ -4,10 +4,26 @@ enum CommandIdentifier: CaseIterable {
     case help
     case start
     case save
+    case autosave
     case abandon
     case list
     case load
+    case exportGame
+    case importGame
+    case maintain
     case speed
+    case acquire
+    case inventory
+    case order
+    case sell
+    case forecast
+    case campaign
+    case achievements
+    case history
+    case snapshots
+    case profile
+    case sandbox
+    case scenario
     case exit
 
     var key: String {
@@ -18,14 +34,46 @@ enum CommandIdentifier: CaseIterable {
             return "command.start"
         case .save:
             return "command.save"
+        case .autosave:
+            return "command.autosave"
         case .abandon:
             return "command.abandon"
         case .list:
             return "command.list"
         case .load:
             return "command.load"
+        case .exportGame:
+            return "command.export"
+        case .importGame:
+            return "command.import"
+        case .maintain:
+            return "command.maintain"
         case .speed:
             return "command.speed"
+        case .acquire:
+            return "command.acquire"
+        case .inventory:
+            return "command.inventory"
+        case .order:
+            return "command.order"
+        case .sell:
+            return "command.sell"
+        case .forecast:
+            return "command.forecast"
+        case .campaign:
+            return "command.campaign"
+        case .achievements:
+            return "command.achievements"
+        case .history:
+            return "command.history"
+        case .snapshots:
+            return "command.snapshots"
+        case .profile:
+            return "command.profile"
+        case .sandbox:
+            return "command.sandbox"
+        case .scenario:
+            return "command.scenario"
         case .exit:
             return "command.exit"
         }
@@ -70,6 +118,7 @@ final class Localization {
     private let locale: Locale
     private let isoFormatter: ISO8601DateFormatter
     private let currencyFormatter: NumberFormatter
+    private let quantityFormatter: NumberFormatter
     private let catalog: [String: [String: String]]
 
     private init() {
@@ -98,6 +147,11 @@ final class Localization {
         currencyFormatter.maximumFractionDigits = 0
         currencyFormatter.minimumFractionDigits = 0
 
+        quantityFormatter = NumberFormatter()
+        quantityFormatter.locale = locale
+        quantityFormatter.numberStyle = .decimal
+        quantityFormatter.maximumFractionDigits = 2
+
         catalog = Localization.loadCatalog()
     }
 
@@ -168,6 +222,11 @@ final class Localization {
         return key
     }
 
+    /// Values of `key` in every catalog language.
+    private func localizedInAllLanguages(_ key: String) -> [String] {
+        Array((catalog[key] ?? [:]).values)
+    }
+
     private func formatted(_ key: String, _ arguments: CVarArg...) -> String {
         let format = localized(key)
         return String(format: format, locale: locale, arguments: arguments)
@@ -185,6 +244,26 @@ final class Localization {
             .filter { $0.isEmpty == false }
     }
 
+    /// Lowercased keywords accepted for a subcommand in any language.
+    func subcommandAliases(_ key: String) -> [String] {
+        localizedInAllLanguages(key)
+            .flatMap { $0.split(separator: ",") }
+            .map { $0.trimmingCharacters(in: .whitespacesAndNewlines).lowercased() }
+            .filter { $0.isEmpty == false }
+    }
+
+    /// Every command keyword in every language, the active language's
+    /// first so it wins should two languages ever share a word.
+    func commandKeywords() -> [(keyword: String, identifier: CommandIdentifier)] {
+        let active = CommandIdentifier.allCases.flatMap { identifier in
+            aliases(for: identifier).map { (keyword: $0, identifier: identifier) }
+        }
+        let others = CommandIdentifier.allCases.flatMap { identifier in
+            subcommandAliases("\(identifier.key).aliases").map { (keyword: $0, identifier: identifier) }
+        }
+        return active + others
+    }
+
     func commandOverviewMessage() -> String {
         let header = localized("command.overview.header")
         let bulletPrefix = localized("command.overview.bulletPrefix")
@@ -243,8 +322,8 @@ final class Localization {
         formatted("game.started", summary)
     }
 
-    func gameSavedMessage(_ summary: String) -> String {
-        formatted("game.saved", summary)
+    func gameSavingMessage(_ summary: String) -> String {
+        formatted("game.saving", summary)
     }
 
     func gameAbandonedMessage() -> String {
@@ -311,15 +390,6 @@ final class Localization {
         formatted("error.noGames", primaryCommandName(for: .start))
     }
 
-    func activeGameInProgressMessage(_ name: String) -> String {
-        formatted(
-            "error.activeGame",
-            name,
-            primaryCommandName(for: .save),
-            primaryCommandName(for: .abandon)
-        )
-    }
-
     func noActiveGameMessage() -> String {
         formatted(
             "error.noActiveGame",
@@ -332,8 +402,52 @@ final class Localization {
         formatted("error.persistence", error.localizedDescription)
     }
 
-    func coreDataLoadErrorMessage(_ error: Error) -> String {
-        formatted("error.coreData", error.localizedDescription)
+    func saveStoreLoadErrorMessage(_ reason: String) -> String {
+        formatted("error.saveStoreLoad", reason)
+    }
+
+    func saveStoreWriteFailedMessage(_ directory: URL) -> String {
+        formatted("error.saveStoreWrite", directory.path)
+    }
+
+    func saveStoreWorldDamagedMessage(_ directory: URL) -> String {
+        formatted("error.saveStoreWorldDamaged", directory.path)
+    }
+
+    func exportFailedMessage(_ file: URL, reason: String) -> String {
+        formatted("error.export", file.path, reason)
+    }
+
+    func importFailedMessage(_ file: URL, reason: String) -> String {
+        formatted("error.import", file.path, reason)
+    }
+
+    func coreDataImportedMessage(count: Int, from source: URL) -> String {
+        formatted("coredata.imported", count, source.path)
+    }
+
+    func coreDataImportFailedMessage(_ source: URL, reason: String) -> String {
+        formatted("error.coreDataImport", source.path, reason)
+    }
+
+    func archiveFailedMessage(_ file: URL, reason: String) -> String {
+        formatted("error.archive", file.path, reason)
+    }
+
+    func historyUnavailableMessage(_ reason: String) -> String {
+        formatted("error.history", reason)
+    }
+
+    func snapshotsUnavailableMessage(_ reason: String) -> String {
+        formatted("error.snapshots", reason)
+    }
+
+    func snapshotDamagedMessage(day: Int) -> String {
+        formatted("error.snapshotDamaged", day)
+    }
+
+    func worldArchiveMalformedMessage() -> String {
+        localized("error.worldArchive")
     }
 
     func dataDirectoryErrorMessage(_ error: Error) -> String {
@@ -429,6 +543,489 @@ final class Localization {
         localized("speed.validOptions")
     }
 
+    func acquisitionHeaderMessage(discountRate: Double, sensitivityBasisPoints: Double) -> String {
+        formatted("acquire.header", discountRate * 100, Int(sensitivityBasisPoints.rounded()))
+    }
+
+    func acquisitionEntryMessage(index: Int, name: String, price: Double, lowPrice: Double, highPrice: Double) -> String {
+        formatted(
+            "acquire.entry",
+            index,
+            name,
+            formatBalance(price),
+            formatBalance(lowPrice),
+            formatBalance(highPrice)
+        )
+    }
+
+    func acquisitionEmptyMessage() -> String {
+        localized("acquire.empty")
+    }
+
+    func acquisitionUsageMessage() -> String {
+        formatted("acquire.usage", primaryCommandName(for: .acquire))
+    }
+
+    func acquisitionSuccessMessage(name: String, price: Double) -> String {
+        formatted("acquire.success", name, formatBalance(price))
+    }
+
+    func acquisitionTargetNotFoundMessage(_ input: String) -> String {
+        formatted("error.acquisitionTarget", input, primaryCommandName(for: .acquire))
+    }
+
+    func insufficientFundsMessage(required: Double, available: Double) -> String {
+        formatted("error.insufficientFunds", formatBalance(required), formatBalance(available))
+    }
+
+    func goodName(_ good: Good) -> String {
+        localized(good.key)
+    }
+
+    /// Resolves a good from its name in any supported language.
+    func good(named name: String) -> Good? {
+        let normalized = name.trimmingCharacters(in: .whitespacesAndNewlines).lowercased()
+        return Good.allCases.first { good in
+            localizedInAllLanguages(good.key).contains { $0.lowercased() == normalized }
+        }
+    }
+
+    func inventoryHeaderMessage(method: InventoryLedger.CostingMethod) -> String {
+        let methodLabel: String
+        switch method {
+        case .fifo:
+            methodLabel = localized("inventory.method.fifo")
+        case .weightedAverage:
+            methodLabel = localized("inventory.method.weightedAverage")
+        }
+        return formatted("inventory.header", methodLabel)
+    }
+
+    func inventoryEntryMessage(_ line: InventoryLine) -> String {
+        formatted(
+            "inventory.entry",
+            line.warehouseName,
+            goodName(line.good),
+            formatQuantity(line.quantity),
+            formatBalance(line.carryingValue),
+            formatBalance(line.marketPrice)
+        )
+    }
+
+    func inventoryUsageMessage() -> String {
+        formatted("inventory.usage", primaryCommandName(for: .order), primaryCommandName(for: .sell))
+    }
+
+    func purchaseSuccessMessage(_ receipt: TradeReceipt) -> String {
+        formatted(
+            "trade.purchased",
+            formatQuantity(receipt.quantity),
+            goodName(receipt.good),
+            formatBalance(receipt.unitPrice),
+            formatBalance(receipt.total)
+        )
+    }
+
+    func saleSuccessMessage(_ receipt: TradeReceipt) -> String {
+        formatted(
+            "trade.sold",
+            formatQuantity(receipt.quantity),
+            goodName(receipt.good),
+            formatBalance(receipt.unitPrice),
+            formatBalance(receipt.total)
+        )
+    }
+
+    func invalidTradeArgumentsMessage(_ input: String) -> String {
+        let goods = Good.allCases.map(goodName(_:)).joined(separator: ", ")
+        return formatted("error.invalidTrade", input, goods)
+    }
+
+    func insufficientStockMessage(good: Good, available: Double) -> String {
+        formatted("error.insufficientStock", goodName(good), formatQuantity(available))
+    }
+
+    func forecastStartedMessage(years: Int, paths: Int) -> String {
+        formatted("forecast.started", years, paths, primaryCommandName(for: .forecast))
+    }
+
+    func forecastRunningMessage(_ progress: ForecastEngine.Progress) -> String {
+        formatted("forecast.running", progress.completedPaths, progress.totalPaths)
+    }
+
+    func forecastNoneMessage() -> String {
+        formatted("forecast.none", primaryCommandName(for: .forecast))
+    }
+
+    func forecastHeaderMessage(_ report: ForecastEngine.Report) -> String {
+        formatted("forecast.header", report.years, report.paths)
+    }
+
+    func forecastEntryMessage(year: Int, balance: ForecastEngine.Band, profits: ForecastEngine.Band) -> String {
+        formatted(
+            "forecast.entry",
+            year,
+            formatBalance(balance.p10),
+            formatBalance(balance.p50),
+            formatBalance(balance.p90),
+            formatBalance(profits.p10),
+            formatBalance(profits.p50),
+            formatBalance(profits.p90)
+        )
+    }
+
+    func invalidForecastMessage(_ input: String) -> String {
+        formatted(
+            "error.invalidForecast",
+            input,
+            primaryCommandName(for: .forecast),
+            ForecastEngine.yearRange.lowerBound,
+            ForecastEngine.yearRange.upperBound,
+            ForecastEngine.pathRange.lowerBound,
+            ForecastEngine.pathRange.upperBound
+        )
+    }
+
+    func promptForecastLabel() -> String {
+        localized("prompt.forecast")
+    }
+
+    func promptForecastValue(_ progress: ForecastEngine.Progress) -> String {
+        guard let median = progress.medianFinalBalance else {
+            return formatted("prompt.forecast.progress", progress.completedPaths, progress.totalPaths)
+        }
+        return formatted("prompt.forecast.median", progress.completedPaths, progress.totalPaths, formatBalance(median))
+    }
+
+    func marketingHeaderMessage() -> String {
+        localized("campaign.header")
+    }
+
+    func marketingRegionMessage(_ line: BrandAwarenessLine) -> String {
+        formatted("campaign.region", line.regionName, formatQuantity(line.awareness), formatQuantity(line.share * 100))
+    }
+
+    func marketingCampaignMessage(_ campaign: Marketing.Campaign, regionName: String) -> String {
+        formatted(
+            campaign.isRunning ? "campaign.entry.running" : "campaign.entry.scheduled",
+            campaign.id,
+            regionName,
+            formatBalance(campaign.dailySpend),
+            campaign.startDay,
+            campaign.endDay
+        )
+    }
+
+    func marketingNoCampaignsMessage() -> String {
+        localized("campaign.none")
+    }
+
+    func campaignLaunchedMessage(_ campaign: Marketing.Campaign, regionName: String) -> String {
+        formatted(
+            "campaign.launched",
+            campaign.id,
+            regionName,
+            formatBalance(campaign.dailySpend),
+            campaign.endDay - campaign.startDay
+        )
+    }
+
+    func campaignStoppedMessage(_ input: String) -> String {
+        formatted("campaign.stopped", input)
+    }
+
+    func campaignUsageMessage() -> String {
+        formatted(
+            "campaign.usage",
+            primaryCommandName(for: .campaign),
+            primaryCommandName(for: .campaign),
+            localized("campaign.stop.primary")
+        )
+    }
+
+    func invalidCampaignMessage(_ input: String) -> String {
+        formatted("error.invalidCampaign", input, primaryCommandName(for: .campaign))
+    }
+
+    func campaignNotFoundMessage(_ input: String) -> String {
+        formatted("error.campaignNotFound", input, primaryCommandName(for: .campaign))
+    }
+
+    func achievementName(_ id: String) -> String {
+        localized("achievement.\(id).name")
+    }
+
+    func achievementsHeaderMessage(unlocked: Int, total: Int) -> String {
+        formatted("achievements.header", unlocked, total)
+    }
+
+    func achievementEntryMessage(_ line: AchievementLine) -> String {
+        let description = localized("achievement.\(line.id).description")
+        guard let day = line.unlockedDay else {
+            return formatted("achievements.entry.locked", achievementName(line.id), description)
+        }
+        return formatted("achievements.entry.unlocked", achievementName(line.id), description, day)
+    }
+
+    func promptAchievementsLabel() -> String {
+        localized("prompt.achievements")
+    }
+
+    func promptAchievementsValue(unlocked: Int, latest: String) -> String {
+        formatted("prompt.achievements.value", unlocked, AchievementRules.definitions.count, achievementName(latest))
+    }
+
+    func exportUsageMessage() -> String {
+        formatted("export.usage", primaryCommandName(for: .exportGame))
+    }
+
+    func exportSuccessMessage(_ gameName: String, file: URL) -> String {
+        formatted("export.success", gameName, file.path)
+    }
+
+    func importUsageMessage() -> String {
+        formatted("import.usage", primaryCommandName(for: .importGame))
+    }
+
+    func importSuccessMessage(_ summary: String, id: UUID) -> String {
+        formatted("import.success", summary, primaryCommandName(for: .load), String(id.uuidString.prefix(8)))
+    }
+
+    func importArchiveSuccessMessage(count: Int, file: URL) -> String {
+        formatted("import.archive.success", count, file.path, primaryCommandName(for: .list))
+    }
+
+    func maintenanceProgressMessage(archived: Int, total: Int) -> String {
+        formatted("maintenance.progress", archived, total)
+    }
+
+    func maintenanceDoneMessage(_ report: MaintenanceReport) -> String {
+        formatted(
+            "maintenance.done",
+            report.archived,
+            report.archive.path,
+            report.remaining,
+            primaryCommandName(for: .importGame),
+            report.archive.path
+        )
+    }
+
+    func maintenanceWithoutWorldMessage(_ games: [Game]) -> String {
+        formatted("maintenance.withoutWorld", games.count, games.map(\.name).joined(separator: ", "))
+    }
+
+    func maintenanceEmptyMessage() -> String {
+        localized("maintenance.empty")
+    }
+
+    func historyHeaderMessage(months: Int) -> String {
+        formatted("history.header", months)
+    }
+
+    func historyEntryMessage(_ month: HistoryStore.Month) -> String {
+        formatted("history.entry", month.day, formatBalance(month.revenue), formatBalance(month.profit))
+    }
+
+    func historyEmptyMessage() -> String {
+        localized("history.empty")
+    }
+
+    func snapshotsHeaderMessage(_ snapshots: [SnapshotStore.Snapshot]) -> String {
+        let worldBytes = snapshots.reduce(0) { $0 + $1.length }
+        let storedBytes = snapshots.reduce(0) { $0 + $1.addedBytes }
+        return formatted("snapshots.header", snapshots.count, formatBytes(Double(worldBytes)), formatBytes(Double(storedBytes)))
+    }
+
+    func snapshotEntryMessage(position: Int, snapshot: SnapshotStore.Snapshot) -> String {
+        formatted(
+            "snapshots.entry",
+            position,
+            snapshot.day,
+            isoFormatter.string(from: snapshot.createdAt),
+            formatBytes(Double(snapshot.length)),
+            formatBytes(Double(snapshot.addedBytes))
+        )
+    }
+
+    func snapshotsEmptyMessage() -> String {
+        formatted("snapshots.empty", primaryCommandName(for: .save))
+    }
+
+    func snapshotsUsageMessage() -> String {
+        formatted(
+            "snapshots.usage",
+            primaryCommandName(for: .snapshots),
+            primaryCommandName(for: .snapshots),
+            localized("snapshots.restore.primary")
+        )
+    }
+
+    func snapshotRestoredMessage(_ snapshot: SnapshotStore.Snapshot) -> String {
+        formatted("snapshots.restored", snapshot.day)
+    }
+
+    func invalidSnapshotMessage(_ input: String) -> String {
+        formatted("error.invalidSnapshot", input, primaryCommandName(for: .snapshots))
+    }
+
+    func autosaveStatusMessage(intervalDays: Int?, latest: Autosaver.Status?) -> String {
+        var message = intervalDays.map { formatted("autosave.status", $0) } ?? localized("autosave.disabled")
+        if let latest {
+            message += "\n" + (latest.failed
+                ? formatted("autosave.lastFailed", latest.day, primaryCommandName(for: .save))
+                : formatted("autosave.last", latest.day))
+        }
+        return message
+    }
+
+    func autosaveUpdatedMessage(intervalDays: Int?) -> String {
+        intervalDays.map { formatted("autosave.updated", $0) } ?? localized("autosave.disabled")
+    }
+
+    func autosaveUsageMessage() -> String {
+        formatted(
+            "autosave.usage",
+            primaryCommandName(for: .autosave),
+            primaryCommandName(for: .autosave),
+            Autosaver.intervalRange.lowerBound,
+            Autosaver.intervalRange.upperBound,
+            primaryCommandName(for: .autosave),
+            localized("autosave.off.primary")
+        )
+    }
+
+    func promptAutosaveLabel() -> String {
+        localized("prompt.autosave")
+    }
+
+    func promptAutosaveValue(_ status: Autosaver.Status) -> String {
+        status.failed ? localized("prompt.autosave.failed") : formatted("prompt.autosave.value", status.day)
+    }
+
+    func profileHeaderMessage(speed: Int, budgetNanoseconds: Double?, budgetShare: Double) -> String {
+        guard let budgetNanoseconds else {
+            return formatted("profile.header.paused", speedValueString(for: speed))
+        }
+        return formatted(
+            "profile.header",
+            speedValueString(for: speed),
+            formatDuration(budgetNanoseconds),
+            formatQuantity(budgetShare * 100)
+        )
+    }
+
+    func profileEntryMessage(_ statistics: SystemProfiler.Statistics, overBudget: Bool) -> String {
+        let entry = formatted(
+            "profile.entry",
+            localized(statistics.system.key),
+            statistics.samples,
+            formatDuration(statistics.meanNanoseconds),
+            formatDuration(Double(statistics.p50Nanoseconds)),
+            formatDuration(Double(statistics.p99Nanoseconds)),
+            formatDuration(Double(statistics.maxNanoseconds))
+        )
+        return overBudget ? entry + " " + localized("profile.overBudget") : entry
+    }
+
+    func profileEmptyMessage() -> String {
+        localized("profile.empty")
+    }
+
+    func profileResetMessage() -> String {
+        localized("profile.reset")
+    }
+
+    func profileBudgetUpdatedMessage(_ share: Double) -> String {
+        formatted("profile.budgetUpdated", formatQuantity(share * 100))
+    }
+
+    func profileUsageMessage() -> String {
+        formatted(
+            "profile.usage",
+            primaryCommandName(for: .profile),
+            primaryCommandName(for: .profile),
+            localized("profile.reset.primary"),
+            primaryCommandName(for: .profile),
+            localized("profile.budget.primary"),
+            formatQuantity(SystemProfiler.budgetShareRange.lowerBound * 100),
+            formatQuantity(SystemProfiler.budgetShareRange.upperBound * 100)
+        )
+    }
+
+    func sandboxStartedMessage() -> String {
+        formatted(
+            "sandbox.started",
+            primaryCommandName(for: .sandbox),
+            localized("sandbox.merge.primary"),
+            primaryCommandName(for: .sandbox),
+            localized("sandbox.discard.primary")
+        )
+    }
+
+    func sandboxMergedMessage() -> String {
+        localized("sandbox.merged")
+    }
+
+    func sandboxDiscardedMessage() -> String {
+        localized("sandbox.discarded")
+    }
+
+    func sandboxUsageMessage() -> String {
+        formatted(
+            "sandbox.usage",
+            primaryCommandName(for: .sandbox),
+            primaryCommandName(for: .sandbox),
+            localized("sandbox.merge.primary"),
+            primaryCommandName(for: .sandbox),
+            localized("sandbox.discard.primary")
+        )
+    }
+
+    func sandboxActiveMessage() -> String {
+        formatted(
+            "error.sandboxActive",
+            primaryCommandName(for: .sandbox),
+            localized("sandbox.merge.primary"),
+            primaryCommandName(for: .sandbox),
+            localized("sandbox.discard.primary")
+        )
+    }
+
+    func sandboxAlreadyActiveMessage() -> String {
+        localized("error.sandboxAlreadyActive")
+    }
+
+    func noSandboxMessage() -> String {
+        formatted("error.noSandbox", primaryCommandName(for: .sandbox))
+    }
+
+    func promptSandboxTag() -> String {
+        localized("prompt.sandbox")
+    }
+
+    func scenarioSummaryMessage(_ scenario: ScenarioPack) -> String {
+        formatted(
+            "scenario.summary",
+            scenario.packURL?.path ?? localized("scenario.builtin"),
+            promptFormattedDate(from: scenario.referenceDate),
+            formatBalance(scenario.startingBalance),
+            scenario.regionNames.count,
+            scenario.companyCount
+        )
+    }
+
+    func scenarioCompiledMessage(_ pack: URL) -> String {
+        formatted("scenario.compiled", pack.path)
+    }
+
+    func scenarioUsageMessage() -> String {
+        formatted("scenario.usage", primaryCommandName(for: .scenario), localized("scenario.compile.primary"))
+    }
+
+    func scenarioCompileFailedMessage(_ reason: String) -> String {
+        formatted("error.scenarioCompile", reason)
+    }
+
     private func sanitizedGameName(_ value: String) -> String {
         let trimmed = value.trimmingCharacters(in: .whitespacesAndNewlines)
         return trimmed.isEmpty ? localized("status.label.unknownGame") : trimmed
@@ -455,6 +1052,36 @@ final class Localization {
         return String(format: "%.0f", amount)
     }
 
+    private func formatDuration(_ nanoseconds: Double) -> String {
+        switch nanoseconds {
+        case ..<1_000:
+            return formatQuantity(nanoseconds) + " ns"
+        case ..<1_000_000:
+            return formatQuantity(nanoseconds / 1_000) + " µs"
+        case ..<1_000_000_000:
+            return formatQuantity(nanoseconds / 1_000_000) + " ms"
+        default:
+            return formatQuantity(nanoseconds / 1_000_000_000) + " s"
+        }
+    }
+
+    private func formatBytes(_ bytes: Double) -> String {
+        switch bytes {
+        case ..<1_024:
+            return formatQuantity(bytes) + " B"
+        case ..<1_048_576:
+            return formatQuantity(bytes / 1_024) + " KiB"
+        case ..<1_073_741_824:
+            return formatQuantity(bytes / 1_048_576) + " MiB"
+        default:
+            return formatQuantity(bytes / 1_073_741_824) + " GiB"
+        }
+    }
+
+    private func formatQuantity(_ quantity: Double) -> String {
+        quantityFormatter.string(from: NSNumber(value: quantity)) ?? String(format: "%.2f", quantity)
+    }
+
     private func formatPromptDate(_ date: Date) -> String {
         let formatter = DateFormatter()
         formatter.locale = locale
@@ -0,0 +1,241 @@
+import Foundation
+
+@_silgen_name("AdstockAdvance")
+private func AdstockAdvance(
+    _ awareness: UnsafeMutablePointer<Float>,
+    _ spend: UnsafePointer<Float>,
+    _ regionTotals: UnsafeMutablePointer<Float>,
+    _ brandCount: Int32,
+    _ regionCount: Int32,
+    _ retention: Float,
+    _ response: Float
+)
+
+/// Advertising campaigns and the brand awareness they build. Every company
+/// is a brand; awareness and daily spend are dense brand × region matrices
+/// advanced in one native adstock pass per day. Campaigns start and stop
+/// through an `EventScheduler`, so days without events cost nothing extra.
+struct Marketing {
+    struct Campaign: Codable {
+        let id: Int
+        let brand: Int32
+        let region: Int32
+        let dailySpend: Double
+        let startDay: Int
+        var endDay: Int
+        var isRunning: Bool
+    }
+
+    enum Event: Codable {
+        case start(campaign: Int)
+        case stop(campaign: Int)
+    }
+
+    struct State: Codable {
+        var awareness: [Float]
+        var campaigns: [Campaign]
+        var scheduler: EventScheduler<Event>
+        var nextCampaignID: Int
+    }
+
+    /// Share of yesterday's awareness that survives a day (half-life ≈ 6.6 days).
+    static let retention: Float = 0.9
+    /// Awareness gained per dollar of daily spend.
+    static let responsePerDollar: Float = 0.000_1
+    /// Regional awareness that competes with every brand even without
+    /// campaigns, so a lone advertiser cannot take the whole market.
+    static let baselineAwareness: Float = 10
+    /// Revenue uplift of a brand holding the entire regional share.
+    static let maximumRevenueLift = 0.25
+
+    private(set) var brandCount: Int
+    let regionCount: Int
+    private(set) var awareness: [Float]
+    private(set) var regionTotals: [Float]
+    /// Daily spend of running campaigns per brand and region.
+    private var spend: [Float]
+    /// Daily spend of running campaigns per brand, charged to cash each day.
+    private(set) var brandSpend: [Double]
+    private(set) var campaigns: [Int: Campaign] = [:]
+    private var scheduler = EventScheduler<Event>()
+    private var nextCampaignID = 1
+
+    init(brandCount: Int, regionCount: Int, state: State? = nil) {
+        self.brandCount = brandCount
+        self.regionCount = regionCount
+        let cells = brandCount * regionCount
+        awareness = [Float](repeating: 0, count: cells)
+        regionTotals = [Float](repeating: 0, count: regionCount)
+        spend = [Float](repeating: 0, count: cells)
+        brandSpend = [Double](repeating: 0, count: brandCount)
+
+        guard let state else { return }
+
+        if state.awareness.count == cells {
+            awareness = state.awareness
+            recomputeRegionTotals()
+        }
+        scheduler = state.scheduler
+        nextCampaignID = state.nextCampaignID
+        for campaign in state.campaigns {
+            campaigns[campaign.id] = campaign
+            if campaign.isRunning {
+                applySpend(of: campaign, sign: 1)
+            }
+        }
+    }
+
+    var state: State {
+        State(
+            awareness: awareness,
+            campaigns: campaigns.values.sorted { $0.id < $1.id },
+            scheduler: scheduler,
+            nextCampaignID: nextCampaignID
+        )
+    }
+
+    func awareness(brand: Int, region: Int) -> Double {
+        Double(awareness[brand * regionCount + region])
+    }
+
+    /// Brand's share of regional attention, including the baseline.
+    func share(brand: Int, region: Int) -> Double {
+        Double(awareness[brand * regionCount + region] / (regionTotals[region] + Self.baselineAwareness))
+    }
+
+    func revenueLift(brand: Int, region: Int) -> Double {
+        1 + Self.maximumRevenueLift * share(brand: brand, region: region)
+    }
+
+    /// Schedules a campaign running for `days` starting on `startDay`.
+    @discardableResult
+    mutating func launchCampaign(brand: Int, region: Int, dailySpend: Double, startDay: Int, days: Int) -> Campaign {
+        let campaign = Campaign(
+            id: nextCampaignID,
+            brand: Int32(brand),
+            region: Int32(region),
+            dailySpend: dailySpend,
+            startDay: startDay,
+            endDay: startDay + days,
+            isRunning: false
+        )
+        nextCampaignID += 1
+        campaigns[campaign.id] = campaign
+        scheduler.schedule(.start(campaign: campaign.id), on: startDay)
+        scheduler.schedule(.stop(campaign: campaign.id), on: campaign.endDay)
+        return campaign
+    }
+
+    /// Moves a campaign's end forward to `day`. Returns `false` for unknown
+    /// or already finished campaigns.
+    mutating func stopCampaign(_ id: Int, on day: Int) -> Bool {
+        guard var campaign = campaigns[id], day < campaign.endDay else { return false }
+        campaign.endDay = max(day, campaign.startDay)
+        campaigns[id] = campaign
+        scheduler.schedule(.stop(campaign: id), on: campaign.endDay)
+        return true
+    }
+
+    /// Fires every start and stop event due on or before `day`.
+    mutating func processEvents(through day: Int) {
+        while let event = scheduler.popDue(through: day) {
+            switch event {
+            case .start(let id):
+                guard var campaign = campaigns[id], campaign.isRunning == false, campaign.endDay > day else { continue }
+                campaign.isRunning = true
+                campaigns[id] = campaign
+                applySpend(of: campaign, sign: 1)
+            case .stop(let id):
+                // Early stops leave the original stop event queued; it finds
+                // the campaign gone and is ignored.
+                guard let campaign = campaigns[id], campaign.endDay <= day else { continue }
+                if campaign.isRunning {
+                    applySpend(of: campaign, sign: -1)
+                }
+                campaigns[id] = nil
+            }
+        }
+    }
+
+    /// Decays yesterday's awareness and adds today's spend.
+    mutating func advanceDay() {
+        let brands = Int32(brandCount)
+        let regions = Int32(regionCount)
+        awareness.withUnsafeMutableBufferPointer { awarenessBuffer in
+            spend.withUnsafeBufferPointer { spendBuffer in
+                regionTotals.withUnsafeMutableBufferPointer { totalsBuffer in
+                    guard let awarenessBase = awarenessBuffer.baseAddress,
+                          let spendBase = spendBuffer.baseAddress,
+                          let totalsBase = totalsBuffer.baseAddress else { return }
+                    AdstockAdvance(awarenessBase, spendBase, totalsBase, brands, regions, Self.retention, Self.responsePerDollar)
+                }
+            }
+        }
+    }
+
+    /// Drops the rows of liquidated brands (ascending indices) and their
+    /// campaigns, renumbering the remaining brands to match the compacted
+    /// company arrays. Queued events of dropped campaigns are ignored when
+    /// they fire.
+    mutating func removeBrands(_ removed: [Int]) {
+        guard removed.isEmpty == false else { return }
+
+        var newIndex = [Int32](repeating: -1, count: brandCount)
+        var keptAwareness: [Float] = []
+        var keptSpend: [Float] = []
+        var keptBrandSpend: [Double] = []
+        keptAwareness.reserveCapacity((brandCount - removed.count) * regionCount)
+        keptSpend.reserveCapacity((brandCount - removed.count) * regionCount)
+
+        var cursor = 0
+        for brand in 0..<brandCount {
+            if cursor < removed.count, removed[cursor] == brand {
+                cursor += 1
+                continue
+            }
+            newIndex[brand] = Int32(keptBrandSpend.count)
+            let row = brand * regionCount..<(brand + 1) * regionCount
+            keptAwareness.append(contentsOf: awareness[row])
+            keptSpend.append(contentsOf: spend[row])
+            keptBrandSpend.append(brandSpend[brand])
+        }
+
+        brandCount = keptBrandSpend.count
+        awareness = keptAwareness
+        spend = keptSpend
+        brandSpend = keptBrandSpend
+        recomputeRegionTotals()
+
+        campaigns = campaigns.compactMapValues { campaign in
+            let brand = newIndex[Int(campaign.brand)]
+            guard brand >= 0 else { return nil }
+            return Campaign(
+                id: campaign.id,
+                brand: brand,
+                region: campaign.region,
+                dailySpend: campaign.dailySpend,
+                startDay: campaign.startDay,
+                endDay: campaign.endDay,
+                isRunning: campaign.isRunning
+            )
+        }
+    }
+
+    private mutating func applySpend(of campaign: Campaign, sign: Double) {
+        let brand = Int(campaign.brand)
+        let cell = brand * regionCount + Int(campaign.region)
+        spend[cell] = max(spend[cell] + Float(sign * campaign.dailySpend), 0)
+        brandSpend[brand] = max(brandSpend[brand] + sign * campaign.dailySpend, 0)
+    }
+
+    private mutating func recomputeRegionTotals() {
+        for region in 0..<regionCount {
+            regionTotals[region] = 0
+        }
+        for brand in 0..<brandCount {
+            for region in 0..<regionCount {
+                regionTotals[region] += awareness[brand * regionCount + region]
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <cstdint>
+
+// Advances brand awareness one day with geometric-decay adstock:
+//
+//     awareness = awareness * retention + spend * response
+//
+// `awareness` and `spend` are dense brand-major matrices
+// (brandCount × regionCount). The same pass sums awareness per region into
+// `regionTotals`, which demand share is computed against. The inner loop has
+// no dependencies between regions and vectorizes.
+extern "C" void AdstockAdvance(float *__restrict awareness,
+                               const float *__restrict spend,
+                               float *__restrict regionTotals,
+                               int32_t brandCount,
+                               int32_t regionCount,
+                               float retention,
+                               float response) {
+    if (brandCount <= 0 || regionCount <= 0) {
+        return;
+    }
+
+    std::fill(regionTotals, regionTotals + regionCount, 0.0f);
+
+    for (int32_t brand = 0; brand < brandCount; ++brand) {
+        const size_t offset = static_cast<size_t>(brand) * static_cast<size_t>(regionCount);
+        float *row = awareness + offset;
+        const float *rowSpend = spend + offset;
+
+        for (int32_t region = 0; region < regionCount; ++region) {
+            // Written as one expression so the compiler can contract it into an FMA.
+            const float next = row[region] * retention + rowSpend[region] * response;
+            row[region] = next;
+            regionTotals[region] += next;
+        }
+    }
+}
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <thread>
+#include <x86intrin.h>
+#endif
+
+namespace {
+constexpr int kBucketCount = 64;
+
+// Per-system timings. Durations land in power-of-two nanosecond buckets, so
+// recording is a couple of integer ops and percentiles come from the counts.
+struct SystemStats {
+    uint64_t count = 0;
+    uint64_t totalNanoseconds = 0;
+    uint64_t maxNanoseconds = 0;
+    std::array<uint64_t, kBucketCount> buckets{};
+};
+
+struct Profiler {
+    std::vector<SystemStats> systems;
+    double nanosecondsPerTick = 1;
+};
+
+// Raw counter: mach_absolute_time on Apple platforms, the TSC on x86, the
+// virtual counter on ARM, a steady clock elsewhere.
+inline uint64_t readTicks() {
+#if defined(__APPLE__)
+    return mach_absolute_time();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+double measureNanosecondsPerTick() {
+#if defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return static_cast<double>(timebase.numer) / static_cast<double>(timebase.denom);
+#elif defined(__x86_64__) || defined(__i386__)
+    // The TSC rate is not exposed portably; calibrate it against the steady
+    // clock once, when the profiler is created.
+    const auto wallStart = std::chrono::steady_clock::now();
+    const uint64_t tickStart = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const uint64_t ticks = __rdtsc() - tickStart;
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallStart);
+    return ticks == 0 ? 1 : static_cast<double>(nanoseconds.count()) / static_cast<double>(ticks);
+#elif defined(__aarch64__)
+    uint64_t frequency;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+    return frequency == 0 ? 1 : 1e9 / static_cast<double>(frequency);
+#else
+    using Period = std::chrono::steady_clock::period;
+    return 1e9 * static_cast<double>(Period::num) / static_cast<double>(Period::den);
+#endif
+}
+
+int bucketFor(uint64_t nanoseconds) {
+    return nanoseconds == 0 ? 0 : std::min(63 - __builtin_clzll(nanoseconds), kBucketCount - 1);
+}
+
+// Upper bound of the bucket holding the given fraction of samples.
+uint64_t percentile(const SystemStats &stats, double fraction) {
+    if (stats.count == 0) {
+        return 0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(stats.count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+        seen += stats.buckets[static_cast<size_t>(bucket)];
+        if (seen >= rank) {
+            const uint64_t upper = bucket >= 63 ? UINT64_MAX : (uint64_t{2} << bucket) - 1;
+            return std::min(upper, stats.maxNanoseconds);
+        }
+    }
+    return stats.maxNanoseconds;
+}
+
+Profiler *asProfiler(void *handle) {
+    return static_cast<Profiler *>(handle);
+}
+}  // namespace
+
+extern "C" void *ProfilerCreate(int32_t systemCount) {
+    auto *profiler = new Profiler();
+    profiler->systems.resize(static_cast<size_t>(std::max(systemCount, 0)));
+    profiler->nanosecondsPerTick = measureNanosecondsPerTick();
+    return profiler;
+}
+
+extern "C" void ProfilerDestroy(void *handle) {
+    delete asProfiler(handle);
+}
+
+extern "C" uint64_t ProfilerNow(void) {
+    return readTicks();
+}
+
+extern "C" void ProfilerRecord(void *handle, int32_t system, uint64_t startTicks, uint64_t endTicks) {
+    Profiler *profiler = asProfiler(handle);
+    if (profiler == nullptr || system < 0 || system >= static_cast<int32_t>(profiler->systems.size())) {
+        return;
+    }
+
+    const uint64_t ticks = endTicks > startTicks ? endTicks - startTicks : 0;
+    const auto nanoseconds = static_cast<uint64_t>(static_cast<double>(ticks) * profiler->nanosecondsPerTick);
+    SystemStats &stats = profiler->systems[static_cast<size_t>(system)];
+    ++stats.count;
+    stats.totalNanoseconds += nanoseconds;
+    stats.maxNanoseconds = std::max(stats.maxNanoseconds, nanoseconds);
+    ++stats.buckets[static_cast<size_t>(bucketFor(nanoseconds))];
+}
+
+// Percentiles are bucket upper bounds, so they overstate by at most 2x.
+extern "C" void ProfilerStatistics(void *handle,
+                                   int32_t system,
+                                   uint64_t *count,
+                                   uint64_t *totalNanoseconds,
+                                   uint64_t *maxNanoseconds,
+                                   uint64_t *p50Nanoseconds,
+                                   uint64_t *p99Nanoseconds) {
+    Profiler *profiler = asProfiler(handle);
+    if (profiler == nullptr || system < 0 || system >= static_cast<int32_t>(profiler->systems.size())) {
+        *count = 0;
+        *totalNanoseconds = 0;
+        *maxNanoseconds = 0;
+        *p50Nanoseconds = 0;
+        *p99Nanoseconds = 0;
+        return;
+    }
+
+    const SystemStats &stats = profiler->systems[static_cast<size_t>(system)];
+    *count = stats.count;
+    *totalNanoseconds = stats.totalNanoseconds;
+    *maxNanoseconds = stats.maxNanoseconds;
+    *p50Nanoseconds = percentile(stats, 0.5);
+    *p99Nanoseconds = percentile(stats, 0.99);
+}
+
+extern "C" void ProfilerReset(void *handle) {
+    Profiler *profiler = asProfiler(handle);
+    if (profiler == nullptr) {
+        return;
+    }
+    std::fill(profiler->systems.begin(), profiler->systems.end(), SystemStats{});
+}
@@ -0,0 +1,576 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Called with each file read by `SaveIOReadFiles`: its index in the batch
+// and its contents, valid only during the call. Returns 0 to go on.
+typedef int32_t (*SaveIOConsume)(void *context, int32_t index, const uint8_t *data, int64_t length);
+
+namespace {
+// Writes are cut into pieces of this size so many are in flight at once.
+constexpr size_t kSegmentBytes = 1u << 20;
+constexpr unsigned kQueueDepth = 64;
+// Read slots per ring, registered with the kernel once so reads into them
+// skip pinning and mapping the pages on every request. Only rings that
+// read get them, so the 4 MiB a ring locks is charged to the few threads
+// that restore snapshots, not to every writer; when the locked-memory
+// limit runs out, reads go to unregistered slots instead.
+constexpr size_t kReadSlots = 8;
+constexpr size_t kReadSlotBytes = 512u << 10;
+#if defined(IOV_MAX)
+constexpr size_t kMaximumIovecs = IOV_MAX;
+#else
+constexpr size_t kMaximumIovecs = 1024;
+#endif
+
+// A piece of a write: `length` bytes of `data` go to `offset` in the file.
+struct Segment {
+    const uint8_t *data;
+    size_t length;
+    uint64_t offset;
+};
+
+// Cuts `count` buffers written back to back from `offset` into segments.
+std::vector<Segment> segmentsOf(const uint8_t *const *buffers, const int64_t *lengths, int32_t count, uint64_t offset) {
+    std::vector<Segment> segments;
+    for (int32_t index = 0; index < count; ++index) {
+        const uint8_t *data = buffers[index];
+        size_t remaining = static_cast<size_t>(lengths[index]);
+        while (remaining > 0) {
+            const size_t length = std::min(kSegmentBytes, remaining);
+            segments.push_back(Segment{data, length, offset});
+            data += length;
+            offset += length;
+            remaining -= length;
+        }
+    }
+    return segments;
+}
+
+bool syncFile(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+// Runs `work(worker)` on `workers` threads, the calling one included.
+template <typename Work>
+void onThreads(size_t workers, Work work) {
+    std::vector<std::thread> helpers;
+    for (size_t worker = 1; worker < workers; ++worker) {
+        helpers.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+}
+
+size_t poolSize(size_t tasks) {
+    return std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), tasks));
+}
+
+// Fallback writer: the segments are split into one contiguous run per
+// worker and each worker writes its run with `pwritev`, as many segments
+// per call as the system allows.
+bool writeOnThreads(int fd, std::vector<Segment> &segments) {
+    const size_t workers = poolSize(segments.size());
+    std::atomic<bool> succeeded{true};
+    onThreads(workers, [&](size_t worker) {
+        const size_t begin = segments.size() * worker / workers;
+        const size_t end = segments.size() * (worker + 1) / workers;
+        size_t next = begin;
+        while (next < end && succeeded.load(std::memory_order_relaxed)) {
+            std::vector<iovec> vectors;
+            const uint64_t offset = segments[next].offset;
+            for (size_t index = next; index < end && vectors.size() < kMaximumIovecs; ++index) {
+                vectors.push_back(iovec{const_cast<uint8_t *>(segments[index].data), segments[index].length});
+            }
+            const ssize_t written = ::pwritev(fd, vectors.data(), static_cast<int>(vectors.size()),
+                                              static_cast<off_t>(offset));
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                succeeded.store(false);
+                break;
+            }
+            // Consume what was written; a short write resumes mid-segment.
+            size_t remaining = static_cast<size_t>(written);
+            while (remaining > 0) {
+                Segment &segment = segments[next];
+                const size_t taken = std::min(remaining, segment.length);
+                segment.data += taken;
+                segment.offset += taken;
+                segment.length -= taken;
+                remaining -= taken;
+                if (segment.length == 0) {
+                    ++next;
+                }
+            }
+        }
+    });
+    return succeeded.load();
+}
+
+// Fallback reader: workers take files in turn and read each into their own
+// buffer.
+bool readOnThreads(const int32_t *fds,
+                   const int64_t *capacities,
+                   int32_t count,
+                   SaveIOConsume consume,
+                   void *context) {
+    std::atomic<int32_t> next{0};
+    std::atomic<bool> succeeded{true};
+    onThreads(poolSize(static_cast<size_t>(count)), [&](size_t) {
+        std::vector<uint8_t> buffer;
+        int32_t index = 0;
+        while (succeeded.load(std::memory_order_relaxed) && (index = next.fetch_add(1)) < count) {
+            buffer.resize(static_cast<size_t>(capacities[index]));
+            size_t filled = 0;
+            while (filled < buffer.size()) {
+                const ssize_t got = ::pread(fds[index], buffer.data() + filled, buffer.size() - filled,
+                                            static_cast<off_t>(filled));
+                if (got < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (got < 0) {
+                    succeeded.store(false);
+                }
+                if (got <= 0) {
+                    break;
+                }
+                filled += static_cast<size_t>(got);
+            }
+            if (succeeded.load() && consume(context, index, buffer.data(), static_cast<int64_t>(filled)) != 0) {
+                succeeded.store(false);
+            }
+        }
+    });
+    return succeeded.load();
+}
+
+#if defined(__linux__)
+int ringSetup(unsigned entries, io_uring_params &params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int ringEnter(int fd, unsigned submit, unsigned complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0));
+}
+
+int ringRegister(int fd, unsigned opcode, const void *argument, unsigned count) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, argument, count));
+}
+
+// One io_uring instance, set up with raw system calls so nothing beyond the
+// kernel headers is needed. Each thread that does I/O gets its own, so
+// saves of different games never share a queue.
+struct Ring {
+    int fd = -1;
+    void *submissionMap = MAP_FAILED;
+    size_t submissionMapLength = 0;
+    void *completionMap = MAP_FAILED;
+    size_t completionMapLength = 0;
+    io_uring_sqe *entries = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t entriesLength = 0;
+
+    unsigned *submissionHead = nullptr;
+    unsigned *submissionTail = nullptr;
+    unsigned submissionMask = 0;
+    unsigned *submissionArray = nullptr;
+    unsigned *completionHead = nullptr;
+    unsigned *completionTail = nullptr;
+    unsigned completionMask = 0;
+    io_uring_cqe *completions = nullptr;
+
+    // Read slots, allocated on the first read and registered as fixed
+    // buffers unless locked memory ran out.
+    std::vector<uint8_t> slots;
+    bool registered = false;
+
+    Ring() = default;
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    ~Ring() {
+        if (entries != MAP_FAILED) {
+            ::munmap(entries, entriesLength);
+        }
+        if (completionMap != MAP_FAILED && completionMap != submissionMap) {
+            ::munmap(completionMap, completionMapLength);
+        }
+        if (submissionMap != MAP_FAILED) {
+            ::munmap(submissionMap, submissionMapLength);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    bool open() {
+        io_uring_params params{};
+        fd = ringSetup(kQueueDepth, params);
+        // Plain reads and writes at an offset need 5.6; older kernels only
+        // have the vectored forms, and the fallback serves them as well.
+        if (fd < 0 || (params.features & IORING_FEAT_SINGLE_MMAP) == 0 ||
+            (params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+            return false;
+        }
+
+        submissionMapLength = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        completionMapLength = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        submissionMapLength = completionMapLength = std::max(submissionMapLength, completionMapLength);
+        submissionMap = ::mmap(nullptr, submissionMapLength, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_SQ_RING);
+        if (submissionMap == MAP_FAILED) {
+            return false;
+        }
+        completionMap = submissionMap;
+        entriesLength = params.sq_entries * sizeof(io_uring_sqe);
+        entries = static_cast<io_uring_sqe *>(::mmap(nullptr, entriesLength, PROT_READ | PROT_WRITE,
+                                                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (entries == MAP_FAILED) {
+            return false;
+        }
+
+        auto *submission = static_cast<uint8_t *>(submissionMap);
+        submissionHead = reinterpret_cast<unsigned *>(submission + params.sq_off.head);
+        submissionTail = reinterpret_cast<unsigned *>(submission + params.sq_off.tail);
+        submissionMask = *reinterpret_cast<unsigned *>(submission + params.sq_off.ring_mask);
+        submissionArray = reinterpret_cast<unsigned *>(submission + params.sq_off.array);
+        auto *completion = static_cast<uint8_t *>(completionMap);
+        completionHead = reinterpret_cast<unsigned *>(completion + params.cq_off.head);
+        completionTail = reinterpret_cast<unsigned *>(completion + params.cq_off.tail);
+        completionMask = *reinterpret_cast<unsigned *>(completion + params.cq_off.ring_mask);
+        completions = reinterpret_cast<io_uring_cqe *>(completion + params.cq_off.cqes);
+        return true;
+    }
+
+    // Allocates and registers the read slots the first time this ring reads.
+    void openSlots() {
+        if (!slots.empty()) {
+            return;
+        }
+        slots.resize(kReadSlots * kReadSlotBytes);
+        std::vector<iovec> vectors;
+        for (size_t slot = 0; slot < kReadSlots; ++slot) {
+            vectors.push_back(iovec{slots.data() + slot * kReadSlotBytes, kReadSlotBytes});
+        }
+        registered = ringRegister(fd, IORING_REGISTER_BUFFERS, vectors.data(), kReadSlots) == 0;
+    }
+
+    uint8_t *slot(size_t index) {
+        return slots.data() + index * kReadSlotBytes;
+    }
+
+    // Next free submission entry, cleared; the queue never holds more than
+    // `kQueueDepth` requests, so one is always free.
+    io_uring_sqe &prepare(uint8_t opcode, int file, uint64_t userData) {
+        const unsigned tail = *submissionTail;
+        const unsigned index = tail & submissionMask;
+        io_uring_sqe &entry = entries[index];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.opcode = opcode;
+        entry.fd = file;
+        entry.user_data = userData;
+        submissionArray[index] = index;
+        __atomic_store_n(submissionTail, tail + 1, __ATOMIC_RELEASE);
+        return entry;
+    }
+
+    // Submits every prepared request and waits for at least one
+    // completion. On a hard error, requests the kernel did not take are
+    // withdrawn, so none can run later against freed buffers, and their
+    // number is returned through `withdrawn`.
+    bool submitAndWait(unsigned &withdrawn) {
+        withdrawn = 0;
+        while (true) {
+            const unsigned tail = *submissionTail;
+            const unsigned queued = tail - __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+            if (ringEnter(fd, queued, 1, IORING_ENTER_GETEVENTS) >= 0) {
+                return true;
+            }
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            const unsigned head = __atomic_load_n(submissionHead, __ATOMIC_ACQUIRE);
+            withdrawn = tail - head;
+            __atomic_store_n(submissionTail, head, __ATOMIC_RELEASE);
+            return false;
+        }
+    }
+
+    // Calls `handle(userData, result)` for every completion ready.
+    template <typename Handle>
+    void reap(Handle handle) {
+        unsigned head = *completionHead;
+        const unsigned tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe &completion = completions[head & completionMask];
+            handle(completion.user_data, completion.res);
+        }
+        __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+    }
+};
+
+// The calling thread's ring, set up on first use; null when io_uring is
+// unavailable or `CAPITALIST_SAVE_IO=threads` asks for the fallback.
+Ring *threadRing() {
+    static const bool disabled = [] {
+        const char *backend = std::getenv("CAPITALIST_SAVE_IO");
+        return backend != nullptr && std::strcmp(backend, "threads") == 0;
+    }();
+    static std::atomic<bool> unavailable{false};
+    thread_local std::unique_ptr<Ring> ring;
+    thread_local bool attempted = false;
+    if (disabled || unavailable.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    if (!attempted) {
+        attempted = true;
+        auto opened = std::make_unique<Ring>();
+        if (opened->open()) {
+            ring = std::move(opened);
+        } else if (errno == ENOSYS || errno == EPERM) {
+            // Not built into the kernel, or disabled by policy: no thread
+            // will do better.
+            unavailable.store(true);
+        }
+    }
+    return ring.get();
+}
+
+// User data of fsync requests: this bit plus the write generation they
+// cover.
+constexpr uint64_t kSyncRequest = 1ull << 63;
+
+bool retryable(int32_t result) {
+    return result == -EINTR || result == -EAGAIN;
+}
+
+// Writes the segments with up to `kQueueDepth` requests in flight. Once the
+// last segment is queued, an fsync is queued behind everything before it,
+// so the data and the sync go out in one round trip. A short write after
+// that point starts a new generation: its remainder is queued again, with
+// another fsync, and the earlier fsync no longer counts. Always waits for
+// every request, so the caller's buffers are free on return.
+bool writeOnRing(Ring &ring, int fd, std::vector<Segment> &segments, bool sync) {
+    size_t next = 0;
+    unsigned inFlight = 0;
+    bool failed = false;
+    uint64_t generation = 0;
+    bool syncQueued = false;
+    bool synced = !sync;
+    std::vector<size_t> retries;
+
+    const auto queueWrite = [&](size_t index) {
+        const Segment &segment = segments[index];
+        io_uring_sqe &entry = ring.prepare(IORING_OP_WRITE, fd, index);
+        entry.addr = reinterpret_cast<uint64_t>(segment.data);
+        entry.len = static_cast<uint32_t>(segment.length);
+        entry.off = segment.offset;
+        ++inFlight;
+    };
+
+    while (true) {
+        while (!failed && inFlight < kQueueDepth && (!retries.empty() || next < segments.size())) {
+            if (!retries.empty()) {
+                queueWrite(retries.back());
+                retries.pop_back();
+                ++generation;
+                syncQueued = false;
+                synced = !sync;
+            } else {
+                queueWrite(next++);
+            }
+        }
+        if (!failed && !synced && !syncQueued && next == segments.size() && retries.empty() &&
+            inFlight < kQueueDepth) {
+            io_uring_sqe &entry = ring.prepare(IORING_OP_FSYNC, fd, kSyncRequest | generation);
+            entry.flags = IOSQE_IO_DRAIN;
+            entry.fsync_flags = IORING_FSYNC_DATASYNC;
+            syncQueued = true;
+            ++inFlight;
+        }
+        if (inFlight == 0) {
+            break;
+        }
+        unsigned withdrawn = 0;
+        if (!ring.submitAndWait(withdrawn)) {
+            inFlight -= withdrawn;
+            failed = true;
+        }
+        ring.reap([&](uint64_t userData, int32_t result) {
+            --inFlight;
+            if ((userData & kSyncRequest) != 0) {
+                failed = failed || result < 0;
+                synced = synced || ((userData & ~kSyncRequest) == generation && result == 0);
+                return;
+            }
+            Segment &segment = segments[userData];
+            if (result < 0 && !retryable(result)) {
+                failed = true;
+            } else if (result == 0) {
+                // No progress and no error: the device takes no more.
+                failed = true;
+            } else if (retryable(result) || static_cast<size_t>(result) < segment.length) {
+                const size_t written = retryable(result) ? 0 : static_cast<size_t>(result);
+                segment.data += written;
+                segment.offset += written;
+                segment.length -= written;
+                retries.push_back(userData);
+            }
+        });
+    }
+    return !failed && retries.empty() && synced;
+}
+
+// Reads each file into a registered slot with as many reads in flight as
+// there are slots, resuming short reads until the end of the file or the
+// file's capacity. Files larger than a slot take the fallback path.
+bool readOnRing(Ring &ring,
+                const int32_t *fds,
+                const int64_t *capacities,
+                int32_t count,
+                SaveIOConsume consume,
+                void *context) {
+    for (int32_t index = 0; index < count; ++index) {
+        if (capacities[index] > static_cast<int64_t>(kReadSlotBytes)) {
+            return readOnThreads(fds, capacities, count, consume, context);
+        }
+    }
+    ring.openSlots();
+
+    struct Pending {
+        int32_t file;
+        size_t filled;
+    };
+    std::vector<Pending> pending(kReadSlots);
+    std::vector<size_t> freeSlots;
+    for (size_t slot = kReadSlots; slot > 0; --slot) {
+        freeSlots.push_back(slot - 1);
+    }
+    int32_t next = 0;
+    unsigned inFlight = 0;
+    bool failed = false;
+
+    const auto queueRead = [&](size_t slot) {
+        const Pending &read = pending[slot];
+        io_uring_sqe &entry =
+            ring.prepare(ring.registered ? IORING_OP_READ_FIXED : IORING_OP_READ, fds[read.file], slot);
+        entry.addr = reinterpret_cast<uint64_t>(ring.slot(slot) + read.filled);
+        entry.len = static_cast<uint32_t>(capacities[read.file] - static_cast<int64_t>(read.filled));
+        entry.off = read.filled;
+        entry.buf_index = static_cast<uint16_t>(slot);
+        ++inFlight;
+    };
+
+    while (true) {
+        while (!failed && next < count && !freeSlots.empty()) {
+            const size_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            pending[slot] = Pending{next++, 0};
+            queueRead(slot);
+        }
+        if (inFlight == 0) {
+            break;
+        }
+        unsigned withdrawn = 0;
+        if (!ring.submitAndWait(withdrawn)) {
+            inFlight -= withdrawn;
+            failed = true;
+        }
+        std::vector<size_t> resumed;
+        ring.reap([&](uint64_t slot, int32_t result) {
+            --inFlight;
+            Pending &read = pending[slot];
+            if (result < 0 && !retryable(result)) {
+                failed = true;
+                return;
+            }
+            read.filled += static_cast<size_t>(std::max(result, 0));
+            const bool complete = result == 0 || static_cast<int64_t>(read.filled) == capacities[read.file];
+            if (!complete) {
+                resumed.push_back(slot);
+                return;
+            }
+            failed = failed || consume(context, read.file, ring.slot(slot), static_cast<int64_t>(read.filled)) != 0;
+            freeSlots.push_back(slot);
+        });
+        for (size_t slot : resumed) {
+            if (!failed) {
+                queueRead(slot);
+            }
+        }
+    }
+    return !failed;
+}
+#endif
+}  // namespace
+
+// Writes `count` buffers back to back at `offset` in `fd`, then, with
+// `sync`, flushes the file's data to disk. Large buffers go out as many
+// concurrent pieces: through the thread's io_uring on Linux, or with
+// `pwritev` from a pool of threads elsewhere and when io_uring is missing.
+// Returns 0, or -1 with the file's contents undefined.
+extern "C" int32_t SaveIOWrite(int32_t fd,
+                               const uint8_t *const *buffers,
+                               const int64_t *lengths,
+                               int32_t count,
+                               int64_t offset,
+                               int32_t sync) {
+    std::vector<Segment> segments = segmentsOf(buffers, lengths, count, static_cast<uint64_t>(offset));
+#if defined(__linux__)
+    if (Ring *ring = threadRing()) {
+        return writeOnRing(*ring, fd, segments, sync != 0) ? 0 : -1;
+    }
+#endif
+    return writeOnThreads(fd, segments) && (sync == 0 || syncFile(fd)) ? 0 : -1;
+}
+
+// Reads `count` files, each from its start until its end or `capacities`
+// bytes, and passes each to `consume` on the calling thread (or on pool
+// threads, concurrently, without io_uring). Reads are batched into the
+// thread's io_uring with registered buffers when available. Returns 0, or
+// -1 if a read or `consume` failed.
+extern "C" int32_t SaveIOReadFiles(const int32_t *fds,
+                                   const int64_t *capacities,
+                                   int32_t count,
+                                   SaveIOConsume consume,
+                                   void *context) {
+#if defined(__linux__)
+    if (Ring *ring = threadRing()) {
+        return readOnRing(*ring, fds, capacities, count, consume, context) ? 0 : -1;
+    }
+#endif
+    return readOnThreads(fds, capacities, count, consume, context) ? 0 : -1;
+}
+
+// Which backend the calling thread uses: 1 for io_uring, 0 for threads.
+extern "C" int32_t SaveIOBackend(void) {
+#if defined(__linux__)
+    return threadRing() != nullptr ? 1 : 0;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,116 @@
+import Foundation
+
+/// Games open at once, each in a slot with its own `Autosaver`, so saving
+/// one game never waits behind another. The game in play keeps its world in
+/// the `Simulation`; the others keep theirs parked here, paused, so
+/// switching back swaps a reference instead of reading the store. Parked
+/// worlds beyond `residentWorlds` are evicted least recently used first:
+/// the slot's writer saves the world and the next switch to it reads the
+/// store again.
+final class SaveSlots {
+    final class Slot {
+        let autosaver: Autosaver
+        /// Parked world, or `nil` in play or once evicted. Guarded by the
+        /// `SaveSlots` lock.
+        fileprivate var world: World?
+        fileprivate var lastUsed: UInt64 = 0
+
+        fileprivate init(autosaver: Autosaver) {
+            self.autosaver = autosaver
+        }
+    }
+
+    /// Worlds kept in memory, the one in play included.
+    static let residentWorlds = 4
+
+    /// Called on a slot's writer queue after each of its background saves.
+    var onSave: ((Autosaver.Status) -> Void)?
+
+    private let store: SaveStore
+    private let snapshots: SnapshotStore
+    /// Guards the slot table only; saves run on each slot's own queue.
+    private let lock = NSLock()
+    private var slots: [UUID: Slot] = [:]
+    private var inPlay: UUID?
+    private var clock: UInt64 = 0
+
+    init(store: SaveStore, snapshots: SnapshotStore) {
+        self.store = store
+        self.snapshots = snapshots
+    }
+
+    /// Slot of the game in play, from any thread.
+    var current: Slot? {
+        lock.lock()
+        defer { lock.unlock() }
+        return inPlay.flatMap { slots[$0] }
+    }
+
+    /// Slot of `game`, opened and autosaving it on first use.
+    func slot(for game: Game) -> Slot {
+        lock.lock()
+        if let slot = slots[game.id] {
+            lock.unlock()
+            return slot
+        }
+        let autosaver = Autosaver(store: store, snapshots: snapshots)
+        let slot = Slot(autosaver: autosaver)
+        slots[game.id] = slot
+        lock.unlock()
+
+        autosaver.onSave = { [weak self] status in
+            self?.onSave?(status)
+        }
+        autosaver.track(game)
+        return slot
+    }
+
+    /// World parked in the slot of `game`, if it is still resident.
+    func parkedWorld(of game: Game) -> World? {
+        lock.lock()
+        defer { lock.unlock() }
+        return slots[game.id]?.world
+    }
+
+    /// Records `game` as in play and parks `world`, the world of the game
+    /// that was in play, in that game's slot. Evicts the coldest parked
+    /// worlds over the limit through their slots' writers.
+    func play(_ game: Game, parking world: World?) {
+        lock.lock()
+        clock += 1
+        if let previous = inPlay, previous != game.id, let slot = slots[previous] {
+            slot.world = world
+            slot.lastUsed = clock
+        }
+        inPlay = game.id
+        slots[game.id]?.world = nil
+        slots[game.id]?.lastUsed = clock
+
+        var evicted: [(Slot, World)] = []
+        var parked = slots.values.filter { $0.world != nil }.sorted { $0.lastUsed < $1.lastUsed }
+        while parked.count > Self.residentWorlds - 1 {
+            let slot = parked.removeFirst()
+            if let world = slot.world {
+                evicted.append((slot, world))
+            }
+            slot.world = nil
+        }
+        lock.unlock()
+
+        for (slot, world) in evicted {
+            slot.autosaver.enqueue(world)
+        }
+    }
+
+    /// Closes the slot of `game`, dropping any parked world. Saves already
+    /// queued for it still finish.
+    func close(_ game: Game) {
+        lock.lock()
+        let slot = slots.removeValue(forKey: game.id)
+        if inPlay == game.id {
+            inPlay = nil
+        }
+        lock.unlock()
+        slot?.autosaver.waitForQueuedSaves()
+    }
+}
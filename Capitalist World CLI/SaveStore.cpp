@@ -0,0 +1,1886 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+extern "C" int32_t SaveIOWrite(int32_t fd,
+                               const uint8_t *const *buffers,
+                               const int64_t *lengths,
+                               int32_t count,
+                               int64_t offset,
+                               int32_t sync);
+
+namespace {
+constexpr uint32_t kJournalMagic = 0x4C575743;   // "CWWL"
+constexpr uint32_t kCatalogMagic = 0x54435743;   // "CWCT"
+constexpr uint32_t kCheckpointMagic = 0x4B435743;  // "CWCK"
+constexpr uint32_t kCatalogVersion = 1;
+constexpr uint32_t kCheckpointVersion = 1;
+// World files carry one checksum per block of this size.
+constexpr uint32_t kCheckpointBlockBytes = 64u << 10;
+// Worlds with at least this many blocks are verified on several threads.
+constexpr uint64_t kParallelVerifyBlocks = 64;
+constexpr uint32_t kNoSlot = UINT32_MAX;
+// The journal is folded into a fresh catalog in the background once it
+// outgrows both this floor and `kCompactionRatio` times the catalog.
+constexpr uint64_t kMinimumCompactionBytes = 8ull << 20;
+constexpr uint64_t kCompactionRatio = 2;
+// Background compaction writes the catalog in synced slices at this rate,
+// leaving the disk to foreground journal syncs.
+constexpr uint64_t kCompactionBytesPerSecond = 16ull << 20;
+constexpr size_t kCompactionSliceBytes = 1u << 20;
+// Wait before retrying a compaction that failed.
+constexpr auto kCompactionRetry = std::chrono::seconds(30);
+
+enum class Operation : uint8_t {
+    remove = 2,
+    put = 3,
+};
+
+using GameID = std::array<uint8_t, 16>;
+
+struct Record {
+    GameID id{};
+    int32_t status = 0;
+    double balance = 0;
+    double createdAt = 0;
+    double updatedAt = 0;
+    double lastSavedAt = 0;
+    std::string name;
+    std::string playerName;
+    std::string companyName;
+    // Size of the world file, 0 when the game has none.
+    uint64_t worldLength = 0;
+};
+
+struct JournalEntryHeader {
+    uint32_t magic;
+    uint32_t payloadLength;
+    uint64_t sequence;
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+// The catalog is a header, fixed-size records sorted by id, and a heap
+// holding their strings. It is mapped, never parsed: listing a game reads
+// one record and three heap ranges in place.
+struct CatalogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sequence;
+    uint64_t recordCount;
+    uint64_t stringsOffset;
+    uint64_t fileLength;
+    // Most recently updated active game, or `kNoSlot`.
+    uint32_t latestActiveSlot;
+    // CRC32C of everything after the header.
+    uint32_t checksum;
+    uint8_t reserved[16];
+};
+
+struct CatalogRecord {
+    uint8_t id[16];
+    int32_t status;
+    uint32_t reserved;
+    double balance;
+    double createdAt;
+    double updatedAt;
+    double lastSavedAt;
+    uint64_t worldLength;
+    // Offsets are relative to the string heap.
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t playerNameOffset;
+    uint32_t playerNameLength;
+    uint32_t companyNameOffset;
+    uint32_t companyNameLength;
+    uint8_t padding[8];
+};
+
+// Ends every world file. The world bytes come first, so they map at offset
+// 0 as the decoder expects; then one CRC32C per block, then this footer.
+// `trailerChecksum` covers the block checksums and the footer fields before
+// it, so a damaged table is told apart from damaged world bytes.
+struct CheckpointFooter {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t payloadLength;
+    uint32_t blockBytes;
+    uint32_t blockCount;
+    uint32_t trailerChecksum;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(JournalEntryHeader) == 24, "JournalEntryHeader layout changed");
+static_assert(sizeof(CatalogHeader) == 64, "CatalogHeader layout changed");
+static_assert(sizeof(CatalogRecord) == 96, "CatalogRecord layout changed");
+static_assert(sizeof(CheckpointFooter) == 32, "CheckpointFooter layout changed");
+
+uint32_t crc32cSoftware(uint32_t crc, const uint8_t *data, size_t length) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t index = 0; index < 256; ++index) {
+            uint32_t entry = index;
+            for (int bit = 0; bit < 8; ++bit) {
+                entry = (entry >> 1) ^ (0x82F63B78u & (0u - (entry & 1u)));
+            }
+            entries[index] = entry;
+        }
+        return entries;
+    }();
+
+    for (size_t index = 0; index < length; ++index) {
+        crc = table[(crc ^ data[index]) & 0xFFu] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+// The CRC32C instructions of SSE4.2 and ARMv8 compute the same reflected
+// polynomial as the table, eight bytes per instruction.
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t crc32cHardware(uint32_t crc, const uint8_t *data, size_t length) {
+    uint64_t wide = crc;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, 8);
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<uint32_t>(wide);
+    for (; length > 0; ++data, --length) {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+
+bool hasHardwareCrc32c() {
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+}
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+uint32_t crc32cHardware(uint32_t crc, const uint8_t *data, size_t length) {
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, 8);
+        crc = __crc32cd(crc, word);
+    }
+    for (; length > 0; ++data, --length) {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+
+bool hasHardwareCrc32c() {
+    return true;
+}
+#else
+uint32_t crc32cHardware(uint32_t crc, const uint8_t *data, size_t length) {
+    return crc32cSoftware(crc, data, length);
+}
+
+bool hasHardwareCrc32c() {
+    return false;
+}
+#endif
+
+// Continues `crc`, the checksum of the bytes before `data`, over `data`.
+uint32_t crc32cExtend(uint32_t crc, const uint8_t *data, size_t length) {
+    crc ^= 0xFFFFFFFFu;
+    crc = hasHardwareCrc32c() ? crc32cHardware(crc, data, length) : crc32cSoftware(crc, data, length);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+uint32_t crc32c(const uint8_t *data, size_t length) {
+    return crc32cExtend(0, data, length);
+}
+
+template <typename Value>
+void appendValue(std::vector<uint8_t> &buffer, const Value &value) {
+    const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(Value));
+}
+
+void appendBytes(std::vector<uint8_t> &buffer, const void *data, size_t length) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + length);
+}
+
+// Payload of journal entries.
+void encodeRecord(std::vector<uint8_t> &buffer, Operation operation, const Record &record) {
+    appendValue(buffer, static_cast<uint8_t>(operation));
+    appendBytes(buffer, record.id.data(), record.id.size());
+    if (operation == Operation::remove) {
+        return;
+    }
+    appendValue(buffer, record.status);
+    appendValue(buffer, record.balance);
+    appendValue(buffer, record.createdAt);
+    appendValue(buffer, record.updatedAt);
+    appendValue(buffer, record.lastSavedAt);
+    appendValue(buffer, static_cast<uint32_t>(record.name.size()));
+    appendValue(buffer, static_cast<uint32_t>(record.playerName.size()));
+    appendValue(buffer, static_cast<uint32_t>(record.companyName.size()));
+    appendValue(buffer, record.worldLength);
+    appendBytes(buffer, record.name.data(), record.name.size());
+    appendBytes(buffer, record.playerName.data(), record.playerName.size());
+    appendBytes(buffer, record.companyName.data(), record.companyName.size());
+}
+
+class Reader {
+public:
+    Reader(const uint8_t *data, size_t length) : data_(data), length_(length) {}
+
+    template <typename Value>
+    bool read(Value &value) {
+        if (length_ - offset_ < sizeof(Value)) {
+            return false;
+        }
+        std::memcpy(&value, data_ + offset_, sizeof(Value));
+        offset_ += sizeof(Value);
+        return true;
+    }
+
+    bool readBytes(void *destination, size_t length) {
+        if (length_ - offset_ < length) {
+            return false;
+        }
+        std::memcpy(destination, data_ + offset_, length);
+        offset_ += length;
+        return true;
+    }
+
+    bool readString(std::string &value, size_t length) {
+        if (length_ - offset_ < length) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char *>(data_ + offset_), length);
+        offset_ += length;
+        return true;
+    }
+
+private:
+    const uint8_t *data_;
+    size_t length_;
+    size_t offset_ = 0;
+};
+
+bool decodeRecord(const uint8_t *data, size_t length, Operation &operation, Record &record) {
+    Reader reader(data, length);
+    uint8_t rawOperation = 0;
+    if (!reader.read(rawOperation) || !reader.readBytes(record.id.data(), record.id.size())) {
+        return false;
+    }
+    operation = static_cast<Operation>(rawOperation);
+    if (operation == Operation::remove) {
+        return true;
+    }
+    if (operation != Operation::put) {
+        return false;
+    }
+
+    uint32_t nameLength = 0;
+    uint32_t playerLength = 0;
+    uint32_t companyLength = 0;
+    return reader.read(record.status) && reader.read(record.balance) && reader.read(record.createdAt) &&
+           reader.read(record.updatedAt) && reader.read(record.lastSavedAt) && reader.read(nameLength) &&
+           reader.read(playerLength) && reader.read(companyLength) && reader.read(record.worldLength) &&
+           reader.readString(record.name, nameLength) && reader.readString(record.playerName, playerLength) &&
+           reader.readString(record.companyName, companyLength);
+}
+
+bool writeAll(int fd, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        const ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool syncFile(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+bool syncDirectory(const std::string &directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+bool readFile(const std::string &path, std::vector<uint8_t> &contents) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    contents.resize(static_cast<size_t>(info.st_size));
+    size_t offset = 0;
+    while (offset < contents.size()) {
+        const ssize_t count = ::read(fd, contents.data() + offset, contents.size() - offset);
+        if (count <= 0) {
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        offset += static_cast<size_t>(count);
+    }
+    ::close(fd);
+    contents.resize(offset);
+    return true;
+}
+
+void setError(char *buffer, int32_t capacity, const std::string &message) {
+    if (buffer == nullptr || capacity <= 0) {
+        return;
+    }
+    std::snprintf(buffer, static_cast<size_t>(capacity), "%s", message.c_str());
+}
+
+
+// Keeps the file at `path` as `previousPath`, the checkpoint to fall back
+// to when the next one turns out damaged. Only a file `intact` accepts is
+// promoted: a missing or damaged `path` leaves the last verified previous
+// checkpoint alone. Best effort: on a filesystem without hard links there
+// is simply no previous checkpoint.
+template <typename Intact>
+void keepPrevious(const std::string &path, const std::string &previousPath, Intact intact) {
+    if (!intact(path)) {
+        return;
+    }
+    const std::string temporaryPath = previousPath + ".tmp";
+    ::unlink(temporaryPath.c_str());
+    if (::link(path.c_str(), temporaryPath.c_str()) == 0 && ::rename(temporaryPath.c_str(), previousPath.c_str()) != 0) {
+        ::unlink(temporaryPath.c_str());
+    }
+}
+
+// Calls `body(block)` for every block in [0, count), spread over all cores
+// when there are enough blocks. Workers claim blocks from a shared counter
+// and all stop once a call returns false. Returns whether every call
+// succeeded.
+template <typename Body>
+bool forEachBlock(uint64_t count, Body body) {
+    std::atomic<uint64_t> next{0};
+    std::atomic<bool> succeeded{true};
+    const auto work = [&] {
+        uint64_t block = 0;
+        while (succeeded.load(std::memory_order_relaxed) &&
+               (block = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+            if (!body(block)) {
+                succeeded.store(false, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    const uint64_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t workers = count >= kParallelVerifyBlocks ? std::min(cores, count / (kParallelVerifyBlocks / 4)) : 1;
+    std::vector<std::thread> helpers;
+    for (uint64_t worker = 1; worker < workers; ++worker) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (auto &helper : helpers) {
+        helper.join();
+    }
+    return succeeded.load();
+}
+
+uint64_t checkpointBlockCount(uint64_t length, uint32_t blockBytes) {
+    return (length + blockBytes - 1) / blockBytes;
+}
+
+// Checksum of every block of a world of `length` bytes.
+std::vector<uint32_t> blockChecksums(const uint8_t *data, uint64_t length) {
+    const uint64_t blockCount = checkpointBlockCount(length, kCheckpointBlockBytes);
+    std::vector<uint32_t> checksums(blockCount);
+    forEachBlock(blockCount, [&](uint64_t block) {
+        const uint64_t offset = block * kCheckpointBlockBytes;
+        checksums[block] = crc32c(data + offset, std::min<uint64_t>(kCheckpointBlockBytes, length - offset));
+        return true;
+    });
+    return checksums;
+}
+
+// Block checksums and footer that follow a world of `length` bytes.
+std::vector<uint8_t> checkpointTrailer(const std::vector<uint32_t> &checksums, uint64_t length) {
+    std::vector<uint8_t> trailer;
+    appendBytes(trailer, checksums.data(), checksums.size() * sizeof(uint32_t));
+    CheckpointFooter footer{kCheckpointMagic, kCheckpointVersion, length, kCheckpointBlockBytes,
+                            static_cast<uint32_t>(checksums.size()), 0, 0};
+    appendValue(trailer, footer);
+    const size_t covered = trailer.size() - sizeof(footer) + offsetof(CheckpointFooter, trailerChecksum);
+    footer.trailerChecksum = crc32c(trailer.data(), covered);
+    std::memcpy(trailer.data() + trailer.size() - sizeof(footer), &footer, sizeof(footer));
+    return trailer;
+}
+
+enum class WorldCheck {
+    missing,
+    damaged,
+    intact,
+};
+
+struct MappedWorld {
+    const uint8_t *data = nullptr;
+    uint64_t length = 0;
+    size_t mappedLength = 0;
+};
+
+// Validates the trailer of a mapped world file and reports where the world
+// bytes end. A missing or garbled footer fails like any damaged block, so
+// the caller falls back to the previous checkpoint.
+bool readCheckpointTrailer(const uint8_t *file, size_t size, uint64_t &payloadLength, const uint8_t *&checksums,
+                           uint64_t &blockCount, uint32_t &blockBytes) {
+    CheckpointFooter footer{};
+    if (size < sizeof(footer)) {
+        return false;
+    }
+    std::memcpy(&footer, file + size - sizeof(footer), sizeof(footer));
+    if (footer.magic != kCheckpointMagic) {
+        return false;
+    }
+
+    const uint64_t tableBytes = static_cast<uint64_t>(footer.blockCount) * sizeof(uint32_t);
+    if (footer.version != kCheckpointVersion || footer.blockBytes == 0 ||
+        footer.blockCount != checkpointBlockCount(footer.payloadLength, footer.blockBytes) ||
+        footer.payloadLength > size || size - footer.payloadLength != tableBytes + sizeof(footer)) {
+        return false;
+    }
+    const uint8_t *trailer = file + footer.payloadLength;
+    const size_t covered = tableBytes + offsetof(CheckpointFooter, trailerChecksum);
+    if (crc32c(trailer, covered) != footer.trailerChecksum) {
+        return false;
+    }
+    payloadLength = footer.payloadLength;
+    checksums = trailer;
+    blockCount = footer.blockCount;
+    blockBytes = footer.blockBytes;
+    return true;
+}
+
+// Fields of a record wherever it lives: in the catalog mapping or in memory.
+struct RecordView {
+    const uint8_t *id;
+    int32_t status;
+    double balance;
+    double createdAt;
+    double updatedAt;
+    double lastSavedAt;
+    uint64_t worldLength;
+    // Name, player and company, not NUL-terminated.
+    const char *strings[3];
+    uint32_t lengths[3];
+};
+
+RecordView viewOf(const Record &record) {
+    return RecordView{record.id.data(),
+                      record.status,
+                      record.balance,
+                      record.createdAt,
+                      record.updatedAt,
+                      record.lastSavedAt,
+                      record.worldLength,
+                      {record.name.data(), record.playerName.data(), record.companyName.data()},
+                      {static_cast<uint32_t>(record.name.size()), static_cast<uint32_t>(record.playerName.size()),
+                       static_cast<uint32_t>(record.companyName.size())}};
+}
+
+// Read-only mapping of the catalog file, or an empty catalog when there is
+// none yet. Replaced, never modified, by compaction; listings hold on to
+// the one they were opened against.
+struct Catalog {
+    const uint8_t *base = nullptr;
+    size_t length = 0;
+
+    Catalog() = default;
+    Catalog(const Catalog &) = delete;
+    Catalog &operator=(const Catalog &) = delete;
+
+    ~Catalog() {
+        if (base != nullptr) {
+            ::munmap(const_cast<uint8_t *>(base), length);
+        }
+    }
+
+    bool exists() const {
+        return base != nullptr;
+    }
+
+    const CatalogHeader &header() const {
+        return *reinterpret_cast<const CatalogHeader *>(base);
+    }
+
+    uint64_t sequence() const {
+        return exists() ? header().sequence : 0;
+    }
+
+    size_t count() const {
+        return exists() ? static_cast<size_t>(header().recordCount) : 0;
+    }
+
+    uint32_t latestActiveSlot() const {
+        return exists() ? header().latestActiveSlot : kNoSlot;
+    }
+
+    const CatalogRecord &record(size_t slot) const {
+        return reinterpret_cast<const CatalogRecord *>(base + sizeof(CatalogHeader))[slot];
+    }
+
+    GameID id(size_t slot) const {
+        GameID id{};
+        std::memcpy(id.data(), record(slot).id, id.size());
+        return id;
+    }
+
+    RecordView view(size_t slot) const {
+        const CatalogRecord &entry = record(slot);
+        const char *heap = reinterpret_cast<const char *>(base + header().stringsOffset);
+        return RecordView{entry.id,
+                          entry.status,
+                          entry.balance,
+                          entry.createdAt,
+                          entry.updatedAt,
+                          entry.lastSavedAt,
+                          entry.worldLength,
+                          {heap + entry.nameOffset, heap + entry.playerNameOffset, heap + entry.companyNameOffset},
+                          {entry.nameLength, entry.playerNameLength, entry.companyNameLength}};
+    }
+
+    // Slot holding `id`, or `kNoSlot`.
+    uint32_t find(const GameID &target) const {
+        size_t low = 0;
+        size_t high = count();
+        while (low < high) {
+            const size_t middle = low + (high - low) / 2;
+            const int order = std::memcmp(record(middle).id, target.data(), target.size());
+            if (order == 0) {
+                return static_cast<uint32_t>(middle);
+            }
+            if (order < 0) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return kNoSlot;
+    }
+};
+
+bool validCatalog(const uint8_t *base, size_t length) {
+    if (length < sizeof(CatalogHeader)) {
+        return false;
+    }
+    CatalogHeader header{};
+    std::memcpy(&header, base, sizeof(header));
+    const uint64_t recordBytes = length - sizeof(CatalogHeader);
+    if (header.magic != kCatalogMagic || header.version != kCatalogVersion || header.fileLength != length ||
+        header.recordCount > recordBytes / sizeof(CatalogRecord) ||
+        header.stringsOffset != sizeof(CatalogHeader) + header.recordCount * sizeof(CatalogRecord) ||
+        (header.latestActiveSlot != kNoSlot && header.latestActiveSlot >= header.recordCount) ||
+        crc32c(base + sizeof(CatalogHeader), recordBytes) != header.checksum) {
+        return false;
+    }
+
+    const uint64_t heapLength = length - header.stringsOffset;
+    const auto *records = reinterpret_cast<const CatalogRecord *>(base + sizeof(CatalogHeader));
+    for (uint64_t slot = 0; slot < header.recordCount; ++slot) {
+        const CatalogRecord &record = records[slot];
+        if (static_cast<uint64_t>(record.nameOffset) + record.nameLength > heapLength ||
+            static_cast<uint64_t>(record.playerNameOffset) + record.playerNameLength > heapLength ||
+            static_cast<uint64_t>(record.companyNameOffset) + record.companyNameLength > heapLength) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Maps and validates the catalog at `path`. A missing file yields an empty
+// catalog; a damaged one fails.
+bool mapCatalog(const std::string &path, std::shared_ptr<const Catalog> &catalog) {
+    auto mapped = std::make_shared<Catalog>();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        catalog = std::move(mapped);
+        return errno == ENOENT;
+    }
+
+    struct stat info {};
+    void *mapping = MAP_FAILED;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    mapped->base = static_cast<const uint8_t *>(mapping);
+    mapped->length = static_cast<size_t>(info.st_size);
+    if (!validCatalog(mapped->base, mapped->length)) {
+        return false;
+    }
+    catalog = std::move(mapped);
+    return true;
+}
+
+// Change made after the catalog was written; a null record is a removal.
+struct Change {
+    std::shared_ptr<const Record> record;
+    uint64_t sequence = 0;
+};
+
+using ChangeMap = std::map<GameID, Change>;
+
+// Visits every live record in id order: catalog slots that no change
+// supersedes through `onSlot`, changed records through `onRecord`. Changes
+// in `newer` supersede those in `older` for the same game.
+template <typename OnSlot, typename OnRecord>
+void mergeRecords(const Catalog &catalog, const ChangeMap &older, const ChangeMap &newer, OnSlot onSlot, OnRecord onRecord) {
+    auto olderChange = older.begin();
+    auto newerChange = newer.begin();
+    // Id of the next change in either layer, or null past both.
+    const auto nextID = [&]() -> const GameID * {
+        const bool hasOlder = olderChange != older.end();
+        const bool hasNewer = newerChange != newer.end();
+        if (hasOlder && (!hasNewer || olderChange->first < newerChange->first)) {
+            return &olderChange->first;
+        }
+        return hasNewer ? &newerChange->first : nullptr;
+    };
+    const auto visitChange = [&] {
+        const Change *change = nullptr;
+        if (newerChange != newer.end() && newerChange->first == *nextID()) {
+            if (olderChange != older.end() && olderChange->first == newerChange->first) {
+                ++olderChange;
+            }
+            change = &(newerChange++)->second;
+        } else {
+            change = &(olderChange++)->second;
+        }
+        if (change->record) {
+            onRecord(change->record);
+        }
+    };
+
+    for (size_t slot = 0; slot < catalog.count(); ++slot) {
+        const GameID id = catalog.id(slot);
+        while (nextID() != nullptr && *nextID() < id) {
+            visitChange();
+        }
+        if (nextID() != nullptr && *nextID() == id) {
+            visitChange();
+            continue;
+        }
+        onSlot(static_cast<uint32_t>(slot));
+    }
+    while (nextID() != nullptr) {
+        visitChange();
+    }
+}
+
+// Stable view of every game for the listing API: the catalog it was opened
+// against plus the changed records, all kept alive by reference, so
+// pointers into it stay valid across saves and compactions.
+struct Listing {
+    std::shared_ptr<const Catalog> catalog;
+    // Ascending catalog slots still current.
+    std::vector<uint32_t> slots;
+    std::vector<std::shared_ptr<const Record>> records;
+
+    size_t count() const {
+        return slots.size() + records.size();
+    }
+
+    RecordView view(size_t index) const {
+        return index < slots.size() ? catalog->view(slots[index]) : viewOf(*records[index - slots.size()]);
+    }
+
+    // Index of the game with `id`, or -1. Slots and changed records are
+    // each in id order, so both halves are binary searched.
+    int32_t find(const GameID &id) const {
+        const auto slot = std::lower_bound(slots.begin(), slots.end(), id, [&](uint32_t candidate, const GameID &key) {
+            return catalog->id(candidate) < key;
+        });
+        if (slot != slots.end() && catalog->id(*slot) == id) {
+            return static_cast<int32_t>(slot - slots.begin());
+        }
+        const auto record = std::lower_bound(
+            records.begin(), records.end(), id,
+            [](const std::shared_ptr<const Record> &candidate, const GameID &key) { return candidate->id < key; });
+        if (record != records.end() && (*record)->id == id) {
+            return static_cast<int32_t>(slots.size() + static_cast<size_t>(record - records.begin()));
+        }
+        return -1;
+    }
+
+    // Index of the most recently updated active game, or -1. Trusts the
+    // slot the catalog recorded unless a change superseded it; only then
+    // are the catalog's records scanned.
+    int32_t latestActive() const {
+        int32_t best = -1;
+        double bestUpdatedAt = 0;
+        const auto consider = [&](size_t index) {
+            const RecordView record = view(index);
+            if (record.status == 0 && (best < 0 || record.updatedAt > bestUpdatedAt)) {
+                best = static_cast<int32_t>(index);
+                bestUpdatedAt = record.updatedAt;
+            }
+        };
+
+        const uint32_t hinted = catalog->latestActiveSlot();
+        if (hinted != kNoSlot) {
+            const auto position = std::lower_bound(slots.begin(), slots.end(), hinted);
+            if (position != slots.end() && *position == hinted) {
+                consider(static_cast<size_t>(position - slots.begin()));
+            } else {
+                for (size_t index = 0; index < slots.size(); ++index) {
+                    consider(index);
+                }
+            }
+        }
+        for (size_t index = slots.size(); index < count(); ++index) {
+            consider(index);
+        }
+        return best;
+    }
+};
+
+// Save metadata lives in a memory-mapped catalog of fixed-size records, so
+// opening the store and listing games parse nothing. Changes since the
+// catalog was written are journaled for durability and layered over it in
+// memory as immutable records until compaction folds them into a new
+// catalog. Worlds are too large to keep resident and go to one file per
+// game under `worlds/`, replaced atomically and mapped on load.
+// Committers share fsyncs: whoever finds no flush in progress writes every
+// pending entry in one write and one sync, and the rest wait for it.
+//
+// Compaction runs on its own thread. It seals the journal by renaming it
+// aside and starting a new one, moves the changes it holds into an
+// immutable layer, and writes the new catalog from that layer at a limited
+// rate. Saves keep appending to the new journal meanwhile; the mutex is only
+// held to swap pointers. A crash before the new catalog is in place
+// replays both journals.
+struct Store {
+    std::string directory;
+    std::string catalogPath;
+    std::string previousCatalogPath;
+    std::string journalPath;
+    std::string sealedJournalPath;
+    std::string worldsDirectory;
+    int journalFd = -1;
+
+    std::mutex mutex;
+    std::condition_variable flushed;
+    std::condition_variable compaction;
+    std::shared_ptr<const Catalog> catalog;
+    // Changes in the sealed journal, being folded into the next catalog,
+    // or null between compactions.
+    std::shared_ptr<const ChangeMap> sealed;
+    uint64_t sealedSequence = 0;
+    // Changes since the journal was last sealed; these supersede `sealed`.
+    ChangeMap changes;
+    // Device, inode, size and mtime of world files whose blocks passed
+    // verification in this process.
+    std::set<std::tuple<dev_t, ino_t, off_t, time_t>> verifiedWorlds;
+    // Generation and identity of each world file this process installed,
+    // by path. Generations count installs, so a delta is only applied on
+    // top of the very file it was computed against.
+    std::map<std::string, std::pair<uint64_t, std::tuple<dev_t, ino_t, off_t, time_t>>> installedWorlds;
+    uint64_t worldGeneration = 0;
+
+    std::vector<uint8_t> pending;
+    uint64_t nextSequence = 0;
+    uint64_t durableSequence = 0;
+    bool flushing = false;
+    bool failed = false;
+    uint64_t journalBytes = 0;
+    uint64_t catalogBytes = 0;
+    bool closing = false;
+    // A catalog at or past this sequence was asked for by
+    // `SaveStoreCompact`.
+    uint64_t requestedSequence = 0;
+    // Compactions finished, and whether the last one failed; for callers
+    // waiting on a requested compaction.
+    uint64_t compactionAttempts = 0;
+    bool compactionFailed = false;
+    std::thread compactor;
+
+    void apply(Operation operation, std::shared_ptr<const Record> record, uint64_t sequence) {
+        Change &change = changes[record->id];
+        change.sequence = sequence;
+        change.record = operation == Operation::remove ? nullptr : std::move(record);
+    }
+
+    // Sealed changes, or none; the caller holds the mutex.
+    const ChangeMap &sealedChanges() const {
+        static const ChangeMap none;
+        return sealed ? *sealed : none;
+    }
+
+    // World length stored for `id`; the caller holds the mutex.
+    uint64_t storedWorldLength(const GameID &id) const {
+        for (const ChangeMap *layer : {&changes, &sealedChanges()}) {
+            const auto change = layer->find(id);
+            if (change != layer->end()) {
+                return change->second.record ? change->second.record->worldLength : 0;
+            }
+        }
+        const uint32_t slot = catalog->find(id);
+        return slot == kNoSlot ? 0 : catalog->record(slot).worldLength;
+    }
+
+    std::unique_ptr<Listing> openListing() {
+        auto listing = std::make_unique<Listing>();
+        std::lock_guard<std::mutex> lock(mutex);
+        listing->catalog = catalog;
+        listing->slots.reserve(catalog->count());
+        mergeRecords(
+            *catalog, sealedChanges(), changes, [&](uint32_t slot) { listing->slots.push_back(slot); },
+            [&](const std::shared_ptr<const Record> &record) { listing->records.push_back(record); });
+        return listing;
+    }
+
+    std::string worldPath(const GameID &id) const {
+        static const char digits[] = "0123456789abcdef";
+        std::string name;
+        for (uint8_t byte : id) {
+            name.push_back(digits[byte >> 4]);
+            name.push_back(digits[byte & 0x0F]);
+        }
+        return worldsDirectory + "/" + name + ".world";
+    }
+
+    // Replaces the world file of `id` with a new checkpoint: the world and
+    // its block checksums are written and synced under a temporary name,
+    // the current file is kept as the previous checkpoint, and a rename
+    // flips the name to the new one. Readers and crashes see either
+    // checkpoint whole, never a mix. The world goes out in concurrent
+    // pieces through `SaveIOWrite`, with the sync queued behind them.
+    bool writeWorld(const GameID &id, const uint8_t *data, size_t length, uint64_t *generation = nullptr) {
+        const std::string path = worldPath(id);
+        const std::string temporaryPath = path + ".tmp";
+        const std::vector<uint8_t> trailer = checkpointTrailer(blockChecksums(data, length), length);
+        const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        const uint8_t *const buffers[] = {data, trailer.data()};
+        const int64_t lengths[] = {static_cast<int64_t>(length), static_cast<int64_t>(trailer.size())};
+        const bool written = SaveIOWrite(fd, buffers, lengths, 2, 0, 1) == 0;
+        ::close(fd);
+        return installWorld(path, temporaryPath, written, generation);
+    }
+
+    // Second half of replacing a world file: once the checkpoint at
+    // `temporaryPath` is `written` and synced, keeps the current one as
+    // previous and renames the new one into place. Removes the temporary
+    // file on any failure.
+    bool installWorld(const std::string &path, const std::string &temporaryPath, bool written,
+                      uint64_t *generation = nullptr) {
+        if (written) {
+            keepPrevious(path, path + ".prev", [&](const std::string &current) { return intactWorld(current); });
+        }
+        if (!written || ::rename(temporaryPath.c_str(), path.c_str()) != 0 || !syncDirectory(worldsDirectory)) {
+            ::unlink(temporaryPath.c_str());
+            return false;
+        }
+        // Its checksums were computed from the bytes just written, so the
+        // next save can promote it to previous without reading it back.
+        struct stat info {};
+        if (::stat(path.c_str(), &info) == 0) {
+            const auto identity = std::make_tuple(info.st_dev, info.st_ino, info.st_size, info.st_mtime);
+            std::lock_guard<std::mutex> lock(mutex);
+            verifiedWorlds.insert(identity);
+            installedWorlds[path] = std::make_pair(++worldGeneration, identity);
+            if (generation != nullptr) {
+                *generation = worldGeneration;
+            }
+        }
+        return true;
+    }
+
+    // Replaces the world file of `id` like `writeWorld`, writing only what
+    // changed since the world of `baseLength` bytes installed as
+    // `baseGeneration`: the bytes in `ranges` (offset and length pairs) and
+    // any past `baseLength`. The rest of the new checkpoint comes from the
+    // current file, reflinked where the filesystem shares extents
+    // (copy_file_range on Btrfs and XFS, clonefile on APFS) and copied in
+    // the kernel otherwise, and keeps its block checksums. Falls back to a
+    // full write when the current file is not that generation. Sets
+    // `generation` to the new file's.
+    bool writeWorldDelta(const GameID &id,
+                         const uint8_t *data,
+                         size_t length,
+                         uint64_t baseGeneration,
+                         uint64_t baseLength,
+                         const int64_t *ranges,
+                         int32_t rangeCount,
+                         uint64_t &generation) {
+        const std::string path = worldPath(id);
+        const int baseFd = baseGeneration == 0 ? -1 : ::open(path.c_str(), O_RDONLY);
+        struct stat info {};
+        bool installed = false;
+        if (baseFd >= 0 && ::fstat(baseFd, &info) == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto known = installedWorlds.find(path);
+            installed = known != installedWorlds.end() && known->second.first == baseGeneration &&
+                        known->second.second ==
+                            std::make_tuple(info.st_dev, info.st_ino, info.st_size, info.st_mtime);
+        }
+        MappedWorld base;
+        if (!installed || mapWorld(path, base) != WorldCheck::intact || base.length != baseLength) {
+            if (base.data != nullptr) {
+                ::munmap(const_cast<uint8_t *>(base.data), base.mappedLength);
+            }
+            if (baseFd >= 0) {
+                ::close(baseFd);
+            }
+            return writeWorld(id, data, length, &generation);
+        }
+
+        uint64_t verifiedLength = 0;
+        const uint8_t *baseChecksums = nullptr;
+        uint64_t baseBlockCount = 0;
+        uint32_t baseBlockBytes = 0;
+        readCheckpointTrailer(base.data, base.mappedLength, verifiedLength, baseChecksums, baseBlockCount,
+                              baseBlockBytes);
+        const uint64_t kept = std::min<uint64_t>(baseLength, length);
+        const std::string temporaryPath = path + ".tmp";
+        const int fd = copyPrefix(baseFd, base.data, kept, temporaryPath);
+        ::close(baseFd);
+        if (fd < 0) {
+            ::munmap(const_cast<uint8_t *>(base.data), base.mappedLength);
+            ::unlink(temporaryPath.c_str());
+            return writeWorld(id, data, length, &generation);
+        }
+
+        // Everything past the base is new, and blocks that overlap a
+        // written range or changed extent need fresh checksums.
+        std::vector<std::pair<uint64_t, uint64_t>> written;
+        for (int32_t index = 0; index < rangeCount; ++index) {
+            const uint64_t offset = std::min<uint64_t>(static_cast<uint64_t>(ranges[2 * index]), kept);
+            const uint64_t end = std::min<uint64_t>(offset + static_cast<uint64_t>(ranges[2 * index + 1]), kept);
+            if (end > offset) {
+                written.emplace_back(offset, end);
+            }
+        }
+        if (length > kept) {
+            written.emplace_back(kept, length);
+        }
+        const uint64_t blockCount = checkpointBlockCount(length, kCheckpointBlockBytes);
+        std::vector<bool> fresh(blockCount, baseBlockBytes != kCheckpointBlockBytes);
+        for (const auto &range : written) {
+            for (uint64_t block = range.first / kCheckpointBlockBytes; block * kCheckpointBlockBytes < range.second;
+                 ++block) {
+                fresh[block] = true;
+            }
+        }
+        std::vector<uint32_t> checksums(blockCount);
+        for (uint64_t block = 0; block < blockCount; ++block) {
+            const uint64_t offset = block * kCheckpointBlockBytes;
+            const uint64_t end = std::min<uint64_t>(offset + kCheckpointBlockBytes, length);
+            // A block kept whole from the base, with the same extent, keeps
+            // its checksum.
+            const uint64_t baseEnd = std::min<uint64_t>(offset + kCheckpointBlockBytes, baseLength);
+            if (!fresh[block] && block < baseBlockCount && end == baseEnd) {
+                std::memcpy(&checksums[block], baseChecksums + block * sizeof(uint32_t), sizeof(uint32_t));
+            } else {
+                checksums[block] = crc32c(data + offset, end - offset);
+            }
+        }
+        ::munmap(const_cast<uint8_t *>(base.data), base.mappedLength);
+
+        bool ok = true;
+        for (const auto &range : written) {
+            const uint8_t *const buffers[] = {data + range.first};
+            const int64_t lengths[] = {static_cast<int64_t>(range.second - range.first)};
+            ok = ok && SaveIOWrite(fd, buffers, lengths, 1, static_cast<int64_t>(range.first), 0) == 0;
+        }
+        const std::vector<uint8_t> trailer = checkpointTrailer(checksums, length);
+        const uint8_t *const buffers[] = {trailer.data()};
+        const int64_t lengths[] = {static_cast<int64_t>(trailer.size())};
+        ok = ok && SaveIOWrite(fd, buffers, lengths, 1, static_cast<int64_t>(length), 1) == 0;
+        ::close(fd);
+        return installWorld(path, temporaryPath, ok, &generation);
+    }
+
+    // Creates `temporaryPath` holding the first `length` bytes of the file
+    // open as `sourceFd`, also mapped at `source`, and returns it open for
+    // writing, or -1.
+    static int copyPrefix(int sourceFd, const uint8_t *source, uint64_t length, const std::string &temporaryPath) {
+        ::unlink(temporaryPath.c_str());
+#if defined(__APPLE__)
+        if (::fclonefileat(sourceFd, AT_FDCWD, temporaryPath.c_str(), 0) == 0) {
+            const int cloned = ::open(temporaryPath.c_str(), O_WRONLY);
+            if (cloned >= 0 && ::ftruncate(cloned, static_cast<off_t>(length)) == 0) {
+                return cloned;
+            }
+            if (cloned >= 0) {
+                ::close(cloned);
+            }
+            ::unlink(temporaryPath.c_str());
+        }
+#endif
+        const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return -1;
+        }
+        uint64_t copied = 0;
+#if defined(__linux__)
+        loff_t input = 0;
+        loff_t output = 0;
+        while (copied < length) {
+            const ssize_t count = ::copy_file_range(sourceFd, &input, fd, &output, length - copied, 0);
+            if (count <= 0) {
+                break;
+            }
+            copied += static_cast<uint64_t>(count);
+        }
+#else
+        (void)sourceFd;
+#endif
+        if (copied < length) {
+            const uint8_t *const buffers[] = {source + copied};
+            const int64_t lengths[] = {static_cast<int64_t>(length - copied)};
+            if (SaveIOWrite(fd, buffers, lengths, 1, static_cast<int64_t>(copied), 0) != 0) {
+                ::close(fd);
+                return -1;
+            }
+        }
+        return fd;
+    }
+
+    // Whether the world file at `path` exists and every block verifies.
+    bool intactWorld(const std::string &path) {
+        MappedWorld world;
+        if (mapWorld(path, world) != WorldCheck::intact) {
+            return false;
+        }
+        ::munmap(const_cast<uint8_t *>(world.data), world.mappedLength);
+        return true;
+    }
+
+    // Maps the world file at `path` and checks every block against its
+    // checksum. World files are replaced, never rewritten, so one this
+    // process already verified is trusted while its identity is unchanged.
+    WorldCheck mapWorld(const std::string &path, MappedWorld &world) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return errno == ENOENT ? WorldCheck::missing : WorldCheck::damaged;
+        }
+
+        struct stat info {};
+        void *mapping = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return WorldCheck::damaged;
+        }
+
+        const auto *file = static_cast<const uint8_t *>(mapping);
+        const size_t size = static_cast<size_t>(info.st_size);
+        const auto identity = std::make_tuple(info.st_dev, info.st_ino, info.st_size, info.st_mtime);
+        uint64_t payloadLength = 0;
+        const uint8_t *checksums = nullptr;
+        uint64_t blockCount = 0;
+        uint32_t blockBytes = 0;
+        bool intact = readCheckpointTrailer(file, size, payloadLength, checksums, blockCount, blockBytes);
+        if (intact && blockCount > 0) {
+            bool known = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                known = verifiedWorlds.count(identity) > 0;
+            }
+            intact = known || forEachBlock(blockCount, [&](uint64_t block) {
+                         const uint64_t offset = block * blockBytes;
+                         uint32_t expected = 0;
+                         std::memcpy(&expected, checksums + block * sizeof(uint32_t), sizeof(expected));
+                         return crc32c(file + offset, std::min<uint64_t>(blockBytes, payloadLength - offset)) == expected;
+                     });
+            if (intact && !known) {
+                std::lock_guard<std::mutex> lock(mutex);
+                verifiedWorlds.insert(identity);
+            }
+        }
+        if (!intact) {
+            ::munmap(mapping, size);
+            return WorldCheck::damaged;
+        }
+
+        world.data = file;
+        world.length = payloadLength;
+        world.mappedLength = size;
+        return WorldCheck::intact;
+    }
+
+    // Applies the intact journal entries in `contents` newer than
+    // `baseSequence`. Returns the length of the intact prefix.
+    size_t replayEntries(const std::vector<uint8_t> &contents, uint64_t baseSequence, uint64_t &lastSequence) {
+        size_t offset = 0;
+        while (contents.size() - offset >= sizeof(JournalEntryHeader)) {
+            JournalEntryHeader header{};
+            std::memcpy(&header, contents.data() + offset, sizeof(header));
+            const size_t payloadOffset = offset + sizeof(header);
+            if (header.magic != kJournalMagic || contents.size() - payloadOffset < header.payloadLength ||
+                crc32c(contents.data() + payloadOffset, header.payloadLength) != header.checksum) {
+                break;
+            }
+
+            if (header.sequence > baseSequence) {
+                auto record = std::make_shared<Record>();
+                Operation operation = Operation::put;
+                if (!decodeRecord(contents.data() + payloadOffset, header.payloadLength, operation, *record)) {
+                    break;
+                }
+                apply(operation, std::move(record), header.sequence);
+                lastSequence = std::max(lastSequence, header.sequence);
+            }
+            offset = payloadOffset + header.payloadLength;
+        }
+        return offset;
+    }
+
+    // Replays journal entries newer than the catalog, starting with a
+    // journal sealed by a compaction that never finished, and cuts off a
+    // torn tail left by a crash mid-append. `sealedFound` tells whether
+    // there was a sealed journal, which only a new catalog retires.
+    bool replayJournal(uint64_t baseSequence, bool &sealedFound) {
+        std::vector<uint8_t> contents;
+        uint64_t lastSequence = baseSequence;
+        sealedFound = readFile(sealedJournalPath, contents);
+        if (sealedFound) {
+            replayEntries(contents, baseSequence, lastSequence);
+        }
+        contents.clear();
+        readFile(journalPath, contents);
+        const size_t offset = replayEntries(contents, baseSequence, lastSequence);
+
+        journalFd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (journalFd < 0) {
+            return false;
+        }
+        if (offset < contents.size() && ::ftruncate(journalFd, static_cast<off_t>(offset)) != 0) {
+            return false;
+        }
+        journalBytes = offset;
+        nextSequence = lastSequence;
+        durableSequence = lastSequence;
+        return true;
+    }
+
+    uint64_t enqueue(Operation operation, std::shared_ptr<const Record> record) {
+        std::vector<uint8_t> payload;
+        encodeRecord(payload, operation, *record);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        const uint64_t sequence = ++nextSequence;
+        JournalEntryHeader header{kJournalMagic, static_cast<uint32_t>(payload.size()), sequence,
+                                  crc32c(payload.data(), payload.size()), 0};
+        appendValue(pending, header);
+        pending.insert(pending.end(), payload.begin(), payload.end());
+        apply(operation, std::move(record), sequence);
+        return sequence;
+    }
+
+    bool commit(uint64_t sequence) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (durableSequence < sequence && !failed) {
+            if (flushing) {
+                flushed.wait(lock);
+                continue;
+            }
+
+            flushing = true;
+            std::vector<uint8_t> batch;
+            batch.swap(pending);
+            const uint64_t batchSequence = nextSequence;
+            const int fd = journalFd;
+            lock.unlock();
+
+            const bool ok = batch.empty() || (writeAll(fd, batch.data(), batch.size()) && syncFile(fd));
+
+            lock.lock();
+            flushing = false;
+            if (ok) {
+                durableSequence = std::max(durableSequence, batchSequence);
+                journalBytes += batch.size();
+                if (compactionDue()) {
+                    compaction.notify_one();
+                }
+            } else {
+                failed = true;
+            }
+            flushed.notify_all();
+        }
+        return !failed;
+    }
+
+    // Whether the compactor has work; the caller holds the mutex.
+    bool compactionDue() const {
+        return sealed || catalog->sequence() < requestedSequence ||
+               journalBytes > std::max(kMinimumCompactionBytes, catalogBytes * kCompactionRatio);
+    }
+
+    // Compactor thread: compacts whenever the journal outgrows the catalog,
+    // retrying failures after a pause, until the store closes.
+    void runCompactor() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!closing) {
+            if (!compactionDue()) {
+                compaction.wait(lock);
+                continue;
+            }
+            lock.unlock();
+            const bool compacted = compactInBackground();
+            lock.lock();
+            ++compactionAttempts;
+            compactionFailed = !compacted;
+            compaction.notify_all();
+            if (!compacted) {
+                compaction.wait_for(lock, kCompactionRetry, [&] { return closing; });
+            }
+        }
+    }
+
+    // Folds the sealed changes into a new catalog, sealing the journal
+    // first unless a failed attempt left it sealed. A crash or close at any
+    // point leaves journals that replay to the same state.
+    bool compactInBackground() {
+        if (!sealed && !sealJournal()) {
+            return false;
+        }
+
+        std::shared_ptr<const Catalog> base;
+        std::shared_ptr<const ChangeMap> folded;
+        uint64_t sequence = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            base = catalog;
+            folded = sealed;
+            sequence = sealedSequence;
+        }
+
+        std::shared_ptr<const Catalog> mapped;
+        uint64_t length = 0;
+        if (!writeCatalog(*base, *folded, ChangeMap(), sequence, kCompactionBytesPerSecond, mapped, length)) {
+            return false;
+        }
+        std::vector<GameID> removed;
+        {
+            // The replaced catalog and layer are released after unlocking;
+            // unmapping and freeing them can take far longer than the swap.
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(catalog, mapped);
+            sealed.reset();
+            catalogBytes = length;
+            removed = removedGames(*folded, changes);
+        }
+        // Every entry of the sealed journal is at or below the catalog's
+        // sequence now.
+        ::unlink(sealedJournalPath.c_str());
+        deleteWorlds(removed);
+        return true;
+    }
+
+    // Games removed in `folded` and not saved again since in `newer`.
+    static std::vector<GameID> removedGames(const ChangeMap &folded, const ChangeMap &newer) {
+        std::vector<GameID> removed;
+        for (const auto &entry : folded) {
+            if (!entry.second.record && newer.count(entry.first) == 0) {
+                removed.push_back(entry.first);
+            }
+        }
+        return removed;
+    }
+
+    // Deletes the world files of games whose removal a catalog on disk
+    // already records, so no crash can bring back a game without its world.
+    void deleteWorlds(const std::vector<GameID> &ids) {
+        for (const GameID &id : ids) {
+            const std::string path = worldPath(id);
+            ::unlink(path.c_str());
+            ::unlink((path + ".prev").c_str());
+        }
+        if (!ids.empty()) {
+            syncDirectory(worldsDirectory);
+        }
+    }
+
+    // Renames the journal aside and continues in a new one, moving the
+    // changes the old one holds into the sealed layer. The new journal is
+    // created and its directory entry synced before any commit can rely on
+    // it; the mutex is held only to swap the two, between flushes.
+    bool sealJournal() {
+        if (::rename(journalPath.c_str(), sealedJournalPath.c_str()) != 0) {
+            return false;
+        }
+        const int fd = ::open(journalPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd < 0 || !syncDirectory(directory)) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            ::rename(sealedJournalPath.c_str(), journalPath.c_str());
+            return false;
+        }
+
+        auto layer = std::make_shared<ChangeMap>();
+        int sealedFd = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            flushed.wait(lock, [&] { return !flushing; });
+            sealedFd = journalFd;
+            journalFd = fd;
+            layer->swap(changes);
+            sealed = std::move(layer);
+            sealedSequence = nextSequence;
+            journalBytes = 0;
+        }
+        ::close(sealedFd);
+        return true;
+    }
+
+    // Folds every change into a new catalog at full speed and empties the
+    // journals. Only used while opening, before any other thread runs.
+    bool compactNow() {
+        std::shared_ptr<const Catalog> mapped;
+        uint64_t length = 0;
+        if (!writeCatalog(*catalog, sealedChanges(), changes, nextSequence, 0, mapped, length)) {
+            return false;
+        }
+        std::vector<GameID> removed = removedGames(sealedChanges(), changes);
+        const std::vector<GameID> removedLater = removedGames(changes, ChangeMap());
+        removed.insert(removed.end(), removedLater.begin(), removedLater.end());
+        deleteWorlds(removed);
+        catalog = std::move(mapped);
+        sealed.reset();
+        changes.clear();
+        catalogBytes = length;
+
+        // The catalog covers every journaled entry, so a crash on either
+        // side of the truncate recovers the same state.
+        if (::ftruncate(journalFd, 0) != 0) {
+            return false;
+        }
+        ::unlink(sealedJournalPath.c_str());
+        journalBytes = 0;
+        return true;
+    }
+
+    // Writes `base` merged with `older` and `newer` changes as the catalog
+    // at `sequence`, keeping the current one as the previous checkpoint, and
+    // maps it. With a nonzero `bytesPerSecond` the file goes out in synced
+    // slices at that rate, so compaction never queues a burst of writeback
+    // ahead of a foreground journal sync; closing the store interrupts it.
+    bool writeCatalog(const Catalog &base,
+                      const ChangeMap &older,
+                      const ChangeMap &newer,
+                      uint64_t sequence,
+                      uint64_t bytesPerSecond,
+                      std::shared_ptr<const Catalog> &mapped,
+                      uint64_t &fileLength) {
+        std::vector<CatalogRecord> records;
+        std::vector<uint8_t> heap;
+        uint32_t latestActiveSlot = kNoSlot;
+        const auto appendString = [&](const char *value, uint32_t length, uint32_t &offset) {
+            offset = static_cast<uint32_t>(heap.size());
+            appendBytes(heap, value, length);
+        };
+        const auto append = [&](const RecordView &view) {
+            CatalogRecord record{};
+            std::memcpy(record.id, view.id, sizeof(record.id));
+            record.status = view.status;
+            record.balance = view.balance;
+            record.createdAt = view.createdAt;
+            record.updatedAt = view.updatedAt;
+            record.lastSavedAt = view.lastSavedAt;
+            record.worldLength = view.worldLength;
+            record.nameLength = view.lengths[0];
+            record.playerNameLength = view.lengths[1];
+            record.companyNameLength = view.lengths[2];
+            appendString(view.strings[0], view.lengths[0], record.nameOffset);
+            appendString(view.strings[1], view.lengths[1], record.playerNameOffset);
+            appendString(view.strings[2], view.lengths[2], record.companyNameOffset);
+            if (view.status == 0 &&
+                (latestActiveSlot == kNoSlot || view.updatedAt > records[latestActiveSlot].updatedAt)) {
+                latestActiveSlot = static_cast<uint32_t>(records.size());
+            }
+            records.push_back(record);
+        };
+        mergeRecords(
+            base, older, newer, [&](uint32_t slot) { append(base.view(slot)); },
+            [&](const std::shared_ptr<const Record> &record) { append(viewOf(*record)); });
+        if (heap.size() > UINT32_MAX) {
+            return false;
+        }
+
+        CatalogHeader header{};
+        header.magic = kCatalogMagic;
+        header.version = kCatalogVersion;
+        header.sequence = sequence;
+        header.recordCount = records.size();
+        header.stringsOffset = sizeof(CatalogHeader) + records.size() * sizeof(CatalogRecord);
+        header.fileLength = header.stringsOffset + heap.size();
+        header.latestActiveSlot = latestActiveSlot;
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(header.fileLength);
+        appendValue(buffer, header);
+        appendBytes(buffer, records.data(), records.size() * sizeof(CatalogRecord));
+        buffer.insert(buffer.end(), heap.begin(), heap.end());
+        header.checksum = crc32c(buffer.data() + sizeof(CatalogHeader), buffer.size() - sizeof(CatalogHeader));
+        std::memcpy(buffer.data(), &header, sizeof(header));
+
+        const std::string temporaryPath = catalogPath + ".tmp";
+        const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        bool written = true;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; written && offset < buffer.size(); offset += kCompactionSliceBytes) {
+            const size_t slice = std::min(kCompactionSliceBytes, buffer.size() - offset);
+            written = writeAll(fd, buffer.data() + offset, slice);
+            if (written && bytesPerSecond > 0) {
+                const auto due = start + std::chrono::microseconds((offset + slice) * 1000000 / bytesPerSecond);
+                written = syncFile(fd);
+                std::unique_lock<std::mutex> lock(mutex);
+                written = written && !compaction.wait_until(lock, due, [&] { return closing; });
+            }
+        }
+        written = written && ::fsync(fd) == 0;
+        ::close(fd);
+        if (written) {
+            keepPrevious(catalogPath, previousCatalogPath, [](const std::string &current) {
+                std::shared_ptr<const Catalog> existing;
+                return mapCatalog(current, existing) && existing->exists();
+            });
+        }
+        if (!written || ::rename(temporaryPath.c_str(), catalogPath.c_str()) != 0 || !syncDirectory(directory)) {
+            ::unlink(temporaryPath.c_str());
+            return false;
+        }
+
+        fileLength = buffer.size();
+        return mapCatalog(catalogPath, mapped);
+    }
+};
+
+// A world checkpoint written piece by piece, for worlds that arrive as a
+// stream and never sit in memory whole. Block checksums are computed as
+// the bytes pass; the checkpoint replaces the game's world file only when
+// finished.
+struct WorldWriter {
+    Store *store = nullptr;
+    std::string path;
+    std::string temporaryPath;
+    int fd = -1;
+    uint64_t length = 0;
+    std::vector<uint32_t> checksums;
+    bool failed = false;
+
+    bool append(const uint8_t *data, size_t count) {
+        if (failed || !writeAll(fd, data, count)) {
+            failed = true;
+            return false;
+        }
+        while (count > 0) {
+            const uint64_t filled = length % kCheckpointBlockBytes;
+            if (filled == 0) {
+                checksums.push_back(0);
+            }
+            const size_t taken = static_cast<size_t>(std::min<uint64_t>(kCheckpointBlockBytes - filled, count));
+            checksums.back() = crc32cExtend(checksums.back(), data, taken);
+            data += taken;
+            count -= taken;
+            length += taken;
+        }
+        return true;
+    }
+
+    bool finish() {
+        const std::vector<uint8_t> trailer = checkpointTrailer(checksums, length);
+        const bool written = !failed && writeAll(fd, trailer.data(), trailer.size()) && syncFile(fd);
+        ::close(fd);
+        fd = -1;
+        return store->installWorld(path, temporaryPath, written);
+    }
+
+    void discard() {
+        ::close(fd);
+        fd = -1;
+        ::unlink(temporaryPath.c_str());
+    }
+};
+
+Store *asStore(void *handle) {
+    return static_cast<Store *>(handle);
+}
+
+Listing *asListing(void *listing) {
+    return static_cast<Listing *>(listing);
+}
+
+GameID makeID(const uint8_t *bytes) {
+    GameID id{};
+    std::memcpy(id.data(), bytes, id.size());
+    return id;
+}
+}  // namespace
+
+extern "C" void *SaveStoreOpen(const char *directory, char *errorBuffer, int32_t errorCapacity) {
+    auto store = std::make_unique<Store>();
+    store->directory = directory;
+    store->catalogPath = store->directory + "/saves.catalog";
+    store->previousCatalogPath = store->catalogPath + ".prev";
+    store->journalPath = store->directory + "/saves.journal";
+    store->sealedJournalPath = store->journalPath + ".sealed";
+    store->worldsDirectory = store->directory + "/worlds";
+    if (::mkdir(store->worldsDirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+        setError(errorBuffer, errorCapacity, "cannot create " + store->worldsDirectory + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    // A damaged catalog falls back to the previous checkpoint. The journal
+    // only holds changes made after the damaged one, so the changes between
+    // the two checkpoints are lost; the rest is replayed on top and a fresh
+    // catalog is written right away. The damaged file is deleted; the good
+    // one stays the previous checkpoint, as compaction only promotes a
+    // catalog that verifies.
+    bool recovered = false;
+    if (!mapCatalog(store->catalogPath, store->catalog)) {
+        if (!mapCatalog(store->previousCatalogPath, store->catalog) || !store->catalog->exists()) {
+            setError(errorBuffer, errorCapacity, "corrupt catalog " + store->catalogPath);
+            return nullptr;
+        }
+        ::unlink(store->catalogPath.c_str());
+        recovered = true;
+    }
+    store->catalogBytes = store->catalog->length;
+
+    const uint64_t baseSequence = store->catalog->sequence();
+    bool sealedFound = false;
+    if (!store->replayJournal(baseSequence, sealedFound)) {
+        setError(errorBuffer, errorCapacity, "cannot open journal " + store->journalPath + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    if ((recovered || sealedFound) && !store->compactNow()) {
+        setError(errorBuffer, errorCapacity, "cannot compact saves in " + store->directory + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    Store *opened = store.get();
+    store->compactor = std::thread([opened] { opened->runCompactor(); });
+    return store.release();
+}
+
+extern "C" void SaveStoreClose(void *handle) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return;
+    }
+    {
+        // An unfinished compaction is abandoned; its sealed journal is
+        // folded in at the next open.
+        std::lock_guard<std::mutex> lock(store->mutex);
+        store->closing = true;
+        store->compaction.notify_all();
+    }
+    store->compactor.join();
+    store->commit(store->nextSequence);
+    if (store->journalFd >= 0) {
+        ::close(store->journalFd);
+    }
+    delete store;
+}
+
+// Replaces the record of `id`. A non-negative `worldLength` first replaces
+// the game's world file durably with `world`, or, with a null `world`,
+// records the length of a world a `SaveStoreWorldWriter` just stored; a
+// negative one keeps the stored world. Returns the entry's sequence number for
+// `SaveStoreCommit`; the change is visible to readers immediately.
+extern "C" int64_t SaveStorePut(void *handle,
+                                const uint8_t *id,
+                                int32_t status,
+                                double balance,
+                                double createdAt,
+                                double updatedAt,
+                                double lastSavedAt,
+                                const char *name,
+                                int32_t nameLength,
+                                const char *playerName,
+                                int32_t playerNameLength,
+                                const char *companyName,
+                                int32_t companyNameLength,
+                                const uint8_t *world,
+                                int64_t worldLength) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return -1;
+    }
+
+    auto record = std::make_shared<Record>();
+    record->id = makeID(id);
+    record->status = status;
+    record->balance = balance;
+    record->createdAt = createdAt;
+    record->updatedAt = updatedAt;
+    record->lastSavedAt = lastSavedAt;
+    record->name.assign(name, static_cast<size_t>(nameLength));
+    record->playerName.assign(playerName, static_cast<size_t>(playerNameLength));
+    record->companyName.assign(companyName, static_cast<size_t>(companyNameLength));
+    if (worldLength >= 0) {
+        if (world != nullptr && !store->writeWorld(record->id, world, static_cast<size_t>(worldLength))) {
+            return -1;
+        }
+        record->worldLength = static_cast<uint64_t>(worldLength);
+    } else {
+        std::lock_guard<std::mutex> lock(store->mutex);
+        record->worldLength = store->storedWorldLength(record->id);
+    }
+    return static_cast<int64_t>(store->enqueue(Operation::put, std::move(record)));
+}
+
+// Replaces the world file of `id` with `world` and returns the new file's
+// generation, or -1. When the current file is generation `base`, holding
+// a world of `baseLength` bytes that differs from `world` only in
+// `ranges` (`rangeCount` offset and length pairs) and past `baseLength`,
+// only those bytes are written; otherwise, or with a `base` of 0, all of
+// it. Record the length with `SaveStorePut` and a null world.
+extern "C" int64_t SaveStoreWriteWorld(void *handle,
+                                       const uint8_t *id,
+                                       const uint8_t *world,
+                                       int64_t worldLength,
+                                       int64_t base,
+                                       int64_t baseLength,
+                                       const int64_t *ranges,
+                                       int32_t rangeCount) {
+    Store *store = asStore(handle);
+    if (store == nullptr || worldLength < 0 || base < 0 || baseLength < 0 || rangeCount < 0) {
+        return -1;
+    }
+    uint64_t generation = 0;
+    if (!store->writeWorldDelta(makeID(id), world, static_cast<size_t>(worldLength), static_cast<uint64_t>(base),
+                                static_cast<uint64_t>(baseLength), ranges, rangeCount, generation)) {
+        return -1;
+    }
+    return static_cast<int64_t>(generation);
+}
+
+extern "C" int64_t SaveStoreRemove(void *handle, const uint8_t *id) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return -1;
+    }
+    auto record = std::make_shared<Record>();
+    record->id = makeID(id);
+    return static_cast<int64_t>(store->enqueue(Operation::remove, std::move(record)));
+}
+
+// Folds every change committed so far into a new catalog on the compactor
+// thread and waits for it, deleting the world files of removed games; for
+// vacuuming after bulk removals. Returns 0, or -1 if the compaction failed
+// or the store is closing.
+extern "C" int32_t SaveStoreCompact(void *handle) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return -1;
+    }
+    std::unique_lock<std::mutex> lock(store->mutex);
+    const uint64_t attempts = store->compactionAttempts;
+    store->requestedSequence = std::max(store->requestedSequence, store->nextSequence);
+    store->compaction.notify_all();
+    store->compaction.wait(lock, [&] {
+        return store->closing || store->catalog->sequence() >= store->requestedSequence ||
+               (store->compactionFailed && store->compactionAttempts > attempts);
+    });
+    return store->catalog->sequence() >= store->requestedSequence ? 0 : -1;
+}
+
+// Blocks until the entry with `sequence` (and everything before it) is on
+// disk. Concurrent callers share one write and one sync. Returns 0 or -1.
+extern "C" int32_t SaveStoreCommit(void *handle, int64_t sequence) {
+    Store *store = asStore(handle);
+    if (store == nullptr || sequence < 0) {
+        return -1;
+    }
+    return store->commit(static_cast<uint64_t>(sequence)) ? 0 : -1;
+}
+
+// Snapshot of every game, unaffected by later saves. Records are read in
+// place from the catalog mapping; release with `SaveStoreListingClose`.
+extern "C" void *SaveStoreListingOpen(void *handle) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return nullptr;
+    }
+    return store->openListing().release();
+}
+
+extern "C" void SaveStoreListingClose(void *listing) {
+    delete asListing(listing);
+}
+
+extern "C" int32_t SaveStoreListingCount(void *listing) {
+    return static_cast<int32_t>(asListing(listing)->count());
+}
+
+// Listing index of the most recently updated active game, or -1. Usually
+// answered from the catalog header without touching other records.
+extern "C" int32_t SaveStoreListingLatestActive(void *listing) {
+    return asListing(listing)->latestActive();
+}
+
+// Listing index of the game with `id`, or -1.
+extern "C" int32_t SaveStoreListingFind(void *listing, const uint8_t *id) {
+    return asListing(listing)->find(makeID(id));
+}
+
+extern "C" void SaveStoreListingRecord(void *listing,
+                                       int32_t index,
+                                       uint8_t *id,
+                                       int32_t *status,
+                                       double *balance,
+                                       double *createdAt,
+                                       double *updatedAt,
+                                       double *lastSavedAt) {
+    const RecordView record = asListing(listing)->view(static_cast<size_t>(index));
+    std::memcpy(id, record.id, sizeof(GameID));
+    *status = record.status;
+    *balance = record.balance;
+    *createdAt = record.createdAt;
+    *updatedAt = record.updatedAt;
+    *lastSavedAt = record.lastSavedAt;
+}
+
+// Field 0 is the game name, 1 the player, 2 the company. The bytes are not
+// NUL-terminated and stay valid until the listing is closed.
+extern "C" const char *SaveStoreListingString(void *listing, int32_t index, int32_t field, int32_t *length) {
+    const RecordView record = asListing(listing)->view(static_cast<size_t>(index));
+    *length = static_cast<int32_t>(record.lengths[field]);
+    return record.strings[field];
+}
+
+// Maps the world of `id` read-only after verifying its block checksums,
+// falling back to the previous checkpoint when the current one is damaged.
+// Verifying reads every page once, unless this process verified the same
+// file before. Returns null when the game has no world,
+// with `length` set to -1 when it has one but no checkpoint is intact.
+// Release with `SaveStoreUnmapWorld` and `mappedLength`. The mapping
+// survives later saves of the game, which replace the file rather than
+// rewrite it.
+extern "C" const uint8_t *SaveStoreMapWorld(void *handle, const uint8_t *id, int64_t *length, int64_t *mappedLength) {
+    Store *store = asStore(handle);
+    *length = 0;
+    *mappedLength = 0;
+    const std::string path = store->worldPath(makeID(id));
+    MappedWorld world;
+    WorldCheck check = store->mapWorld(path, world);
+    if (check == WorldCheck::damaged && store->mapWorld(path + ".prev", world) == WorldCheck::intact) {
+        check = WorldCheck::intact;
+    }
+    // A damaged world stays damaged when its predecessor is missing too.
+    if (check != WorldCheck::intact) {
+        *length = check == WorldCheck::damaged ? -1 : 0;
+        return nullptr;
+    }
+    *length = static_cast<int64_t>(world.length);
+    *mappedLength = static_cast<int64_t>(world.mappedLength);
+    return world.data;
+}
+
+extern "C" void SaveStoreUnmapWorld(const uint8_t *mapping, int64_t length) {
+    if (mapping != nullptr) {
+        ::munmap(const_cast<uint8_t *>(mapping), static_cast<size_t>(length));
+    }
+}
+
+// Starts a new checkpoint of the world of `id`, to be filled with
+// `SaveStoreWorldWriterAppend` and ended with `SaveStoreWorldWriterFinish`.
+// Returns null when the temporary file cannot be created.
+extern "C" void *SaveStoreWorldWriterOpen(void *handle, const uint8_t *id) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return nullptr;
+    }
+    auto writer = std::make_unique<WorldWriter>();
+    writer->store = store;
+    writer->path = store->worldPath(makeID(id));
+    writer->temporaryPath = writer->path + ".tmp";
+    writer->fd = ::open(writer->temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd < 0) {
+        return nullptr;
+    }
+    return writer.release();
+}
+
+// Appends `length` world bytes. Returns 0, or -1 once any write failed.
+extern "C" int32_t SaveStoreWorldWriterAppend(void *writer, const uint8_t *data, int64_t length) {
+    return static_cast<WorldWriter *>(writer)->append(data, static_cast<size_t>(length)) ? 0 : -1;
+}
+
+// Ends the checkpoint and releases `writer`. With `keep` the checkpoint is
+// synced and replaces the game's world file, and the world length is
+// returned for `SaveStorePut`; otherwise, or on failure, it is deleted and
+// -1 is returned.
+extern "C" int64_t SaveStoreWorldWriterFinish(void *writer, int32_t keep) {
+    std::unique_ptr<WorldWriter> owned(static_cast<WorldWriter *>(writer));
+    if (keep == 0) {
+        owned->discard();
+        return -1;
+    }
+    return owned->finish() ? static_cast<int64_t>(owned->length) : -1;
+}
+
+// CRC32C of `length` bytes, the checksum world files use, for formats
+// built on top of the store.
+extern "C" uint32_t SaveStoreChecksum(const uint8_t *data, int64_t length) {
+    return crc32c(data, static_cast<size_t>(length));
+}
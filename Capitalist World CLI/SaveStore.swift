@@ -0,0 +1,615 @@
+import Foundation
+
+@_silgen_name("SaveStoreOpen")
+private func SaveStoreOpen(
+    _ directory: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> OpaquePointer?
+@_silgen_name("SaveStoreClose")
+private func SaveStoreClose(_ handle: OpaquePointer)
+@_silgen_name("SaveStorePut")
+private func SaveStorePut(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ status: Int32,
+    _ balance: Double,
+    _ createdAt: Double,
+    _ updatedAt: Double,
+    _ lastSavedAt: Double,
+    _ name: UnsafePointer<CChar>,
+    _ nameLength: Int32,
+    _ playerName: UnsafePointer<CChar>,
+    _ playerNameLength: Int32,
+    _ companyName: UnsafePointer<CChar>,
+    _ companyNameLength: Int32,
+    _ world: UnsafePointer<UInt8>?,
+    _ worldLength: Int64
+) -> Int64
+@_silgen_name("SaveStoreWriteWorld")
+private func SaveStoreWriteWorld(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ world: UnsafePointer<UInt8>?,
+    _ worldLength: Int64,
+    _ base: Int64,
+    _ baseLength: Int64,
+    _ ranges: UnsafePointer<Int64>?,
+    _ rangeCount: Int32
+) -> Int64
+@_silgen_name("SaveStoreImportCoreData")
+private func SaveStoreImportCoreData(
+    _ handle: OpaquePointer,
+    _ path: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> Int32
+@_silgen_name("SaveStoreRemove")
+private func SaveStoreRemove(_ handle: OpaquePointer, _ id: UnsafePointer<UInt8>) -> Int64
+@_silgen_name("SaveStoreCommit")
+private func SaveStoreCommit(_ handle: OpaquePointer, _ sequence: Int64) -> Int32
+@_silgen_name("SaveStoreCompact")
+private func SaveStoreCompact(_ handle: OpaquePointer) -> Int32
+@_silgen_name("SaveStoreListingOpen")
+private func SaveStoreListingOpen(_ handle: OpaquePointer) -> OpaquePointer
+@_silgen_name("SaveStoreListingClose")
+private func SaveStoreListingClose(_ listing: OpaquePointer)
+@_silgen_name("SaveStoreListingCount")
+private func SaveStoreListingCount(_ listing: OpaquePointer) -> Int32
+@_silgen_name("SaveStoreListingLatestActive")
+private func SaveStoreListingLatestActive(_ listing: OpaquePointer) -> Int32
+@_silgen_name("SaveStoreListingFind")
+private func SaveStoreListingFind(_ listing: OpaquePointer, _ id: UnsafePointer<UInt8>) -> Int32
+@_silgen_name("SaveStoreListingRecord")
+private func SaveStoreListingRecord(
+    _ listing: OpaquePointer,
+    _ index: Int32,
+    _ id: UnsafeMutablePointer<UInt8>,
+    _ status: UnsafeMutablePointer<Int32>,
+    _ balance: UnsafeMutablePointer<Double>,
+    _ createdAt: UnsafeMutablePointer<Double>,
+    _ updatedAt: UnsafeMutablePointer<Double>,
+    _ lastSavedAt: UnsafeMutablePointer<Double>
+)
+@_silgen_name("SaveStoreListingString")
+private func SaveStoreListingString(
+    _ listing: OpaquePointer,
+    _ index: Int32,
+    _ field: Int32,
+    _ length: UnsafeMutablePointer<Int32>
+) -> UnsafePointer<CChar>
+@_silgen_name("SaveStoreMapWorld")
+private func SaveStoreMapWorld(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ length: UnsafeMutablePointer<Int64>,
+    _ mappedLength: UnsafeMutablePointer<Int64>
+) -> UnsafePointer<UInt8>?
+@_silgen_name("SaveStoreUnmapWorld")
+private func SaveStoreUnmapWorld(_ mapping: UnsafePointer<UInt8>, _ length: Int64)
+@_silgen_name("SaveTransferExport")
+private func SaveTransferExport(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ status: Int32,
+    _ balance: Double,
+    _ createdAt: Double,
+    _ updatedAt: Double,
+    _ lastSavedAt: Double,
+    _ name: UnsafePointer<CChar>,
+    _ nameLength: Int32,
+    _ playerName: UnsafePointer<CChar>,
+    _ playerNameLength: Int32,
+    _ companyName: UnsafePointer<CChar>,
+    _ companyNameLength: Int32,
+    _ path: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> Int32
+@_silgen_name("SaveTransferImportAll")
+private func SaveTransferImportAll(
+    _ handle: OpaquePointer,
+    _ path: UnsafePointer<CChar>,
+    _ imported: @convention(c) (UnsafeMutableRawPointer?, UnsafePointer<UInt8>?) -> Void,
+    _ context: UnsafeMutableRawPointer?,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> Int32
+@_silgen_name("SaveTransferArchiveOpen")
+private func SaveTransferArchiveOpen(
+    _ path: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> OpaquePointer?
+@_silgen_name("SaveTransferArchiveAppend")
+private func SaveTransferArchiveAppend(
+    _ archive: OpaquePointer,
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ status: Int32,
+    _ balance: Double,
+    _ createdAt: Double,
+    _ updatedAt: Double,
+    _ lastSavedAt: Double,
+    _ name: UnsafePointer<CChar>,
+    _ nameLength: Int32,
+    _ playerName: UnsafePointer<CChar>,
+    _ playerNameLength: Int32,
+    _ companyName: UnsafePointer<CChar>,
+    _ companyNameLength: Int32,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> Int32
+@_silgen_name("SaveTransferArchiveSync")
+private func SaveTransferArchiveSync(
+    _ archive: OpaquePointer,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> Int32
+@_silgen_name("SaveTransferArchiveClose")
+private func SaveTransferArchiveClose(_ archive: OpaquePointer)
+
+enum SaveStoreError: LocalizedError {
+    case writeFailed(URL)
+    case worldDamaged(URL)
+    case exportFailed(URL, String)
+    case importFailed(URL, String)
+    case archiveFailed(URL, String)
+
+    var errorDescription: String? {
+        switch self {
+        case .writeFailed(let directory):
+            return Localization.shared.saveStoreWriteFailedMessage(directory)
+        case .worldDamaged(let directory):
+            return Localization.shared.saveStoreWorldDamagedMessage(directory)
+        case .exportFailed(let file, let reason):
+            return Localization.shared.exportFailedMessage(file, reason: reason)
+        case .importFailed(let file, let reason):
+            return Localization.shared.importFailedMessage(file, reason: reason)
+        case .archiveFailed(let file, let reason):
+            return Localization.shared.archiveFailedMessage(file, reason: reason)
+        }
+    }
+}
+
+/// Portable save storage under the XDG data directory: a memory-mapped
+/// catalog of fixed-size metadata records, a native append-only journal of
+/// changes since, and one world file per game. Writes are durable when
+/// `save` returns; concurrent savers share one fsync.
+final class SaveStore {
+    private enum StringField: Int32 {
+        case name
+        case playerName
+        case companyName
+    }
+
+    /// Outcome of importing the games of the Core Data store the first
+    /// releases saved to.
+    enum CoreDataImport {
+        case imported(count: Int, from: URL)
+        case failed(URL, reason: String)
+    }
+
+    /// A world file written by `save(_:worldState:changes:since:)`, which
+    /// the next save of the same game can patch instead of rewriting.
+    struct StoredWorld {
+        fileprivate let generation: Int64
+        fileprivate let length: Int
+    }
+
+    let directory: URL
+    private let handle: OpaquePointer
+
+    init() {
+        directory = Self.storageDirectory()
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        guard let handle = directory.path.withCString({ SaveStoreOpen($0, &errorBuffer, Int32(errorBuffer.count)) }) else {
+            fatalError(Localization.shared.saveStoreLoadErrorMessage(String(cString: errorBuffer)))
+        }
+        self.handle = handle
+    }
+
+    deinit {
+        SaveStoreClose(handle)
+    }
+
+    /// Writes the metadata of `game` and, when given, its world. Passing
+    /// `nil` keeps the world already stored.
+    func save(_ game: Game, worldState: Data? = nil) throws {
+        guard let worldState else {
+            return try put(game, world: nil, worldLength: -1)
+        }
+        try worldState.withUnsafeBytes { bytes in
+            try put(game, world: bytes.bindMemory(to: UInt8.self).baseAddress, worldLength: Int64(bytes.count))
+        }
+    }
+
+    /// Like `save(_:worldState:)`, but when `base` is the world file stored
+    /// last for `game` and `changes` are the ranges of `worldState` that
+    /// differ from it, writes only those ranges and whatever is past its
+    /// end. Any other file, or a `nil` base, is rewritten whole. Returns
+    /// the new file to pass as the next save's base.
+    func save(_ game: Game, worldState: Data, changes: [Range<Int>], since base: StoredWorld?) throws -> StoredWorld {
+        let ranges = changes.flatMap { [Int64($0.lowerBound), Int64($0.count)] }
+        let generation = withUnsafeBytes(of: game.id.uuid) { idBytes in
+            worldState.withUnsafeBytes { bytes in
+                SaveStoreWriteWorld(
+                    handle,
+                    idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                    bytes.bindMemory(to: UInt8.self).baseAddress,
+                    Int64(bytes.count),
+                    base?.generation ?? 0,
+                    Int64(base?.length ?? 0),
+                    ranges,
+                    Int32(changes.count)
+                )
+            }
+        }
+        guard generation >= 0 else {
+            throw SaveStoreError.writeFailed(directory)
+        }
+        try put(game, world: nil, worldLength: Int64(worldState.count))
+        return StoredWorld(generation: generation, length: worldState.count)
+    }
+
+    /// Records the metadata of `game` and commits it. A non-negative
+    /// `worldLength` with a `nil` world records a world file written
+    /// already.
+    private func put(_ game: Game, world: UnsafePointer<UInt8>?, worldLength: Int64) throws {
+        let sequence = withUnsafeBytes(of: game.id.uuid) { idBytes in
+            game.name.withCString { name in
+                game.playerName.withCString { playerName in
+                    game.companyName.withCString { companyName in
+                        SaveStorePut(
+                            self.handle,
+                            idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                            Self.statusCode(game.gameStatus),
+                            game.balance,
+                            game.createdAt.timeIntervalSince1970,
+                            game.updatedAt.timeIntervalSince1970,
+                            game.lastSavedAt.timeIntervalSince1970,
+                            name,
+                            Int32(game.name.utf8.count),
+                            playerName,
+                            Int32(game.playerName.utf8.count),
+                            companyName,
+                            Int32(game.companyName.utf8.count),
+                            world,
+                            worldLength
+                        )
+                    }
+                }
+            }
+        }
+
+        guard SaveStoreCommit(handle, sequence) == 0 else {
+            throw SaveStoreError.writeFailed(directory)
+        }
+    }
+
+    /// Every saved game, most recently updated first.
+    func fetchAllGames() -> [Game] {
+        let listing = SaveStoreListingOpen(handle)
+        defer { SaveStoreListingClose(listing) }
+
+        let count = SaveStoreListingCount(listing)
+        var games: [Game] = []
+        games.reserveCapacity(Int(count))
+        for index in 0..<count {
+            games.append(game(at: index, in: listing))
+        }
+        return games.sorted { $0.updatedAt > $1.updatedAt }
+    }
+
+    /// Most recently updated active game. Reads one catalog record instead
+    /// of materializing every game.
+    func latestActiveGame() -> Game? {
+        let listing = SaveStoreListingOpen(handle)
+        defer { SaveStoreListingClose(listing) }
+
+        let index = SaveStoreListingLatestActive(listing)
+        return index < 0 ? nil : game(at: index, in: listing)
+    }
+
+    /// Saved game with `id`, found by binary search in the catalog.
+    func game(withID id: UUID) -> Game? {
+        let listing = SaveStoreListingOpen(handle)
+        defer { SaveStoreListingClose(listing) }
+
+        let index = withUnsafeBytes(of: id.uuid) { idBytes in
+            SaveStoreListingFind(listing, idBytes.bindMemory(to: UInt8.self).baseAddress!)
+        }
+        return index < 0 ? nil : game(at: index, in: listing)
+    }
+
+    /// Writes `game` and its saved world to `file` in the portable export
+    /// format. The world streams from its file through compression workers
+    /// a chunk at a time, so memory use does not grow with its size.
+    func export(_ game: Game, to file: URL) throws {
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        let result = withUnsafeBytes(of: game.id.uuid) { idBytes in
+            game.name.withCString { name in
+                game.playerName.withCString { playerName in
+                    game.companyName.withCString { companyName in
+                        file.path.withCString { path in
+                            SaveTransferExport(
+                                handle,
+                                idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                                Self.statusCode(game.gameStatus),
+                                game.balance,
+                                game.createdAt.timeIntervalSince1970,
+                                game.updatedAt.timeIntervalSince1970,
+                                game.lastSavedAt.timeIntervalSince1970,
+                                name,
+                                Int32(game.name.utf8.count),
+                                playerName,
+                                Int32(game.playerName.utf8.count),
+                                companyName,
+                                Int32(game.companyName.utf8.count),
+                                path,
+                                &errorBuffer,
+                                Int32(errorBuffer.count)
+                            )
+                        }
+                    }
+                }
+            }
+        }
+        guard result == 0 else {
+            throw SaveStoreError.exportFailed(file, String(cString: errorBuffer))
+        }
+    }
+
+    /// Adds every game in `file`, an export or a cold archive, as a new
+    /// game with a fresh ID, so importing never overwrites a local game, not
+    /// even its own original. The file is imported whole or not at all: a
+    /// damaged record removes the games read before it, so importing the
+    /// file again after repairing it adds each game once.
+    func importGames(from file: URL) throws -> [Game] {
+        var ids: [UUID] = []
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        let result = withUnsafeMutablePointer(to: &ids) { collected in
+            file.path.withCString { path in
+                SaveTransferImportAll(
+                    handle,
+                    path,
+                    { context, id in
+                        let ids = context!.assumingMemoryBound(to: [UUID].self)
+                        ids.pointee.append(UUID(uuid: UnsafeRawPointer(id!).loadUnaligned(as: uuid_t.self)))
+                    },
+                    collected,
+                    &errorBuffer,
+                    Int32(errorBuffer.count)
+                )
+            }
+        }
+        guard result >= 0 else {
+            throw SaveStoreError.importFailed(file, String(cString: errorBuffer))
+        }
+        return ids.compactMap(game(withID:))
+    }
+
+    /// Removes `games` from the catalog in one journal commit.
+    private func remove(_ games: [Game]) throws {
+        guard games.isEmpty == false else { return }
+        var sequence: Int64 = -1
+        for game in games {
+            sequence = withUnsafeBytes(of: game.id.uuid) { idBytes in
+                SaveStoreRemove(handle, idBytes.bindMemory(to: UInt8.self).baseAddress!)
+            }
+        }
+        guard SaveStoreCommit(handle, sequence) == 0 else {
+            throw SaveStoreError.writeFailed(directory)
+        }
+    }
+
+    /// Moves `games` out of the store into the cold archive at `file`,
+    /// `batchSize` at a time. Each batch is appended to the archive and
+    /// synced, then removed from the catalog in one journal commit, so a
+    /// game is never in neither place; a crash between the two leaves it in
+    /// both. `onBatch` gets each batch once it is out of the store. A game
+    /// whose world is damaged is archived without it rather than holding
+    /// up the rest; those games are returned.
+    @discardableResult
+    func archive(_ games: [Game], to file: URL, batchSize: Int, onBatch: ([Game]) -> Void) throws -> [Game] {
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        guard let archive = file.path.withCString({
+            SaveTransferArchiveOpen($0, &errorBuffer, Int32(errorBuffer.count))
+        }) else {
+            throw SaveStoreError.archiveFailed(file, String(cString: errorBuffer))
+        }
+        defer { SaveTransferArchiveClose(archive) }
+
+        var damaged: [Game] = []
+        for start in stride(from: 0, to: games.count, by: batchSize) {
+            let batch = games[start..<min(start + batchSize, games.count)]
+            for game in batch {
+                let result = withUnsafeBytes(of: game.id.uuid) { idBytes in
+                    game.name.withCString { name in
+                        game.playerName.withCString { playerName in
+                            game.companyName.withCString { companyName in
+                                SaveTransferArchiveAppend(
+                                    archive,
+                                    handle,
+                                    idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                                    Self.statusCode(game.gameStatus),
+                                    game.balance,
+                                    game.createdAt.timeIntervalSince1970,
+                                    game.updatedAt.timeIntervalSince1970,
+                                    game.lastSavedAt.timeIntervalSince1970,
+                                    name,
+                                    Int32(game.name.utf8.count),
+                                    playerName,
+                                    Int32(game.playerName.utf8.count),
+                                    companyName,
+                                    Int32(game.companyName.utf8.count),
+                                    &errorBuffer,
+                                    Int32(errorBuffer.count)
+                                )
+                            }
+                        }
+                    }
+                }
+                guard result >= 0 else {
+                    throw SaveStoreError.archiveFailed(file, String(cString: errorBuffer))
+                }
+                if result == 1 {
+                    damaged.append(game)
+                }
+            }
+            guard SaveTransferArchiveSync(archive, &errorBuffer, Int32(errorBuffer.count)) == 0 else {
+                throw SaveStoreError.archiveFailed(file, String(cString: errorBuffer))
+            }
+
+            try remove(Array(batch))
+            onBatch(Array(batch))
+        }
+        return damaged
+    }
+
+    /// Folds every change into a new catalog now rather than when the
+    /// journal grows, and deletes the world files of removed games.
+    func compact() throws {
+        guard SaveStoreCompact(handle) == 0 else {
+            throw SaveStoreError.writeFailed(directory)
+        }
+    }
+
+    /// Saved world of the game with `id`, memory-mapped rather than read
+    /// into a buffer; the mapping is released with the returned `Data`.
+    /// Every block checksum is verified first, which reads the whole file
+    /// unless this process verified it already, and a damaged world falls
+    /// back to the game's previous checkpoint. `nil` when the game has no
+    /// world; throws when no checkpoint is intact.
+    func worldState(for id: UUID) throws -> Data? {
+        try withUnsafeBytes(of: id.uuid) { idBytes in
+            var length: Int64 = 0
+            var mappedLength: Int64 = 0
+            guard let mapping = SaveStoreMapWorld(
+                handle,
+                idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                &length,
+                &mappedLength
+            ) else {
+                guard length == 0 else { throw SaveStoreError.worldDamaged(directory) }
+                return nil
+            }
+            return Data(
+                bytesNoCopy: UnsafeMutableRawPointer(mutating: mapping),
+                count: Int(length),
+                deallocator: .custom { pointer, _ in
+                    SaveStoreUnmapWorld(pointer.assumingMemoryBound(to: UInt8.self), mappedLength)
+                }
+            )
+        }
+    }
+
+    /// Adds the games of the Core Data store the first releases kept in
+    /// Application Support, once: a marker in the store directory records
+    /// that they were imported, so games deleted since stay deleted. The
+    /// games keep their ids and get a world when they are played; the Core
+    /// Data store is left in place. Returns `nil` when there is nothing to
+    /// import. A failed import is retried at the next start.
+    func importCoreDataGames() -> CoreDataImport? {
+        let fileManager = FileManager.default
+        let marker = directory.appendingPathComponent("coredata.imported")
+        guard fileManager.fileExists(atPath: marker.path) == false,
+              let base = try? fileManager.url(
+                  for: .applicationSupportDirectory,
+                  in: .userDomainMask,
+                  appropriateFor: nil,
+                  create: false
+              )
+        else {
+            return nil
+        }
+        let source = base
+            .appendingPathComponent("CapitalistWorldCLI", isDirectory: true)
+            .appendingPathComponent("CapitalistWorldCLI.sqlite")
+        guard fileManager.fileExists(atPath: source.path) else {
+            return nil
+        }
+
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        let count = source.path.withCString { path in
+            SaveStoreImportCoreData(handle, path, &errorBuffer, Int32(errorBuffer.count))
+        }
+        guard count >= 0 else {
+            return .failed(source, reason: String(cString: errorBuffer))
+        }
+        fileManager.createFile(atPath: marker.path, contents: nil)
+        return .imported(count: Int(count), from: source)
+    }
+
+    /// `$XDG_DATA_HOME/capitalist-world`, falling back to
+    /// `~/.local/share/capitalist-world`.
+    static func storageDirectory() -> URL {
+        let fileManager = FileManager.default
+        let environment = ProcessInfo.processInfo.environment
+        let base: URL
+        if let dataHome = environment["XDG_DATA_HOME"], dataHome.hasPrefix("/") {
+            base = URL(fileURLWithPath: dataHome, isDirectory: true)
+        } else {
+            base = fileManager.homeDirectoryForCurrentUser
+                .appendingPathComponent(".local", isDirectory: true)
+                .appendingPathComponent("share", isDirectory: true)
+        }
+
+        let directory = base.appendingPathComponent("capitalist-world", isDirectory: true)
+        do {
+            try fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
+        } catch {
+            fatalError(Localization.shared.dataDirectoryErrorMessage(error))
+        }
+        return directory
+    }
+
+    private static func statusCode(_ status: GameStatus) -> Int32 {
+        switch status {
+        case .active:
+            return 0
+        case .abandoned:
+            return 1
+        }
+    }
+
+    private func game(at index: Int32, in listing: OpaquePointer) -> Game {
+        var id = UUID().uuid
+        var status: Int32 = 0
+        var balance = 0.0
+        var createdAt = 0.0
+        var updatedAt = 0.0
+        var lastSavedAt = 0.0
+        withUnsafeMutableBytes(of: &id) { idBytes in
+            SaveStoreListingRecord(
+                listing,
+                index,
+                idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                &status,
+                &balance,
+                &createdAt,
+                &updatedAt,
+                &lastSavedAt
+            )
+        }
+
+        return Game(
+            id: UUID(uuid: id),
+            name: string(index, .name, in: listing),
+            playerName: string(index, .playerName, in: listing),
+            companyName: string(index, .companyName, in: listing),
+            gameStatus: status == 0 ? .active : .abandoned,
+            balance: balance,
+            createdAt: Date(timeIntervalSince1970: createdAt),
+            updatedAt: Date(timeIntervalSince1970: updatedAt),
+            lastSavedAt: Date(timeIntervalSince1970: lastSavedAt)
+        )
+    }
+
+    private func string(_ index: Int32, _ field: StringField, in listing: OpaquePointer) -> String {
+        var length: Int32 = 0
+        let pointer = SaveStoreListingString(listing, index, field.rawValue, &length)
+        let bytes = UnsafeRawBufferPointer(start: pointer, count: Int(length))
+        return String(decoding: bytes, as: UTF8.self)
+    }
+}
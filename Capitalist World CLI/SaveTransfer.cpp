@@ -0,0 +1,839 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" const uint8_t *SaveStoreMapWorld(void *handle, const uint8_t *id, int64_t *length, int64_t *mappedLength);
+extern "C" void SaveStoreUnmapWorld(const uint8_t *mapping, int64_t length);
+extern "C" void *SaveStoreWorldWriterOpen(void *handle, const uint8_t *id);
+extern "C" int32_t SaveStoreWorldWriterAppend(void *writer, const uint8_t *data, int64_t length);
+extern "C" int64_t SaveStoreWorldWriterFinish(void *writer, int32_t keep);
+extern "C" int64_t SaveStorePut(void *handle,
+                                const uint8_t *id,
+                                int32_t status,
+                                double balance,
+                                double createdAt,
+                                double updatedAt,
+                                double lastSavedAt,
+                                const char *name,
+                                int32_t nameLength,
+                                const char *playerName,
+                                int32_t playerNameLength,
+                                const char *companyName,
+                                int32_t companyNameLength,
+                                const uint8_t *world,
+                                int64_t worldLength);
+extern "C" int64_t SaveStoreRemove(void *handle, const uint8_t *id);
+extern "C" int32_t SaveStoreCommit(void *handle, int64_t sequence);
+extern "C" uint32_t SaveStoreChecksum(const uint8_t *data, int64_t length);
+
+namespace {
+constexpr uint32_t kTransferMagic = 0x58455743;  // "CWEX"
+constexpr uint32_t kTransferVersion = 1;
+// Worlds travel in chunks of this size, each compressed independently so
+// chunks are compressed and decompressed in parallel.
+constexpr uint32_t kChunkBytes = 1u << 20;
+// Chunks in flight per worker. Memory stays at a few chunks per core
+// whatever the size of the world.
+constexpr size_t kChunksPerWorker = 2;
+constexpr uint32_t kFrameCompressed = 1;
+constexpr size_t kMaximumStringBytes = 1u << 16;
+
+// LZ4 block format limits: matches are at least four bytes long and reach
+// at most 64 KiB back, the last five bytes are always literals, and no
+// match starts in the last twelve.
+constexpr size_t kMinimumMatch = 4;
+constexpr size_t kMaximumOffset = 65535;
+constexpr size_t kLastLiterals = 5;
+constexpr size_t kMatchStartLimit = 12;
+constexpr int kHashBits = 14;
+
+// Header of an export file, followed by the name, player and company
+// bytes and then by the world as frames.
+struct TransferHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t status;
+    uint32_t chunkBytes;
+    double balance;
+    double createdAt;
+    double updatedAt;
+    double lastSavedAt;
+    uint64_t worldLength;
+    uint32_t nameLength;
+    uint32_t playerNameLength;
+    uint32_t companyNameLength;
+    // CRC32C of the header up to here and of the three strings.
+    uint32_t checksum;
+};
+
+// One chunk of the world. A frame with `rawLength` 0 ends the world.
+struct FrameHeader {
+    uint32_t storedLength;
+    uint32_t rawLength;
+    // CRC32C of the raw chunk.
+    uint32_t checksum;
+    uint32_t flags;
+};
+
+static_assert(sizeof(TransferHeader) == 72, "TransferHeader layout changed");
+static_assert(sizeof(FrameHeader) == 16, "FrameHeader layout changed");
+
+size_t lz4Bound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+uint32_t load32(const uint8_t *data) {
+    uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint8_t *writeLengthTail(uint8_t *out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *out++ = 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+// Emits one LZ4 sequence: `literalCount` literals, then a match of
+// `matchLength` bytes `offset` back unless `matchLength` is 0.
+uint8_t *writeSequence(uint8_t *out, const uint8_t *literals, size_t literalCount, size_t offset, size_t matchLength) {
+    const size_t matchCode = matchLength == 0 ? 0 : matchLength - kMinimumMatch;
+    *out++ = static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4 | std::min<size_t>(matchCode, 15));
+    if (literalCount >= 15) {
+        out = writeLengthTail(out, literalCount - 15);
+    }
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0) {
+        return out;
+    }
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    if (matchCode >= 15) {
+        out = writeLengthTail(out, matchCode - 15);
+    }
+    return out;
+}
+
+// Compresses `length` bytes into LZ4 block format, readable by any LZ4
+// decoder. `out` must hold `lz4Bound(length)` bytes. A single-probe hash
+// table finds matches, and runs without one are skipped ever faster, as
+// in the reference fast mode: speed over ratio, since chunks are written
+// while the game keeps running.
+size_t lz4Compress(const uint8_t *data, size_t length, uint8_t *out) {
+    uint8_t *const start = out;
+    const uint8_t *anchor = data;
+    if (length > kMatchStartLimit) {
+        std::vector<uint32_t> table(size_t{1} << kHashBits, 0);
+        const uint8_t *const matchStartLimit = data + length - kMatchStartLimit;
+        const uint8_t *const matchEndLimit = data + length - kLastLiterals;
+        const uint8_t *cursor = data;
+        while (cursor < matchStartLimit) {
+            const uint32_t sequence = load32(cursor);
+            const uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+            const uint8_t *candidate = data + table[hash];
+            table[hash] = static_cast<uint32_t>(cursor - data);
+            if (candidate >= cursor || static_cast<size_t>(cursor - candidate) > kMaximumOffset ||
+                load32(candidate) != sequence) {
+                cursor += 1 + (static_cast<size_t>(cursor - anchor) >> 6);
+                continue;
+            }
+
+            const uint8_t *matchEnd = cursor + kMinimumMatch;
+            const uint8_t *source = candidate + kMinimumMatch;
+            while (matchEnd < matchEndLimit && *matchEnd == *source) {
+                ++matchEnd;
+                ++source;
+            }
+            out = writeSequence(out, anchor, static_cast<size_t>(cursor - anchor), static_cast<size_t>(cursor - candidate),
+                                static_cast<size_t>(matchEnd - cursor));
+            cursor = anchor = matchEnd;
+        }
+    }
+    out = writeSequence(out, anchor, static_cast<size_t>(data + length - anchor), 0, 0);
+    return static_cast<size_t>(out - start);
+}
+
+bool readLengthTail(const uint8_t *&in, const uint8_t *end, size_t &length) {
+    uint8_t byte = 255;
+    while (byte == 255) {
+        if (in == end) {
+            return false;
+        }
+        byte = *in++;
+        length += byte;
+    }
+    return true;
+}
+
+// Decodes an LZ4 block that must expand to exactly `length` bytes. Every
+// length and offset is checked, so damaged input fails instead of reading
+// or writing out of bounds.
+bool lz4Decompress(const uint8_t *in, size_t inLength, uint8_t *out, size_t length) {
+    const uint8_t *const inEnd = in + inLength;
+    uint8_t *const start = out;
+    uint8_t *const end = out + length;
+    while (in < inEnd) {
+        const uint8_t token = *in++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLengthTail(in, inEnd, literalCount)) {
+            return false;
+        }
+        if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > static_cast<size_t>(end - out)) {
+            return false;
+        }
+        std::memcpy(out, in, literalCount);
+        in += literalCount;
+        out += literalCount;
+        if (in == inEnd) {
+            break;
+        }
+
+        if (inEnd - in < 2) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(in[0]) | static_cast<size_t>(in[1]) << 8;
+        in += 2;
+        size_t matchLength = token & 15u;
+        if (matchLength == 15 && !readLengthTail(in, inEnd, matchLength)) {
+            return false;
+        }
+        matchLength += kMinimumMatch;
+        if (offset == 0 || offset > static_cast<size_t>(out - start) || matchLength > static_cast<size_t>(end - out)) {
+            return false;
+        }
+        const uint8_t *source = out - offset;
+        if (offset >= matchLength) {
+            std::memcpy(out, source, matchLength);
+            out += matchLength;
+        } else {
+            for (size_t index = 0; index < matchLength; ++index) {
+                *out++ = *source++;
+            }
+        }
+    }
+    return out == end;
+}
+
+// A chunk in flight. The producer fills `input` (pointing into `buffer`
+// or elsewhere), a worker fills `output` and the frame header, and the
+// consumer writes the result out.
+struct Chunk {
+    const uint8_t *input = nullptr;
+    size_t inputLength = 0;
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> output;
+    FrameHeader frame{};
+};
+
+// Runs chunks through `transform` on a pool of worker threads, one chunk
+// per task, while the calling thread produces chunks in order with
+// `produce` and consumes them in the same order with `consume`. At most
+// `kChunksPerWorker` chunks per worker exist at once, so reading, the
+// workers and writing overlap with bounded memory. `produce` returns 1 for
+// a chunk, 0 at the end and -1 on failure. Returns whether every step
+// succeeded; on failure the pool stops early.
+template <typename Produce, typename Transform, typename Consume>
+bool runPipeline(Produce produce, Transform transform, Consume consume) {
+    enum class State { queued, done, failed };
+
+    const size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    const size_t window = workers * kChunksPerWorker;
+    std::vector<Chunk> chunks(window);
+    std::vector<State> states(window, State::done);
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint64_t produced = 0;
+    uint64_t claimed = 0;
+    bool stopping = false;
+
+    std::vector<std::thread> pool;
+    for (size_t worker = 0; worker < workers; ++worker) {
+        pool.emplace_back([&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                changed.wait(lock, [&] { return stopping || claimed < produced; });
+                if (stopping) {
+                    return;
+                }
+                const size_t slot = static_cast<size_t>(claimed++ % window);
+                lock.unlock();
+                const bool transformed = transform(chunks[slot]);
+                lock.lock();
+                states[slot] = transformed ? State::done : State::failed;
+                changed.notify_all();
+            }
+        });
+    }
+
+    bool succeeded = true;
+    bool exhausted = false;
+    uint64_t consumed = 0;
+    while (succeeded) {
+        while (!exhausted && produced - consumed < window) {
+            const size_t slot = static_cast<size_t>(produced % window);
+            const int result = produce(chunks[slot]);
+            if (result <= 0) {
+                succeeded = result == 0;
+                exhausted = true;
+                break;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            states[slot] = State::queued;
+            ++produced;
+            changed.notify_all();
+        }
+        if (!succeeded || consumed == produced) {
+            break;
+        }
+
+        const size_t slot = static_cast<size_t>(consumed % window);
+        State state;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return states[slot] != State::queued; });
+            state = states[slot];
+        }
+        succeeded = state == State::done && consume(chunks[slot]);
+        ++consumed;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        changed.notify_all();
+    }
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    return succeeded;
+}
+
+// Compresses a chunk, keeping it raw when LZ4 does not shrink it.
+bool compressChunk(Chunk &chunk) {
+    chunk.output.resize(lz4Bound(chunk.inputLength));
+    const size_t compressed = lz4Compress(chunk.input, chunk.inputLength, chunk.output.data());
+    chunk.frame.rawLength = static_cast<uint32_t>(chunk.inputLength);
+    chunk.frame.checksum = SaveStoreChecksum(chunk.input, static_cast<int64_t>(chunk.inputLength));
+    if (compressed < chunk.inputLength) {
+        chunk.output.resize(compressed);
+        chunk.frame.flags = kFrameCompressed;
+    } else {
+        chunk.output.assign(chunk.input, chunk.input + chunk.inputLength);
+        chunk.frame.flags = 0;
+    }
+    chunk.frame.storedLength = static_cast<uint32_t>(chunk.output.size());
+    return true;
+}
+
+// Restores a chunk read from a frame and checks it against its checksum.
+bool decompressChunk(Chunk &chunk) {
+    if ((chunk.frame.flags & kFrameCompressed) == 0) {
+        chunk.output.assign(chunk.input, chunk.input + chunk.inputLength);
+    } else {
+        chunk.output.resize(chunk.frame.rawLength);
+        if (!lz4Decompress(chunk.input, chunk.inputLength, chunk.output.data(), chunk.output.size())) {
+            return false;
+        }
+    }
+    return chunk.output.size() == chunk.frame.rawLength &&
+           SaveStoreChecksum(chunk.output.data(), static_cast<int64_t>(chunk.output.size())) == chunk.frame.checksum;
+}
+
+bool writeAll(int fd, const void *data, size_t length) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    while (length > 0) {
+        const ssize_t written = ::write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Reads exactly `length` bytes; false on error or early end of file.
+bool readAll(int fd, void *data, size_t length) {
+    auto *bytes = static_cast<uint8_t *>(data);
+    while (length > 0) {
+        const ssize_t count = ::read(fd, bytes, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        length -= static_cast<size_t>(count);
+    }
+    return true;
+}
+
+uint32_t headerChecksum(const TransferHeader &header, const std::string &strings) {
+    std::vector<uint8_t> covered(offsetof(TransferHeader, checksum));
+    std::memcpy(covered.data(), &header, covered.size());
+    covered.insert(covered.end(), strings.begin(), strings.end());
+    return SaveStoreChecksum(covered.data(), static_cast<int64_t>(covered.size()));
+}
+
+void setError(char *buffer, int32_t capacity, const std::string &message) {
+    if (buffer == nullptr || capacity <= 0) {
+        return;
+    }
+    std::snprintf(buffer, static_cast<size_t>(capacity), "%s", message.c_str());
+}
+
+std::string systemError(const std::string &path) {
+    return path + ": " + std::strerror(errno);
+}
+
+// Header and string block of a record for the given metadata; the world
+// length is filled in once the world is mapped.
+TransferHeader makeHeader(int32_t status,
+                          double balance,
+                          double createdAt,
+                          double updatedAt,
+                          double lastSavedAt,
+                          const char *name,
+                          int32_t nameLength,
+                          const char *playerName,
+                          int32_t playerNameLength,
+                          const char *companyName,
+                          int32_t companyNameLength,
+                          std::string &strings) {
+    strings.assign(name, static_cast<size_t>(nameLength));
+    strings.append(playerName, static_cast<size_t>(playerNameLength));
+    strings.append(companyName, static_cast<size_t>(companyNameLength));
+    return TransferHeader{kTransferMagic,
+                          kTransferVersion,
+                          status,
+                          kChunkBytes,
+                          balance,
+                          createdAt,
+                          updatedAt,
+                          lastSavedAt,
+                          0,
+                          static_cast<uint32_t>(nameLength),
+                          static_cast<uint32_t>(playerNameLength),
+                          static_cast<uint32_t>(companyNameLength),
+                          0};
+}
+
+// Writes one record at the end of `fd`: `header`, `strings` and the saved
+// world of `id` as frames. The world is mapped and streamed through the
+// pipeline a chunk at a time; pages already written are dropped from
+// memory. Unless `worldRequired`, a game whose world is missing or damaged
+// is written with an empty one, and `damaged` tells which. Nothing is
+// synced. On failure `error` says why, naming `path` for I/O errors.
+bool writeRecord(int fd,
+                 void *store,
+                 const uint8_t *id,
+                 TransferHeader header,
+                 const std::string &strings,
+                 bool worldRequired,
+                 const std::string &path,
+                 bool &damaged,
+                 std::string &error) {
+    int64_t worldLength = 0;
+    int64_t mappedLength = 0;
+    const uint8_t *world = SaveStoreMapWorld(store, id, &worldLength, &mappedLength);
+    damaged = worldLength < 0;
+    if (world == nullptr && worldRequired) {
+        error = damaged ? "saved world is damaged" : "game has no saved world";
+        return false;
+    }
+    if (world == nullptr) {
+        worldLength = 0;
+    }
+    if (world != nullptr) {
+        ::madvise(const_cast<uint8_t *>(world), static_cast<size_t>(worldLength), MADV_SEQUENTIAL);
+    }
+    header.worldLength = static_cast<uint64_t>(worldLength);
+    header.checksum = headerChecksum(header, strings);
+
+    uint64_t offset = 0;
+    bool written = writeAll(fd, &header, sizeof(header)) && writeAll(fd, strings.data(), strings.size());
+    written = written && runPipeline(
+                             [&](Chunk &chunk) {
+                                 if (offset == static_cast<uint64_t>(worldLength)) {
+                                     return 0;
+                                 }
+                                 chunk.input = world + offset;
+                                 chunk.inputLength =
+                                     static_cast<size_t>(std::min<uint64_t>(kChunkBytes, worldLength - offset));
+                                 offset += chunk.inputLength;
+                                 return 1;
+                             },
+                             compressChunk,
+                             [&](Chunk &chunk) {
+                                 // Chunks start at multiples of the chunk
+                                 // size, so each is page aligned.
+                                 ::madvise(const_cast<uint8_t *>(chunk.input), chunk.inputLength, MADV_DONTNEED);
+                                 return writeAll(fd, &chunk.frame, sizeof(chunk.frame)) &&
+                                        writeAll(fd, chunk.output.data(), chunk.output.size());
+                             });
+    const FrameHeader end{0, 0, 0, 0};
+    written = written && writeAll(fd, &end, sizeof(end));
+    if (!written) {
+        error = systemError(path);
+    }
+    if (world != nullptr) {
+        SaveStoreUnmapWorld(world, mappedLength);
+    }
+    return written;
+}
+
+// Directory holding `path`, for syncing its entry.
+std::string parentDirectory(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+bool syncDirectory(const std::string &directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+// A cold archive open for appending: export records one after another.
+// Records past `syncedLength` are not durable yet and are cut off again
+// on close, so the file only ever grows by whole synced batches.
+struct Archive {
+    std::string path;
+    int fd = -1;
+    uint64_t length = 0;
+    uint64_t syncedLength = 0;
+    bool created = false;
+};
+using GameID = std::array<uint8_t, 16>;
+
+// Random (version 4) UUID for an imported game.
+GameID randomID(std::random_device &random) {
+    GameID id{};
+    for (size_t offset = 0; offset < id.size(); offset += sizeof(uint32_t)) {
+        const uint32_t value = random();
+        std::memcpy(id.data() + offset, &value, sizeof(value));
+    }
+    id[6] = static_cast<uint8_t>((id[6] & 0x0F) | 0x40);
+    id[8] = static_cast<uint8_t>((id[8] & 0x3F) | 0x80);
+    return id;
+}
+}  // namespace
+
+// Writes the game `id` with the given metadata to an export file at
+// `path`. The file appears under its name only once complete. Returns 0,
+// or -1 with a reason in `errorBuffer`.
+extern "C" int32_t SaveTransferExport(void *store,
+                                      const uint8_t *id,
+                                      int32_t status,
+                                      double balance,
+                                      double createdAt,
+                                      double updatedAt,
+                                      double lastSavedAt,
+                                      const char *name,
+                                      int32_t nameLength,
+                                      const char *playerName,
+                                      int32_t playerNameLength,
+                                      const char *companyName,
+                                      int32_t companyNameLength,
+                                      const char *path,
+                                      char *errorBuffer,
+                                      int32_t errorCapacity) {
+    std::string strings;
+    const TransferHeader header = makeHeader(status, balance, createdAt, updatedAt, lastSavedAt, name, nameLength,
+                                             playerName, playerNameLength, companyName, companyNameLength, strings);
+
+    const std::string destination = path;
+    const std::string temporaryPath = destination + ".tmp";
+    const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        setError(errorBuffer, errorCapacity, systemError(temporaryPath));
+        return -1;
+    }
+
+    std::string error;
+    bool damaged = false;
+    bool written = writeRecord(fd, store, id, header, strings, true, temporaryPath, damaged, error);
+    if (written && ::fsync(fd) != 0) {
+        written = false;
+        error = systemError(temporaryPath);
+    }
+    ::close(fd);
+
+    if (!written || ::rename(temporaryPath.c_str(), destination.c_str()) != 0) {
+        setError(errorBuffer, errorCapacity, written ? systemError(destination) : error);
+        ::unlink(temporaryPath.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+// Opens the cold archive at `path` for appending, creating it if needed.
+// An existing file must be an archive or export file. Returns a handle for
+// `SaveTransferArchiveAppend`, or null with a reason in `errorBuffer`.
+extern "C" void *SaveTransferArchiveOpen(const char *path, char *errorBuffer, int32_t errorCapacity) {
+    auto archive = std::make_unique<Archive>();
+    archive->path = path;
+    archive->fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    struct stat info {};
+    if (archive->fd < 0 || ::fstat(archive->fd, &info) != 0) {
+        setError(errorBuffer, errorCapacity, systemError(archive->path));
+        if (archive->fd >= 0) {
+            ::close(archive->fd);
+        }
+        return nullptr;
+    }
+
+    archive->length = static_cast<uint64_t>(info.st_size);
+    archive->syncedLength = archive->length;
+    archive->created = info.st_size == 0;
+    uint32_t magic = 0;
+    if (!archive->created && (!readAll(archive->fd, &magic, sizeof(magic)) || magic != kTransferMagic)) {
+        setError(errorBuffer, errorCapacity, "not an export file");
+        ::close(archive->fd);
+        return nullptr;
+    }
+    return archive.release();
+}
+
+// Appends the game `id` with the given metadata to `archive` as one
+// record; games without a saved world, or whose world is damaged beyond
+// both checkpoints, are archived with an empty one. The record is not
+// durable until `SaveTransferArchiveSync`. Returns 0, 1 when a damaged
+// world was left out, or -1 with a reason in `errorBuffer`, leaving the
+// archive as it was.
+extern "C" int32_t SaveTransferArchiveAppend(void *archive,
+                                             void *store,
+                                             const uint8_t *id,
+                                             int32_t status,
+                                             double balance,
+                                             double createdAt,
+                                             double updatedAt,
+                                             double lastSavedAt,
+                                             const char *name,
+                                             int32_t nameLength,
+                                             const char *playerName,
+                                             int32_t playerNameLength,
+                                             const char *companyName,
+                                             int32_t companyNameLength,
+                                             char *errorBuffer,
+                                             int32_t errorCapacity) {
+    auto *cold = static_cast<Archive *>(archive);
+    std::string strings;
+    const TransferHeader header = makeHeader(status, balance, createdAt, updatedAt, lastSavedAt, name, nameLength,
+                                             playerName, playerNameLength, companyName, companyNameLength, strings);
+
+    std::string error;
+    bool damaged = false;
+    const off_t end = ::lseek(cold->fd, static_cast<off_t>(cold->length), SEEK_SET);
+    if (end < 0 || !writeRecord(cold->fd, store, id, header, strings, false, cold->path, damaged, error)) {
+        setError(errorBuffer, errorCapacity, end < 0 ? systemError(cold->path) : error);
+        ::ftruncate(cold->fd, static_cast<off_t>(cold->length));
+        return -1;
+    }
+    cold->length = static_cast<uint64_t>(::lseek(cold->fd, 0, SEEK_CUR));
+    return damaged ? 1 : 0;
+}
+
+// Makes every record appended to `archive` so far durable, the file's
+// directory entry included when the archive is new. Returns 0, or -1 with
+// a reason in `errorBuffer`.
+extern "C" int32_t SaveTransferArchiveSync(void *archive, char *errorBuffer, int32_t errorCapacity) {
+    auto *cold = static_cast<Archive *>(archive);
+    if (::fsync(cold->fd) != 0 || (cold->created && !syncDirectory(parentDirectory(cold->path)))) {
+        setError(errorBuffer, errorCapacity, systemError(cold->path));
+        return -1;
+    }
+    cold->created = false;
+    cold->syncedLength = cold->length;
+    return 0;
+}
+
+// Closes `archive`, cutting off records appended since the last sync.
+extern "C" void SaveTransferArchiveClose(void *archive) {
+    auto *cold = static_cast<Archive *>(archive);
+    if (cold == nullptr) {
+        return;
+    }
+    if (cold->length != cold->syncedLength) {
+        ::ftruncate(cold->fd, static_cast<off_t>(cold->syncedLength));
+    }
+    ::close(cold->fd);
+    delete cold;
+}
+
+// Reads the record at `*offset` of the export or archive file at `path`
+// into the store as a new game `id`, and moves `*offset` past it. The
+// world is streamed into a new checkpoint as chunks are decompressed and
+// verified, and the game is recorded only after the whole world is
+// stored, so a bad record adds nothing. Returns 1 if more records follow,
+// 0 after the last one, or -1 with a reason in `errorBuffer`.
+extern "C" int32_t SaveTransferImport(void *store,
+                                      const char *path,
+                                      int64_t *offset,
+                                      const uint8_t *id,
+                                      char *errorBuffer,
+                                      int32_t errorCapacity) {
+    const int fd = ::open(path, O_RDONLY);
+    struct stat info {};
+    if (fd < 0 || ::fstat(fd, &info) != 0 || ::lseek(fd, static_cast<off_t>(*offset), SEEK_SET) < 0) {
+        setError(errorBuffer, errorCapacity, systemError(path));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return -1;
+    }
+#if defined(POSIX_FADV_SEQUENTIAL)
+    ::posix_fadvise(fd, static_cast<off_t>(*offset), 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    TransferHeader header{};
+    std::string strings;
+    bool valid = readAll(fd, &header, sizeof(header)) && header.magic == kTransferMagic &&
+                 header.version == kTransferVersion && header.chunkBytes > 0 && header.chunkBytes <= kChunkBytes &&
+                 header.nameLength <= kMaximumStringBytes && header.playerNameLength <= kMaximumStringBytes &&
+                 header.companyNameLength <= kMaximumStringBytes;
+    if (valid) {
+        strings.resize(static_cast<size_t>(header.nameLength) + header.playerNameLength + header.companyNameLength);
+        valid = readAll(fd, strings.data(), strings.size()) && headerChecksum(header, strings) == header.checksum;
+    }
+    if (!valid) {
+        setError(errorBuffer, errorCapacity, "not an export file");
+        ::close(fd);
+        return -1;
+    }
+
+    // Archived games without a world carry an empty one.
+    void *writer = header.worldLength > 0 ? SaveStoreWorldWriterOpen(store, id) : nullptr;
+    if (writer == nullptr && header.worldLength > 0) {
+        setError(errorBuffer, errorCapacity, "cannot create world file");
+        ::close(fd);
+        return -1;
+    }
+
+    bool ended = false;
+    uint64_t received = 0;
+    const bool streamed = runPipeline(
+        [&](Chunk &chunk) {
+            if (!readAll(fd, &chunk.frame, sizeof(chunk.frame))) {
+                return -1;
+            }
+            if (chunk.frame.rawLength == 0) {
+                ended = true;
+                return 0;
+            }
+            if (writer == nullptr || chunk.frame.rawLength > header.chunkBytes ||
+                chunk.frame.storedLength > lz4Bound(header.chunkBytes)) {
+                return -1;
+            }
+            chunk.buffer.resize(chunk.frame.storedLength);
+            chunk.input = chunk.buffer.data();
+            chunk.inputLength = chunk.buffer.size();
+            return readAll(fd, chunk.buffer.data(), chunk.buffer.size()) ? 1 : -1;
+        },
+        decompressChunk,
+        [&](Chunk &chunk) {
+            received += chunk.output.size();
+            return SaveStoreWorldWriterAppend(writer, chunk.output.data(), static_cast<int64_t>(chunk.output.size())) ==
+                   0;
+        });
+    const off_t next = ::lseek(fd, 0, SEEK_CUR);
+    ::close(fd);
+
+    const bool complete = streamed && ended && received == header.worldLength;
+    int64_t worldLength = -1;
+    if (writer != nullptr) {
+        worldLength = SaveStoreWorldWriterFinish(writer, complete ? 1 : 0);
+    }
+    if ((writer != nullptr && worldLength < 0) || !complete) {
+        setError(errorBuffer, errorCapacity, complete ? "cannot write world file" : "damaged or truncated export file");
+        return -1;
+    }
+
+    // With no world file, a length of -1 records the game without one.
+    const char *name = strings.data();
+    const char *playerName = name + header.nameLength;
+    const char *companyName = playerName + header.playerNameLength;
+    const int64_t sequence = SaveStorePut(store, id, header.status, header.balance, header.createdAt,
+                                          header.updatedAt, header.lastSavedAt, name,
+                                          static_cast<int32_t>(header.nameLength), playerName,
+                                          static_cast<int32_t>(header.playerNameLength), companyName,
+                                          static_cast<int32_t>(header.companyNameLength), nullptr, worldLength);
+    if (sequence < 0 || SaveStoreCommit(store, sequence) != 0) {
+        setError(errorBuffer, errorCapacity, "cannot record game");
+        return -1;
+    }
+    *offset = static_cast<int64_t>(next);
+    return next < info.st_size ? 1 : 0;
+}
+
+typedef void (*SaveTransferImported)(void *context, const uint8_t *id);
+
+// Imports every record of the export or archive file at `path` as a new
+// game with a fresh random id, even one the store already holds. The file
+// is imported whole or not at all: a damaged record removes the games read
+// before it in one commit, so importing the file again after repairing it
+// adds each game once. Once all are in, reports each new id to `imported`
+// in file order and returns how many there were; otherwise returns -1
+// with a reason in `errorBuffer`.
+extern "C" int32_t SaveTransferImportAll(void *store,
+                                         const char *path,
+                                         SaveTransferImported imported,
+                                         void *context,
+                                         char *errorBuffer,
+                                         int32_t errorCapacity) {
+    std::random_device random;
+    std::vector<GameID> ids;
+    int64_t offset = 0;
+    int32_t result = 1;
+    while (result == 1) {
+        const GameID id = randomID(random);
+        result = SaveTransferImport(store, path, &offset, id.data(), errorBuffer, errorCapacity);
+        if (result >= 0) {
+            ids.push_back(id);
+        }
+    }
+    if (result < 0) {
+        int64_t sequence = -1;
+        for (const GameID &id : ids) {
+            sequence = SaveStoreRemove(store, id.data());
+        }
+        if (!ids.empty() && SaveStoreCommit(store, sequence) != 0) {
+            setError(errorBuffer, errorCapacity, "cannot remove partially imported games");
+        }
+        return -1;
+    }
+    for (const GameID &id : ids) {
+        imported(context, id.data());
+    }
+    return static_cast<int32_t>(ids.size());
+}
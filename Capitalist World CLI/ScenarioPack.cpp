@@ -0,0 +1,491 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Scenario packs.
+//
+// Scenarios are written as text (one directive per line) and compiled once
+// into a binary pack: a fixed header followed by fixed-size record arrays and
+// a string table. Opening a pack maps it read-only and validates the header;
+// records are read in place, so load time does not grow with pack size.
+//
+// Text format:
+//   # comment
+//   start_date 1900-01-01
+//   starting_cash 10000000
+//   region <id> "<name>"
+//   good <key> <base price>
+//   company "<name>" <region id> <cash> <revenue> <margin> <growth>
+//   recipe <output key> <quantity> <input key> <quantity> [<input key> <quantity> ...]
+
+namespace {
+constexpr char kPackMagic[4] = {'C', 'W', 'P', 'K'};
+constexpr uint32_t kPackVersion = 1;
+constexpr int kMaxRecipeInputs = 4;
+
+struct SectionRef {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    double startingCash;
+    int32_t startYear;
+    int32_t startMonth;
+    int32_t startDay;
+    uint32_t reserved;
+    SectionRef regions;
+    SectionRef goods;
+    SectionRef companies;
+    SectionRef recipes;
+    SectionRef strings;
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct RegionRecord {
+    StringRef key;
+    StringRef name;
+};
+
+struct GoodRecord {
+    StringRef key;
+    double basePrice;
+};
+
+struct CompanyRecord {
+    StringRef name;
+    int32_t region;
+    uint32_t reserved;
+    double cash;
+    double revenue;
+    double margin;
+    double growth;
+};
+
+struct RecipeRecord {
+    int32_t outputGood;
+    int32_t inputCount;
+    double outputQuantity;
+    int32_t inputGoods[kMaxRecipeInputs];
+    double inputQuantities[kMaxRecipeInputs];
+};
+
+static_assert(sizeof(PackHeader) == 112, "pack header layout changed");
+static_assert(sizeof(CompanyRecord) == 48, "company record layout changed");
+
+struct MappedPack {
+    void *base = nullptr;
+    size_t size = 0;
+    const PackHeader *header = nullptr;
+};
+
+struct CompileState {
+    PackHeader header{};
+    std::vector<RegionRecord> regions;
+    std::vector<GoodRecord> goods;
+    std::vector<CompanyRecord> companies;
+    std::vector<RecipeRecord> recipes;
+    std::string strings;
+    std::unordered_map<std::string, int32_t> regionIndex;
+    std::unordered_map<std::string, int32_t> goodIndex;
+
+    StringRef intern(const std::string &value) {
+        const StringRef ref{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size())};
+        strings += value;
+        return ref;
+    }
+};
+
+// Splits a line into whitespace-separated tokens; double quotes group words.
+std::vector<std::string> tokenize(const std::string &line) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool quoted = false;
+    bool hasToken = false;
+
+    for (const char character : line) {
+        if (character == '"') {
+            quoted = !quoted;
+            hasToken = true;
+        } else if (!quoted && (character == ' ' || character == '\t' || character == '\r')) {
+            if (hasToken) {
+                tokens.push_back(current);
+                current.clear();
+                hasToken = false;
+            }
+        } else if (!quoted && character == '#') {
+            break;
+        } else {
+            current += character;
+            hasToken = true;
+        }
+    }
+
+    if (hasToken) {
+        tokens.push_back(current);
+    }
+    return tokens;
+}
+
+bool parseNumber(const std::string &token, double &value) {
+    char *end = nullptr;
+    value = std::strtod(token.c_str(), &end);
+    return end != token.c_str() && *end == '\0';
+}
+
+bool lookupGood(const CompileState &state, const std::string &key, int32_t &index) {
+    const auto match = state.goodIndex.find(key);
+    if (match == state.goodIndex.end()) {
+        return false;
+    }
+    index = match->second;
+    return true;
+}
+
+// Returns an empty string on success, otherwise the error for this line.
+std::string compileLine(CompileState &state, const std::vector<std::string> &tokens) {
+    const std::string &directive = tokens[0];
+
+    if (directive == "start_date" && tokens.size() == 2) {
+        int year = 0;
+        int month = 0;
+        int day = 0;
+        if (std::sscanf(tokens[1].c_str(), "%d-%d-%d", &year, &month, &day) != 3) {
+            return "invalid date";
+        }
+        state.header.startYear = year;
+        state.header.startMonth = month;
+        state.header.startDay = day;
+        return "";
+    }
+
+    if (directive == "starting_cash" && tokens.size() == 2) {
+        return parseNumber(tokens[1], state.header.startingCash) ? "" : "invalid amount";
+    }
+
+    if (directive == "region" && tokens.size() == 3) {
+        state.regionIndex[tokens[1]] = static_cast<int32_t>(state.regions.size());
+        state.regions.push_back(RegionRecord{state.intern(tokens[1]), state.intern(tokens[2])});
+        return "";
+    }
+
+    if (directive == "good" && tokens.size() == 3) {
+        GoodRecord record{state.intern(tokens[1]), 0};
+        if (!parseNumber(tokens[2], record.basePrice)) {
+            return "invalid price";
+        }
+        state.goodIndex[tokens[1]] = static_cast<int32_t>(state.goods.size());
+        state.goods.push_back(record);
+        return "";
+    }
+
+    if (directive == "company" && tokens.size() == 7) {
+        CompanyRecord record{};
+        record.name = state.intern(tokens[1]);
+        const auto region = state.regionIndex.find(tokens[2]);
+        if (region == state.regionIndex.end()) {
+            return "unknown region '" + tokens[2] + "'";
+        }
+        record.region = region->second;
+        if (!parseNumber(tokens[3], record.cash) || !parseNumber(tokens[4], record.revenue) ||
+            !parseNumber(tokens[5], record.margin) || !parseNumber(tokens[6], record.growth)) {
+            return "invalid company figures";
+        }
+        state.companies.push_back(record);
+        return "";
+    }
+
+    if (directive == "recipe" && tokens.size() >= 5 && tokens.size() % 2 == 1) {
+        RecipeRecord record{};
+        if (!lookupGood(state, tokens[1], record.outputGood)) {
+            return "unknown good '" + tokens[1] + "'";
+        }
+        if (!parseNumber(tokens[2], record.outputQuantity)) {
+            return "invalid quantity";
+        }
+
+        for (size_t token = 3; token + 1 < tokens.size(); token += 2) {
+            if (record.inputCount == kMaxRecipeInputs) {
+                return "too many recipe inputs";
+            }
+            const int32_t input = record.inputCount;
+            if (!lookupGood(state, tokens[token], record.inputGoods[input])) {
+                return "unknown good '" + tokens[token] + "'";
+            }
+            if (!parseNumber(tokens[token + 1], record.inputQuantities[input])) {
+                return "invalid quantity";
+            }
+            ++record.inputCount;
+        }
+        state.recipes.push_back(record);
+        return "";
+    }
+
+    return "unrecognized directive '" + directive + "'";
+}
+
+template <typename Record>
+SectionRef appendSection(std::string &output, const std::vector<Record> &records) {
+    output.resize((output.size() + 7) & ~static_cast<size_t>(7), '\0');
+    const SectionRef ref{output.size(), records.size()};
+    output.append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(Record));
+    return ref;
+}
+
+void writeError(char *buffer, int32_t capacity, const std::string &message) {
+    if (buffer == nullptr || capacity <= 0) {
+        return;
+    }
+    std::snprintf(buffer, static_cast<size_t>(capacity), "%s", message.c_str());
+}
+
+MappedPack *asPack(void *handle) {
+    return static_cast<MappedPack *>(handle);
+}
+
+bool sectionFits(const MappedPack &pack, const SectionRef &section, size_t recordSize) {
+    return section.offset <= pack.size && section.count <= (pack.size - section.offset) / recordSize;
+}
+
+template <typename Record>
+const Record *record(void *handle, SectionRef PackHeader::*section, int32_t index) {
+    MappedPack *pack = asPack(handle);
+    if (pack == nullptr || index < 0 || static_cast<uint64_t>(index) >= (pack->header->*section).count) {
+        return nullptr;
+    }
+    const auto *base = static_cast<const char *>(pack->base) + (pack->header->*section).offset;
+    return reinterpret_cast<const Record *>(base) + index;
+}
+
+const char *stringAt(void *handle, StringRef ref, int32_t *length) {
+    MappedPack *pack = asPack(handle);
+    if (ref.offset + static_cast<uint64_t>(ref.length) > pack->header->strings.count) {
+        *length = 0;
+        return "";
+    }
+    *length = static_cast<int32_t>(ref.length);
+    return static_cast<const char *>(pack->base) + pack->header->strings.offset + ref.offset;
+}
+}  // namespace
+
+// Compiles a text scenario into a binary pack. Returns 0 on success; on
+// failure writes "line N: reason" into `errorBuffer` and returns -1.
+extern "C" int32_t ScenarioCompile(const char *sourcePath,
+                                   const char *packPath,
+                                   char *errorBuffer,
+                                   int32_t errorCapacity) {
+    std::ifstream source(sourcePath);
+    if (!source) {
+        writeError(errorBuffer, errorCapacity, std::string("cannot read ") + sourcePath);
+        return -1;
+    }
+
+    CompileState state;
+    std::memcpy(state.header.magic, kPackMagic, sizeof(kPackMagic));
+    state.header.version = kPackVersion;
+    state.header.startingCash = 10000000.0;
+    state.header.startYear = 1900;
+    state.header.startMonth = 1;
+    state.header.startDay = 1;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(source, line)) {
+        ++lineNumber;
+        const std::vector<std::string> tokens = tokenize(line);
+        if (tokens.empty()) {
+            continue;
+        }
+
+        const std::string error = compileLine(state, tokens);
+        if (!error.empty()) {
+            writeError(errorBuffer, errorCapacity, "line " + std::to_string(lineNumber) + ": " + error);
+            return -1;
+        }
+    }
+
+    std::string output(sizeof(PackHeader), '\0');
+    state.header.regions = appendSection(output, state.regions);
+    state.header.goods = appendSection(output, state.goods);
+    state.header.companies = appendSection(output, state.companies);
+    state.header.recipes = appendSection(output, state.recipes);
+    state.header.strings = SectionRef{output.size(), state.strings.size()};
+    output += state.strings;
+    std::memcpy(output.data(), &state.header, sizeof(PackHeader));
+
+    const std::string temporaryPath = std::string(packPath) + ".tmp";
+    {
+        std::ofstream pack(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!pack.write(output.data(), static_cast<std::streamsize>(output.size()))) {
+            writeError(errorBuffer, errorCapacity, std::string("cannot write ") + packPath);
+            return -1;
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), packPath) != 0) {
+        writeError(errorBuffer, errorCapacity, std::string("cannot write ") + packPath);
+        return -1;
+    }
+    return 0;
+}
+
+// Maps a compiled pack. Returns null if the file is missing or invalid.
+extern "C" void *ScenarioOpen(const char *packPath) {
+    const int descriptor = open(packPath, O_RDONLY);
+    if (descriptor < 0) {
+        return nullptr;
+    }
+
+    struct stat info {};
+    if (fstat(descriptor, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(PackHeader))) {
+        close(descriptor);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(info.st_size);
+    void *base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto *pack = new MappedPack{base, size, static_cast<const PackHeader *>(base)};
+    const PackHeader &header = *pack->header;
+    const bool valid = std::memcmp(header.magic, kPackMagic, sizeof(kPackMagic)) == 0 &&
+                       header.version == kPackVersion &&
+                       sectionFits(*pack, header.regions, sizeof(RegionRecord)) &&
+                       sectionFits(*pack, header.goods, sizeof(GoodRecord)) &&
+                       sectionFits(*pack, header.companies, sizeof(CompanyRecord)) &&
+                       sectionFits(*pack, header.recipes, sizeof(RecipeRecord)) &&
+                       sectionFits(*pack, header.strings, 1);
+    if (!valid) {
+        munmap(base, size);
+        delete pack;
+        return nullptr;
+    }
+    return pack;
+}
+
+extern "C" void ScenarioClose(void *handle) {
+    MappedPack *pack = asPack(handle);
+    if (pack == nullptr) {
+        return;
+    }
+    munmap(pack->base, pack->size);
+    delete pack;
+}
+
+extern "C" double ScenarioStartingCash(void *handle) {
+    return asPack(handle)->header->startingCash;
+}
+
+extern "C" void ScenarioStartDate(void *handle, int32_t *year, int32_t *month, int32_t *day) {
+    const PackHeader *header = asPack(handle)->header;
+    *year = header->startYear;
+    *month = header->startMonth;
+    *day = header->startDay;
+}
+
+extern "C" int32_t ScenarioRegionCount(void *handle) {
+    return static_cast<int32_t>(asPack(handle)->header->regions.count);
+}
+
+extern "C" const char *ScenarioRegionName(void *handle, int32_t index, int32_t *length) {
+    const auto *region = record<RegionRecord>(handle, &PackHeader::regions, index);
+    if (region == nullptr) {
+        *length = 0;
+        return "";
+    }
+    return stringAt(handle, region->name, length);
+}
+
+extern "C" int32_t ScenarioGoodCount(void *handle) {
+    return static_cast<int32_t>(asPack(handle)->header->goods.count);
+}
+
+extern "C" const char *ScenarioGoodKey(void *handle, int32_t index, int32_t *length) {
+    const auto *good = record<GoodRecord>(handle, &PackHeader::goods, index);
+    if (good == nullptr) {
+        *length = 0;
+        return "";
+    }
+    return stringAt(handle, good->key, length);
+}
+
+extern "C" double ScenarioGoodBasePrice(void *handle, int32_t index) {
+    const auto *good = record<GoodRecord>(handle, &PackHeader::goods, index);
+    return good != nullptr ? good->basePrice : 0;
+}
+
+extern "C" int32_t ScenarioCompanyCount(void *handle) {
+    return static_cast<int32_t>(asPack(handle)->header->companies.count);
+}
+
+extern "C" const char *ScenarioCompanyName(void *handle, int32_t index, int32_t *length) {
+    const auto *company = record<CompanyRecord>(handle, &PackHeader::companies, index);
+    if (company == nullptr) {
+        *length = 0;
+        return "";
+    }
+    return stringAt(handle, company->name, length);
+}
+
+extern "C" void ScenarioCompanyFigures(void *handle,
+                                       int32_t index,
+                                       int32_t *region,
+                                       double *cash,
+                                       double *revenue,
+                                       double *margin,
+                                       double *growth) {
+    const auto *company = record<CompanyRecord>(handle, &PackHeader::companies, index);
+    if (company == nullptr) {
+        return;
+    }
+    *region = company->region;
+    *cash = company->cash;
+    *revenue = company->revenue;
+    *margin = company->margin;
+    *growth = company->growth;
+}
+
+extern "C" int32_t ScenarioRecipeCount(void *handle) {
+    return static_cast<int32_t>(asPack(handle)->header->recipes.count);
+}
+
+// Copies one recipe's inputs into the caller's buffers (at most `capacity`)
+// and returns the number of inputs.
+extern "C" int32_t ScenarioRecipe(void *handle,
+                                  int32_t index,
+                                  int32_t *outputGood,
+                                  double *outputQuantity,
+                                  int32_t *inputGoods,
+                                  double *inputQuantities,
+                                  int32_t capacity) {
+    const auto *recipe = record<RecipeRecord>(handle, &PackHeader::recipes, index);
+    if (recipe == nullptr) {
+        return 0;
+    }
+    *outputGood = recipe->outputGood;
+    *outputQuantity = recipe->outputQuantity;
+    const int32_t count = std::min(recipe->inputCount, capacity);
+    for (int32_t input = 0; input < count; ++input) {
+        inputGoods[input] = recipe->inputGoods[input];
+        inputQuantities[input] = recipe->inputQuantities[input];
+    }
+    return count;
+}
@@ -0,0 +1,193 @@
+import Foundation
+
+@_silgen_name("ScenarioCompile")
+private func ScenarioCompile(
+    _ sourcePath: UnsafePointer<CChar>,
+    _ packPath: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> Int32
+@_silgen_name("ScenarioOpen")
+private func ScenarioOpen(_ packPath: UnsafePointer<CChar>) -> OpaquePointer?
+@_silgen_name("ScenarioClose")
+private func ScenarioClose(_ handle: OpaquePointer)
+@_silgen_name("ScenarioStartingCash")
+private func ScenarioStartingCash(_ handle: OpaquePointer) -> Double
+@_silgen_name("ScenarioStartDate")
+private func ScenarioStartDate(
+    _ handle: OpaquePointer,
+    _ year: UnsafeMutablePointer<Int32>,
+    _ month: UnsafeMutablePointer<Int32>,
+    _ day: UnsafeMutablePointer<Int32>
+)
+@_silgen_name("ScenarioRegionCount")
+private func ScenarioRegionCount(_ handle: OpaquePointer) -> Int32
+@_silgen_name("ScenarioRegionName")
+private func ScenarioRegionName(_ handle: OpaquePointer, _ index: Int32, _ length: UnsafeMutablePointer<Int32>) -> UnsafePointer<CChar>
+@_silgen_name("ScenarioGoodCount")
+private func ScenarioGoodCount(_ handle: OpaquePointer) -> Int32
+@_silgen_name("ScenarioGoodKey")
+private func ScenarioGoodKey(_ handle: OpaquePointer, _ index: Int32, _ length: UnsafeMutablePointer<Int32>) -> UnsafePointer<CChar>
+@_silgen_name("ScenarioGoodBasePrice")
+private func ScenarioGoodBasePrice(_ handle: OpaquePointer, _ index: Int32) -> Double
+@_silgen_name("ScenarioCompanyCount")
+private func ScenarioCompanyCount(_ handle: OpaquePointer) -> Int32
+@_silgen_name("ScenarioCompanyName")
+private func ScenarioCompanyName(_ handle: OpaquePointer, _ index: Int32, _ length: UnsafeMutablePointer<Int32>) -> UnsafePointer<CChar>
+@_silgen_name("ScenarioCompanyFigures")
+private func ScenarioCompanyFigures(
+    _ handle: OpaquePointer,
+    _ index: Int32,
+    _ region: UnsafeMutablePointer<Int32>,
+    _ cash: UnsafeMutablePointer<Double>,
+    _ revenue: UnsafeMutablePointer<Double>,
+    _ margin: UnsafeMutablePointer<Double>,
+    _ growth: UnsafeMutablePointer<Double>
+)
+
+enum ScenarioPackError: LocalizedError {
+    case compileFailed(String)
+
+    var errorDescription: String? {
+        switch self {
+        case .compileFailed(let reason):
+            return Localization.shared.scenarioCompileFailedMessage(reason)
+        }
+    }
+}
+
+/// Starting conditions for new games. Read from a compiled, memory-mapped
+/// scenario pack when one is installed, otherwise the built-in defaults.
+/// Company records are read from the mapping on demand, never parsed up front.
+final class ScenarioPack {
+    struct Company {
+        let name: String
+        let region: Int
+        let cash: Double
+        let revenue: Double
+        let margin: Double
+        let growth: Double
+    }
+
+    static let packEnvironmentKey = "CAPITALIST_SCENARIO"
+    static let shared = ScenarioPack.loadInstalled()
+
+    static let defaultStartingBalance = 10_000_000.0
+    static let defaultRegionNames = ["Northern Plains", "Eastern Seaboard", "Southern Valleys", "Western Frontier"]
+
+    /// Pack path, or `nil` when running on built-in defaults.
+    let packURL: URL?
+    let startingBalance: Double
+    let referenceDate: Date
+    let regionNames: [String]
+    /// Base price per `Good`, indexed by raw value.
+    let goodBasePrices: [Double]
+
+    private let handle: OpaquePointer?
+
+    var companyCount: Int {
+        handle.map { Int(ScenarioCompanyCount($0)) } ?? 0
+    }
+
+    private init(packURL: URL?, handle: OpaquePointer?) {
+        self.packURL = packURL
+        self.handle = handle
+
+        guard let handle else {
+            startingBalance = Self.defaultStartingBalance
+            referenceDate = Localization.shared.promptReferenceDate()
+            regionNames = Self.defaultRegionNames
+            goodBasePrices = Good.allCases.map(\.basePrice)
+            return
+        }
+
+        startingBalance = ScenarioStartingCash(handle)
+
+        var year: Int32 = 0
+        var month: Int32 = 0
+        var day: Int32 = 0
+        ScenarioStartDate(handle, &year, &month, &day)
+        let calendar = Calendar(identifier: .gregorian)
+        let components = DateComponents(year: Int(year), month: Int(month), day: Int(day))
+        referenceDate = calendar.date(from: components) ?? Localization.shared.promptReferenceDate()
+
+        let regions = (0..<ScenarioRegionCount(handle)).map { index in
+            Self.string { ScenarioRegionName(handle, index, $0) }
+        }
+        regionNames = regions.isEmpty ? Self.defaultRegionNames : regions
+
+        var prices = Good.allCases.map(\.basePrice)
+        for index in 0..<ScenarioGoodCount(handle) {
+            let key = "good." + Self.string { ScenarioGoodKey(handle, index, $0) }
+            if let good = Good.allCases.first(where: { $0.key == key }) {
+                prices[good.rawValue] = ScenarioGoodBasePrice(handle, index)
+            }
+        }
+        goodBasePrices = prices
+    }
+
+    deinit {
+        if let handle {
+            ScenarioClose(handle)
+        }
+    }
+
+    func company(at index: Int) -> Company {
+        guard let handle else {
+            preconditionFailure("Built-in scenario has no companies")
+        }
+
+        var region: Int32 = 0
+        var cash = 0.0
+        var revenue = 0.0
+        var margin = 0.0
+        var growth = 0.0
+        ScenarioCompanyFigures(handle, Int32(index), &region, &cash, &revenue, &margin, &growth)
+        return Company(
+            name: Self.string { ScenarioCompanyName(handle, Int32(index), $0) },
+            region: Int(region),
+            cash: cash,
+            revenue: revenue,
+            margin: margin,
+            growth: growth
+        )
+    }
+
+    /// Default install location: next to the save store, overridable with
+    /// `CAPITALIST_SCENARIO`.
+    static func installedPackURL() -> URL {
+        if let override = ProcessInfo.processInfo.environment[packEnvironmentKey], override.isEmpty == false {
+            return URL(fileURLWithPath: override)
+        }
+        return SaveStore.storageDirectory().appendingPathComponent("scenario.cwpack")
+    }
+
+    static func compile(source: URL, to pack: URL) throws {
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        let status = source.path.withCString { sourcePath in
+            pack.path.withCString { packPath in
+                ScenarioCompile(sourcePath, packPath, &errorBuffer, Int32(errorBuffer.count))
+            }
+        }
+
+        if status != 0 {
+            throw ScenarioPackError.compileFailed(String(cString: errorBuffer))
+        }
+    }
+
+    private static func loadInstalled() -> ScenarioPack {
+        let url = installedPackURL()
+        guard let handle = url.path.withCString({ ScenarioOpen($0) }) else {
+            return ScenarioPack(packURL: nil, handle: nil)
+        }
+        return ScenarioPack(packURL: url, handle: handle)
+    }
+
+    /// Builds a `String` from a length-delimited string in the mapped pack.
+    private static func string(_ accessor: (UnsafeMutablePointer<Int32>) -> UnsafePointer<CChar>) -> String {
+        var length: Int32 = 0
+        let pointer = accessor(&length)
+        let bytes = UnsafeRawBufferPointer(start: pointer, count: Int(length))
+        return String(decoding: bytes, as: UTF8.self)
+    }
+}
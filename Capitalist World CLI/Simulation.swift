@@ -0,0 +1,303 @@
+import Foundation
+
+/// Owns the world of the active game and runs it one simulated day at a time
+/// on a private serial queue. Commands reach the world through `perform`.
+final class Simulation {
+    struct Snapshot {
+        var balance: Double
+        var profits: Double
+        var day: Int
+        var isSandbox: Bool
+        var achievementsUnlocked: Int
+        var latestAchievement: String?
+    }
+
+    struct AcquisitionQuote {
+        let companyIndex: Int
+        /// Stable across liquidations, unlike `companyIndex`.
+        let companyID: CompanyID
+        let name: String
+        let price: Double
+        let lowPrice: Double
+        let highPrice: Double
+    }
+
+    static let controlPremium = 0.2
+    static let minimumAcquisitionPrice = 100_000.0
+    private static let daysPerWeek = 7
+    private static let secondsPerDay: TimeInterval = 86_400
+    /// AI firms only bid on targets they can pay for with this share of cash.
+    private static let aiBudgetShare = 0.5
+
+    let valuationEngine = ValuationEngine()
+    /// Touched only on the simulation queue.
+    private let profiler = SystemProfiler()
+
+    private let queue = DispatchQueue(label: "com.capitalistworld.simulation")
+    private let snapshotLock = NSLock()
+    private let referenceDate: Date
+
+    /// Current world; reading it first finishes a deferred load.
+    private var world: World? {
+        get {
+            if let pendingLoad {
+                self.pendingLoad = nil
+                do {
+                    loadedWorld = try pendingLoad()
+                } catch {
+                    loadFailure = error
+                }
+            }
+            return loadedWorld
+        }
+        set {
+            pendingLoad = nil
+            loadFailure = nil
+            loadedWorld = newValue
+        }
+    }
+    private var loadedWorld: World?
+    /// Builds the world passed to `load(deferred:)` once something needs it.
+    private var pendingLoad: (() throws -> World?)?
+    /// Why the deferred load left no world, until someone reports it.
+    private var loadFailure: Error?
+    /// Live world parked while the player experiments on a fork of it.
+    private var sandboxBase: World?
+    private var lastClockDay: Int?
+    private var snapshot: Snapshot?
+    private var autosaveIntervalDays = 0
+    private var autosaveHandler: ((World) -> Void)?
+    private var monthEndHandler: ((World) -> Void)?
+
+    init(referenceDate: Date) {
+        self.referenceDate = referenceDate
+    }
+
+    func load(_ world: World?) {
+        queue.sync {
+            self.world = world
+            sandboxBase = nil
+            valuationEngine.invalidate()
+            publishSnapshotLocked()
+        }
+    }
+
+    /// Loads `world` and returns the live world it replaces, leaving any
+    /// sandbox fork behind. Returns `nil` for a deferred load that never
+    /// ran, whose world is still only in the store.
+    func exchange(_ world: World?) -> World? {
+        queue.sync {
+            let previous = sandboxBase ?? loadedWorld
+            self.world = world
+            sandboxBase = nil
+            valuationEngine.invalidate()
+            publishSnapshotLocked()
+            return previous
+        }
+    }
+
+    /// Loads the world `makeWorld` returns, calling it on the simulation
+    /// queue only when a command or a simulated day first needs the world.
+    /// Until then no snapshot is published. If it throws, no world is
+    /// loaded and the error waits in `takeLoadFailure()`.
+    func load(deferred makeWorld: @escaping () throws -> World?) {
+        queue.sync {
+            world = nil
+            pendingLoad = makeWorld
+            sandboxBase = nil
+            valuationEngine.invalidate()
+            publishSnapshotLocked()
+        }
+    }
+
+    /// Error of a deferred load that failed, returned once.
+    func takeLoadFailure() -> Error? {
+        queue.sync {
+            defer { loadFailure = nil }
+            return loadFailure
+        }
+    }
+
+    /// Runs `body` against the current world on the simulation queue.
+    /// Returns `nil` when no world is loaded.
+    func perform<T>(_ body: (World) throws -> T) rethrows -> T? {
+        try queue.sync {
+            guard let world else { return nil }
+            defer { publishSnapshotLocked() }
+            return try body(world)
+        }
+    }
+
+    var isSandboxActive: Bool {
+        queue.sync { sandboxBase != nil }
+    }
+
+    /// Swaps in an O(1) copy-on-write fork of the live world. Commands and
+    /// simulated days apply to the fork while the original stays frozen.
+    func beginSandbox() -> Bool {
+        queue.sync {
+            guard let world, sandboxBase == nil else { return false }
+            sandboxBase = world
+            self.world = world.fork()
+            valuationEngine.invalidate()
+            publishSnapshotLocked()
+            return true
+        }
+    }
+
+    /// Leaves the sandbox, either adopting the fork as the live world or
+    /// restoring the frozen original.
+    func endSandbox(keepChanges: Bool) -> Bool {
+        queue.sync {
+            guard let base = sandboxBase else { return false }
+            if keepChanges == false {
+                world = base
+            }
+            sandboxBase = nil
+            valuationEngine.invalidate()
+            publishSnapshotLocked()
+            return true
+        }
+    }
+
+    func currentSnapshot() -> Snapshot? {
+        snapshotLock.lock()
+        defer { snapshotLock.unlock() }
+        return snapshot
+    }
+
+    /// Steps the world once for every simulated day elapsed on the clock
+    /// since the previous call.
+    func advance(to date: Date) {
+        queue.async { [weak self] in
+            guard let self else { return }
+            let clockDay = Int(date.timeIntervalSince(self.referenceDate) / Self.secondsPerDay)
+            let previous = self.lastClockDay ?? clockDay
+            self.lastClockDay = clockDay
+
+            guard clockDay > previous, let world = self.world else { return }
+            for _ in previous..<clockDay {
+                self.stepDayLocked(world)
+                if let handler = self.autosaveHandler, self.sandboxBase == nil,
+                   world.day % self.autosaveIntervalDays == 0 {
+                    handler(world.fork())
+                }
+                if let handler = self.monthEndHandler, self.sandboxBase == nil, world.isMonthEnd {
+                    handler(world.fork())
+                }
+            }
+            self.publishSnapshotLocked()
+        }
+    }
+
+    /// Timing statistics per system plus the per-system budget at `speed`.
+    func profileReport(
+        at speed: SimulationClock.Speed
+    ) -> (statistics: [SystemProfiler.Statistics], budgetNanoseconds: Double?, budgetShare: Double) {
+        queue.sync { (profiler.statistics(), profiler.budgetNanoseconds(at: speed), profiler.budgetShare) }
+    }
+
+    func resetProfile() {
+        queue.sync { profiler.reset() }
+    }
+
+    func setProfileBudgetShare(_ share: Double) {
+        queue.sync { profiler.budgetShare = share }
+    }
+
+    /// Hands `handler` a fork of the live world every `days` simulated days,
+    /// on the simulation queue between days. Pass 0 to stop. Sandboxed days
+    /// never trigger it.
+    func setAutosave(every days: Int, handler: @escaping (World) -> Void) {
+        queue.sync {
+            autosaveIntervalDays = days
+            autosaveHandler = days > 0 ? handler : nil
+        }
+    }
+
+    /// Hands `handler` a fork of the live world at the end of every
+    /// simulated month, on the simulation queue. Sandboxed months never
+    /// trigger it.
+    func setMonthEndHandler(_ handler: ((World) -> Void)?) {
+        queue.sync { monthEndHandler = handler }
+    }
+
+    /// O(1) copy-on-write fork of the current world, for saving it while
+    /// the simulation keeps running.
+    func forkWorld() -> World? {
+        queue.sync { world?.fork() }
+    }
+
+    func acquisitionQuote(for index: Int, in world: World) -> AcquisitionQuote {
+        let valuation = valuationEngine.valuation(of: index, in: world)
+        let cash = world.companyCash[index]
+        let price = { (enterpriseValue: Double) -> Double in
+            max((enterpriseValue + cash) * (1 + Self.controlPremium), Self.minimumAcquisitionPrice)
+        }
+
+        return AcquisitionQuote(
+            companyIndex: index,
+            companyID: world.companyID(of: index),
+            name: world.companyNames[index],
+            price: price(valuation.enterpriseValue),
+            lowPrice: price(valuation.valueAtHigherRate),
+            highPrice: price(valuation.valueAtLowerRate)
+        )
+    }
+
+    /// Companies that can still be bought: independent firms other than the
+    /// player's own company.
+    func acquisitionTargets(in world: World) -> [Int] {
+        (0..<world.companyCount).filter { index in
+            index != World.playerCompanyIndex && world.companyOwner[index] == World.independentOwner
+        }
+    }
+
+    private func stepDayLocked(_ world: World) {
+        profiler.measure(.day) {
+            world.advanceDay(profiler: profiler)
+
+            if world.day % Self.daysPerWeek == 0 {
+                profiler.measure(.acquisitions) {
+                    screenAcquisitionsLocked(world)
+                }
+            }
+        }
+    }
+
+    /// Weekly AI screen. Valuations come from the cache unless financials
+    /// changed, so this is a scan over already-computed prices.
+    private func screenAcquisitionsLocked(_ world: World) {
+        let targets = acquisitionTargets(in: world)
+        guard targets.count > 1 else { return }
+
+        let quotes = targets.map { acquisitionQuote(for: $0, in: world) }
+        for acquirer in targets {
+            let budget = world.companyCash[acquirer] * Self.aiBudgetShare
+            let candidate = quotes
+                .filter { $0.companyIndex != acquirer && $0.price <= budget }
+                .min { $0.price < $1.price }
+
+            if let candidate {
+                world.transferOwnership(of: candidate.companyIndex, to: acquirer, price: candidate.price)
+                return
+            }
+        }
+    }
+
+    private func publishSnapshotLocked() {
+        let newSnapshot = loadedWorld.map { world in
+            Snapshot(
+                balance: world.playerCash,
+                profits: world.ledger.profit,
+                day: world.day,
+                isSandbox: sandboxBase != nil,
+                achievementsUnlocked: world.achievements.unlocked.count,
+                latestAchievement: world.achievements.latest
+            )
+        }
+        snapshotLock.lock()
+        snapshot = newSnapshot
+        snapshotLock.unlock()
+    }
+}
@@ -0,0 +1,881 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Called with each file read by `SaveIOReadFiles`; see SaveIO.cpp.
+typedef int32_t (*SaveIOConsume)(void *context, int32_t index, const uint8_t *data, int64_t length);
+extern "C" int32_t SaveIOReadFiles(const int32_t *fds,
+                                   const int64_t *capacities,
+                                   int32_t count,
+                                   SaveIOConsume consume,
+                                   void *context);
+
+namespace {
+constexpr uint32_t kManifestMagic = 0x4E535743;   // "CWSN"
+constexpr uint32_t kChunkListMagic = 0x4C535743;  // "CWSL"
+constexpr uint32_t kManifestVersion = 1;
+// Snapshots kept per game; capturing one more drops the oldest.
+constexpr uint32_t kMaxSnapshots = 64;
+
+// Content-defined chunking: a cut falls where a rolling hash over the
+// last 64 bytes matches a mask, so an edit only moves the boundaries next
+// to it and the rest of the world keeps chunking into the same pieces.
+// The mask is stricter before the average size and looser after it,
+// which narrows the spread of chunk sizes. A scattered edit costs about
+// one chunk, so chunks are kept small.
+constexpr size_t kMinimumChunkBytes = 4u << 10;
+constexpr size_t kAverageChunkBytes = 16u << 10;
+constexpr size_t kMaximumChunkBytes = 64u << 10;
+constexpr uint64_t kStrictMask = ~0ull << (64 - 16);
+constexpr uint64_t kLooseMask = ~0ull << (64 - 12);
+// World archive header and section table entry, as `WorldArchive` lays
+// them out; only section offsets are read.
+constexpr uint32_t kArchiveMagic = 0x41575743;  // "CWWA"
+constexpr uint32_t kArchiveVersion = 2;
+// Chunk files open at once while restoring; well under the smallest
+// default descriptor limits.
+constexpr size_t kRestoreWindow = 64;
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+using GameID = std::array<uint8_t, 16>;
+
+struct ArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    uint64_t tableOffset;
+    uint64_t length;
+};
+
+struct ArchiveSection {
+    uint32_t kind;
+    uint32_t version;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t count;
+};
+
+// Manifest of one game: this header, then up to `kMaxSnapshots` records,
+// oldest first. Small and fixed in size, so listing a game's snapshots
+// is one read whatever the size of its worlds.
+struct ManifestHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t nextSequence;
+    // XXH64 of the records.
+    uint64_t checksum;
+};
+
+struct SnapshotRecord {
+    uint64_t sequence;
+    int64_t length;
+    // Bytes of chunks this snapshot was the first to store.
+    int64_t addedBytes;
+    double createdAt;
+    int32_t day;
+    uint32_t chunkCount;
+};
+
+// Chunk list of one snapshot: this header, then `count` references in
+// world order.
+struct ChunkListHeader {
+    uint32_t magic;
+    uint32_t count;
+    // XXH64 of the references.
+    uint64_t checksum;
+};
+
+struct ChunkRef {
+    uint64_t hash;
+    uint32_t length;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ManifestHeader) == 32, "ManifestHeader layout changed");
+static_assert(sizeof(SnapshotRecord) == 40, "SnapshotRecord layout changed");
+static_assert(sizeof(ChunkListHeader) == 16, "ChunkListHeader layout changed");
+static_assert(sizeof(ChunkRef) == 16, "ChunkRef layout changed");
+
+uint64_t rotateLeft(uint64_t value, int bits) {
+    return value << bits | value >> (64 - bits);
+}
+
+uint64_t load64(const uint8_t *data) {
+    uint64_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t load32(const uint8_t *data) {
+    uint32_t value = 0;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint64_t xxh64Round(uint64_t accumulator, uint64_t input) {
+    accumulator += input * kPrime2;
+    return rotateLeft(accumulator, 31) * kPrime1;
+}
+
+uint64_t xxh64Merge(uint64_t hash, uint64_t accumulator) {
+    hash ^= xxh64Round(0, accumulator);
+    return hash * kPrime1 + kPrime4;
+}
+
+// XXH64 with seed 0: four independent lanes over 32-byte stripes, several
+// bytes per cycle, and the reference algorithm so keys stay comparable with
+// other tools.
+uint64_t xxh64(const uint8_t *data, size_t length) {
+    const uint8_t *const end = data + length;
+    uint64_t hash = 0;
+    if (length >= 32) {
+        uint64_t lanes[4] = {kPrime1 + kPrime2, kPrime2, 0, 0 - kPrime1};
+        for (; end - data >= 32; data += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                lanes[lane] = xxh64Round(lanes[lane], load64(data + lane * 8));
+            }
+        }
+        hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12) + rotateLeft(lanes[3], 18);
+        for (uint64_t lane : lanes) {
+            hash = xxh64Merge(hash, lane);
+        }
+    } else {
+        hash = kPrime5;
+    }
+    hash += length;
+
+    for (; end - data >= 8; data += 8) {
+        hash ^= xxh64Round(0, load64(data));
+        hash = rotateLeft(hash, 27) * kPrime1 + kPrime4;
+    }
+    if (end - data >= 4) {
+        hash ^= static_cast<uint64_t>(load32(data)) * kPrime1;
+        hash = rotateLeft(hash, 23) * kPrime2 + kPrime3;
+        data += 4;
+    }
+    for (; data < end; ++data) {
+        hash ^= *data * kPrime5;
+        hash = rotateLeft(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Offsets where the sections of a world archive start, ascending, then
+// `length`. Chunks are cut there too, so a section that changes whole, as
+// the company cash, revenue and cost columns do every day, never drags the
+// start of the next section into new chunks. Bytes that do not parse as an
+// archive are chunked as one run.
+std::vector<size_t> sectionCuts(const uint8_t *world, size_t length) {
+    std::vector<size_t> cuts;
+    ArchiveHeader header{};
+    if (length >= sizeof(header)) {
+        std::memcpy(&header, world, sizeof(header));
+    }
+    if (header.magic == kArchiveMagic && header.version == kArchiveVersion && header.tableOffset <= length &&
+        header.sectionCount <= (length - header.tableOffset) / sizeof(ArchiveSection)) {
+        for (uint32_t index = 0; index < header.sectionCount; ++index) {
+            ArchiveSection section{};
+            std::memcpy(&section, world + header.tableOffset + index * sizeof(section), sizeof(section));
+            if (section.offset > 0 && section.offset < length) {
+                cuts.push_back(static_cast<size_t>(section.offset));
+            }
+        }
+        std::sort(cuts.begin(), cuts.end());
+        cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+    }
+    cuts.push_back(length);
+    return cuts;
+}
+
+// Length of the chunk starting at `data`, at most `length`.
+size_t chunkLength(const uint8_t *data, size_t length) {
+    static const std::array<uint64_t, 256> gear = [] {
+        std::array<uint64_t, 256> values{};
+        uint64_t state = 0x43575348;  // "CWSH"; any fixed seed keeps cuts stable
+        for (uint64_t &value : values) {
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t mixed = state;
+            mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+            value = mixed ^ (mixed >> 31);
+        }
+        return values;
+    }();
+
+    if (length <= kMinimumChunkBytes) {
+        return length;
+    }
+    const size_t limit = std::min(length, kMaximumChunkBytes);
+    const size_t normal = std::min(limit, kAverageChunkBytes);
+    uint64_t hash = 0;
+    size_t index = kMinimumChunkBytes;
+    for (; index < normal; ++index) {
+        hash = (hash << 1) + gear[data[index]];
+        if ((hash & kStrictMask) == 0) {
+            return index + 1;
+        }
+    }
+    for (; index < limit; ++index) {
+        hash = (hash << 1) + gear[data[index]];
+        if ((hash & kLooseMask) == 0) {
+            return index + 1;
+        }
+    }
+    return limit;
+}
+
+bool writeAll(int fd, const void *data, size_t length) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    while (length > 0) {
+        const ssize_t written = ::write(fd, bytes, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool syncFile(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+bool syncDirectory(const std::string &directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+// Reads the whole file at `path`; false if it cannot be read completely.
+bool readFile(const std::string &path, std::vector<uint8_t> &contents) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    bool complete = ::fstat(fd, &info) == 0;
+    contents.resize(complete ? static_cast<size_t>(info.st_size) : 0);
+    size_t offset = 0;
+    while (complete && offset < contents.size()) {
+        const ssize_t count = ::read(fd, contents.data() + offset, contents.size() - offset);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        complete = count > 0;
+        offset += complete ? static_cast<size_t>(count) : 0;
+    }
+    ::close(fd);
+    return complete;
+}
+
+// Writes `path` whole or not at all: a synced temporary file renamed over
+// it.
+bool replaceFile(const std::string &directory, const std::string &path, const void *data, size_t length) {
+    const std::string temporaryPath = path + ".tmp";
+    const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    const bool written = writeAll(fd, data, length) && syncFile(fd);
+    ::close(fd);
+    if (!written || ::rename(temporaryPath.c_str(), path.c_str()) != 0 || !syncDirectory(directory)) {
+        ::unlink(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool makeDirectory(const std::string &path) {
+    return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+// Names of the entries of `directory`, without "." and "..".
+std::vector<std::string> listDirectory(const std::string &directory) {
+    std::vector<std::string> names;
+    DIR *stream = ::opendir(directory.c_str());
+    if (stream == nullptr) {
+        return names;
+    }
+    while (const dirent *entry = ::readdir(stream)) {
+        const std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+            names.push_back(name);
+        }
+    }
+    ::closedir(stream);
+    return names;
+}
+
+bool hasSuffix(const std::string &value, const std::string &suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string hex(const uint8_t *bytes, size_t count) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (size_t index = 0; index < count; ++index) {
+        text.push_back(digits[bytes[index] >> 4]);
+        text.push_back(digits[bytes[index] & 0x0F]);
+    }
+    return text;
+}
+
+std::string hex(uint64_t value) {
+    uint8_t bytes[8];
+    for (int index = 0; index < 8; ++index) {
+        bytes[index] = static_cast<uint8_t>(value >> (56 - index * 8));
+    }
+    return hex(bytes, sizeof(bytes));
+}
+
+void setError(char *buffer, int32_t capacity, const std::string &message) {
+    if (buffer == nullptr || capacity <= 0) {
+        return;
+    }
+    std::snprintf(buffer, static_cast<size_t>(capacity), "%s", message.c_str());
+}
+
+struct Manifest {
+    uint64_t nextSequence = 1;
+    std::vector<SnapshotRecord> records;
+};
+
+// Parses a manifest; a missing file is an empty manifest.
+bool readManifest(const std::string &path, Manifest &manifest) {
+    manifest = Manifest{};
+    std::vector<uint8_t> contents;
+    if (!readFile(path, contents)) {
+        return errno == ENOENT;
+    }
+    ManifestHeader header{};
+    if (contents.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+    const size_t recordBytes = static_cast<size_t>(header.count) * sizeof(SnapshotRecord);
+    if (header.magic != kManifestMagic || header.version != kManifestVersion || header.count > kMaxSnapshots ||
+        contents.size() != sizeof(header) + recordBytes ||
+        xxh64(contents.data() + sizeof(header), recordBytes) != header.checksum) {
+        return false;
+    }
+    manifest.nextSequence = header.nextSequence;
+    manifest.records.resize(header.count);
+    std::memcpy(manifest.records.data(), contents.data() + sizeof(header), recordBytes);
+    return true;
+}
+
+bool readChunkList(const std::string &path, std::vector<ChunkRef> &chunks) {
+    std::vector<uint8_t> contents;
+    ChunkListHeader header{};
+    if (!readFile(path, contents) || contents.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, contents.data(), sizeof(header));
+    const size_t refBytes = static_cast<size_t>(header.count) * sizeof(ChunkRef);
+    if (header.magic != kChunkListMagic || contents.size() != sizeof(header) + refBytes ||
+        xxh64(contents.data() + sizeof(header), refBytes) != header.checksum) {
+        return false;
+    }
+    chunks.resize(header.count);
+    std::memcpy(chunks.data(), contents.data() + sizeof(header), refBytes);
+    return true;
+}
+
+// Snapshot history of every game, deduplicated by content. Worlds are cut
+// into content-defined chunks, each stored once under its XXH64 in
+// `chunks/`, so a snapshot that differs from the previous one in a few
+// places stores only the chunks around those places. Per game, a manifest
+// lists the snapshots and a chunk list per snapshot names its chunks.
+//
+// Reference counts live in memory and are rebuilt from the chunk lists at
+// open by the collector thread, so a crash can never leave them wrong on
+// disk. Chunks whose count drops to zero are queued for the collector,
+// which deletes them unless a new snapshot referenced them meanwhile, and
+// sweeps files no snapshot references left behind by a crash.
+struct Store {
+    std::string directory;
+    std::string chunksDirectory;
+
+    // Serializes captures, and restores against the drops captures cause.
+    std::mutex captureMutex;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    // Chunks present on disk, by hash. A count of zero means the chunk is
+    // queued for deletion but still on disk.
+    std::unordered_map<uint64_t, uint32_t> references;
+    std::deque<uint64_t> garbage;
+    bool ready = false;
+    bool closing = false;
+    std::thread collector;
+
+    std::string manifestPath(const GameID &id) const {
+        return directory + "/" + hex(id.data(), id.size()) + ".manifest";
+    }
+
+    std::string listDirectoryPath(const GameID &id) const {
+        return directory + "/" + hex(id.data(), id.size());
+    }
+
+    std::string chunkListPath(const GameID &id, uint64_t sequence) const {
+        return listDirectoryPath(id) + "/" + hex(sequence) + ".chunks";
+    }
+
+    std::string chunkDirectory(uint64_t hash) const {
+        return chunksDirectory + "/" + hex(hash).substr(0, 2);
+    }
+
+    std::string chunkPath(uint64_t hash) const {
+        return chunkDirectory(hash) + "/" + hex(hash);
+    }
+
+    // Drops one reference to each chunk; chunks left unreferenced go to
+    // the collector.
+    void release(const std::vector<ChunkRef> &chunks) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const ChunkRef &chunk : chunks) {
+            const auto found = references.find(chunk.hash);
+            if (found != references.end() && found->second > 0 && --found->second == 0) {
+                garbage.push_back(chunk.hash);
+            }
+        }
+        changed.notify_all();
+    }
+
+    // Collector thread: rebuilds the reference counts, sweeps what no
+    // snapshot references, then deletes released chunks as they come.
+    void collect() {
+        rebuild();
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return closing || !garbage.empty(); });
+            if (closing) {
+                return;
+            }
+            const uint64_t hash = garbage.front();
+            garbage.pop_front();
+            // Deleting under the lock keeps a capture from counting on a
+            // chunk that is about to disappear.
+            const auto found = references.find(hash);
+            if (found != references.end() && found->second == 0) {
+                ::unlink(chunkPath(hash).c_str());
+                references.erase(found);
+            }
+        }
+    }
+
+    void rebuild() {
+        std::unordered_map<uint64_t, uint32_t> counts;
+        {
+            // Chunk lists are only written and dropped under the capture
+            // lock.
+            std::lock_guard<std::mutex> captures(captureMutex);
+            const std::vector<std::string> names = listDirectory(directory);
+            std::set<std::string> games;
+            for (const std::string &name : names) {
+                if (hasSuffix(name, ".manifest")) {
+                    games.insert(name.substr(0, name.size() - std::strlen(".manifest")));
+                } else if (hasSuffix(name, ".tmp")) {
+                    ::unlink((directory + "/" + name).c_str());
+                }
+            }
+
+            for (const std::string &name : names) {
+                if (name == "chunks" || hasSuffix(name, ".manifest") || hasSuffix(name, ".tmp")) {
+                    continue;
+                }
+                // A snapshot is listed only once its manifest names it: any
+                // other chunk list belongs to a capture that crashed before
+                // its manifest was written, or a drop that crashed after.
+                const std::string lists = directory + "/" + name;
+                Manifest manifest;
+                std::set<std::string> listed;
+                if (games.count(name) > 0 && readManifest(lists + ".manifest", manifest)) {
+                    for (const SnapshotRecord &record : manifest.records) {
+                        std::vector<ChunkRef> chunks;
+                        if (readChunkList(lists + "/" + hex(record.sequence) + ".chunks", chunks)) {
+                            listed.insert(hex(record.sequence) + ".chunks");
+                            for (const ChunkRef &chunk : chunks) {
+                                ++counts[chunk.hash];
+                            }
+                        }
+                    }
+                }
+                for (const std::string &file : listDirectory(lists)) {
+                    if (listed.count(file) == 0) {
+                        ::unlink((lists + "/" + file).c_str());
+                    }
+                }
+                if (listed.empty()) {
+                    ::rmdir(lists.c_str());
+                }
+            }
+
+            for (const std::string &prefix : listDirectory(chunksDirectory)) {
+                const std::string chunks = chunksDirectory + "/" + prefix;
+                for (const std::string &file : listDirectory(chunks)) {
+                    const uint64_t hash = std::strtoull(file.c_str(), nullptr, 16);
+                    if (file.size() != 16 || counts.count(hash) == 0) {
+                        ::unlink((chunks + "/" + file).c_str());
+                    }
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        references = std::move(counts);
+        ready = true;
+        changed.notify_all();
+    }
+
+    void waitUntilReady() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return ready; });
+    }
+
+    // Stores a chunk file under a temporary name and renames it into
+    // place; the directory is synced by the caller.
+    bool writeChunk(uint64_t hash, const uint8_t *data, size_t length) {
+        const std::string path = chunkPath(hash);
+        const std::string temporaryPath = path + ".tmp";
+        if (!makeDirectory(chunkDirectory(hash))) {
+            return false;
+        }
+        const int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        const bool written = writeAll(fd, data, length) && syncFile(fd);
+        ::close(fd);
+        if (!written || ::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            ::unlink(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool writeManifest(const GameID &id, const Manifest &manifest) {
+        std::vector<uint8_t> contents(sizeof(ManifestHeader) + manifest.records.size() * sizeof(SnapshotRecord));
+        ManifestHeader header{kManifestMagic, kManifestVersion, static_cast<uint32_t>(manifest.records.size()), 0,
+                              manifest.nextSequence, 0};
+        std::memcpy(contents.data() + sizeof(header), manifest.records.data(),
+                    manifest.records.size() * sizeof(SnapshotRecord));
+        header.checksum = xxh64(contents.data() + sizeof(header), contents.size() - sizeof(header));
+        std::memcpy(contents.data(), &header, sizeof(header));
+        return replaceFile(directory, manifestPath(id), contents.data(), contents.size());
+    }
+
+    bool writeChunkList(const GameID &id, uint64_t sequence, const std::vector<ChunkRef> &chunks) {
+        const std::string lists = listDirectoryPath(id);
+        if (!makeDirectory(lists)) {
+            return false;
+        }
+        std::vector<uint8_t> contents(sizeof(ChunkListHeader) + chunks.size() * sizeof(ChunkRef));
+        std::memcpy(contents.data() + sizeof(ChunkListHeader), chunks.data(), chunks.size() * sizeof(ChunkRef));
+        const ChunkListHeader header{kChunkListMagic, static_cast<uint32_t>(chunks.size()),
+                                     xxh64(contents.data() + sizeof(ChunkListHeader),
+                                           contents.size() - sizeof(ChunkListHeader))};
+        std::memcpy(contents.data(), &header, sizeof(header));
+        return replaceFile(lists, chunkListPath(id, sequence), contents.data(), contents.size());
+    }
+};
+
+Store *asStore(void *handle) {
+    return static_cast<Store *>(handle);
+}
+
+GameID makeID(const uint8_t *bytes) {
+    GameID id{};
+    std::memcpy(id.data(), bytes, id.size());
+    return id;
+}
+}  // namespace
+
+// Opens the snapshot history in `directory`, creating it if needed, and
+// starts the collector, which rebuilds reference counts in the background.
+extern "C" void *SnapshotStoreOpen(const char *directory, char *errorBuffer, int32_t errorCapacity) {
+    auto store = std::make_unique<Store>();
+    store->directory = directory;
+    store->chunksDirectory = store->directory + "/chunks";
+    if (!makeDirectory(store->directory) || !makeDirectory(store->chunksDirectory)) {
+        setError(errorBuffer, errorCapacity, store->directory + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    Store *opened = store.get();
+    store->collector = std::thread([opened] { opened->collect(); });
+    return store.release();
+}
+
+extern "C" void SnapshotStoreClose(void *handle) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(store->mutex);
+        store->closing = true;
+        store->changed.notify_all();
+    }
+    store->collector.join();
+    delete store;
+}
+
+// Records `length` bytes of `world` as the newest snapshot of game `id`,
+// storing only chunks no snapshot holds yet, and drops the oldest snapshot
+// beyond the limit. Waits for the collector's rebuild on the first capture
+// after opening. Returns 0, or -1 leaving the history as it was.
+extern "C" int32_t SnapshotStoreCapture(void *handle,
+                                        const uint8_t *id,
+                                        int32_t day,
+                                        double createdAt,
+                                        const uint8_t *world,
+                                        int64_t length) {
+    Store *store = asStore(handle);
+    if (store == nullptr || length < 0) {
+        return -1;
+    }
+    store->waitUntilReady();
+    std::lock_guard<std::mutex> captures(store->captureMutex);
+
+    const GameID game = makeID(id);
+    Manifest manifest;
+    if (!readManifest(store->manifestPath(game), manifest)) {
+        manifest = Manifest{};
+    }
+
+    std::vector<ChunkRef> chunks;
+    std::set<std::string> touchedDirectories;
+    int64_t addedBytes = 0;
+    bool stored = true;
+    const std::vector<size_t> cuts = sectionCuts(world, static_cast<size_t>(length));
+    size_t nextCut = 0;
+    for (size_t offset = 0; stored && offset < static_cast<size_t>(length);) {
+        while (cuts[nextCut] <= offset) {
+            ++nextCut;
+        }
+        const size_t chunkBytes = chunkLength(world + offset, cuts[nextCut] - offset);
+        const uint64_t hash = xxh64(world + offset, chunkBytes);
+        bool present = false;
+        {
+            // A chunk with a count of zero is still on disk; referencing
+            // it again keeps the collector from deleting it.
+            std::lock_guard<std::mutex> lock(store->mutex);
+            const auto entry = store->references.try_emplace(hash, 0);
+            present = !entry.second;
+            ++entry.first->second;
+        }
+        chunks.push_back(ChunkRef{hash, static_cast<uint32_t>(chunkBytes), 0});
+        if (!present) {
+            stored = store->writeChunk(hash, world + offset, chunkBytes);
+            touchedDirectories.insert(store->chunkDirectory(hash));
+            addedBytes += static_cast<int64_t>(chunkBytes);
+        }
+        offset += chunkBytes;
+    }
+    for (const std::string &directory : touchedDirectories) {
+        stored = stored && syncDirectory(directory);
+    }
+
+    const uint64_t sequence = manifest.nextSequence;
+    Manifest updated = manifest;
+    updated.nextSequence = sequence + 1;
+    updated.records.push_back(SnapshotRecord{sequence, length, addedBytes, createdAt, day,
+                                             static_cast<uint32_t>(chunks.size())});
+    std::vector<SnapshotRecord> dropped;
+    while (updated.records.size() > kMaxSnapshots) {
+        dropped.push_back(updated.records.front());
+        updated.records.erase(updated.records.begin());
+    }
+
+    if (!stored || !store->writeChunkList(game, sequence, chunks) || !store->writeManifest(game, updated)) {
+        ::unlink(store->chunkListPath(game, sequence).c_str());
+        store->release(chunks);
+        return -1;
+    }
+
+    for (const SnapshotRecord &record : dropped) {
+        std::vector<ChunkRef> droppedChunks;
+        const std::string path = store->chunkListPath(game, record.sequence);
+        if (readChunkList(path, droppedChunks)) {
+            store->release(droppedChunks);
+        }
+        ::unlink(path.c_str());
+    }
+    return 0;
+}
+
+// Fills up to `capacity` snapshots of game `id`, newest first, from its
+// manifest alone. Returns the number filled, or -1 if the manifest is
+// damaged.
+extern "C" int32_t SnapshotStoreList(void *handle,
+                                     const uint8_t *id,
+                                     int32_t capacity,
+                                     uint64_t *sequences,
+                                     int32_t *days,
+                                     double *createdAt,
+                                     int64_t *lengths,
+                                     int64_t *addedBytes) {
+    Store *store = asStore(handle);
+    Manifest manifest;
+    if (store == nullptr || !readManifest(store->manifestPath(makeID(id)), manifest)) {
+        return -1;
+    }
+    int32_t count = 0;
+    for (auto record = manifest.records.rbegin(); record != manifest.records.rend() && count < capacity; ++record) {
+        sequences[count] = record->sequence;
+        days[count] = record->day;
+        createdAt[count] = record->createdAt;
+        lengths[count] = record->length;
+        addedBytes[count] = record->addedBytes;
+        ++count;
+    }
+    return count;
+}
+
+// Reassembles snapshot `sequence` of game `id` into `world`, which holds
+// the snapshot's `length` bytes. Every chunk is checked against its hash.
+// Returns 0, or -1 if the snapshot is gone or damaged.
+extern "C" int32_t SnapshotStoreRestore(void *handle,
+                                        const uint8_t *id,
+                                        uint64_t sequence,
+                                        uint8_t *world,
+                                        int64_t length) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> captures(store->captureMutex);
+    std::vector<ChunkRef> chunks;
+    if (!readChunkList(store->chunkListPath(makeID(id), sequence), chunks)) {
+        return -1;
+    }
+
+    std::vector<int64_t> offsets;
+    int64_t offset = 0;
+    for (const ChunkRef &chunk : chunks) {
+        offsets.push_back(offset);
+        offset += chunk.length;
+    }
+    if (offset != length) {
+        return -1;
+    }
+
+    // Chunks are read a window at a time in one batch each. A chunk is read
+    // up to one byte past its length, so a longer file shows up as one.
+    struct Window {
+        const ChunkRef *chunks;
+        const int64_t *offsets;
+        uint8_t *world;
+    };
+    const SaveIOConsume place = [](void *context, int32_t index, const uint8_t *data, int64_t read) -> int32_t {
+        const auto *window = static_cast<const Window *>(context);
+        const ChunkRef &chunk = window->chunks[index];
+        if (read != chunk.length || xxh64(data, static_cast<size_t>(read)) != chunk.hash) {
+            return -1;
+        }
+        std::memcpy(window->world + window->offsets[index], data, static_cast<size_t>(read));
+        return 0;
+    };
+    for (size_t first = 0; first < chunks.size(); first += kRestoreWindow) {
+        const size_t count = std::min(kRestoreWindow, chunks.size() - first);
+        std::vector<int32_t> fds;
+        std::vector<int64_t> capacities;
+        for (size_t index = first; index < first + count; ++index) {
+            const int fd = ::open(store->chunkPath(chunks[index].hash).c_str(), O_RDONLY);
+            if (fd < 0) {
+                break;
+            }
+            fds.push_back(fd);
+            capacities.push_back(static_cast<int64_t>(chunks[index].length) + 1);
+        }
+        Window window{chunks.data() + first, offsets.data() + first, world};
+        const bool restored = fds.size() == count &&
+                              SaveIOReadFiles(fds.data(), capacities.data(), static_cast<int32_t>(count), place,
+                                              &window) == 0;
+        for (const int fd : fds) {
+            ::close(fd);
+        }
+        if (!restored) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Deletes every snapshot of game `id`. The manifest goes first, so a crash
+// partway leaves chunk lists the next rebuild sweeps. Returns 0, or -1 if
+// the manifest could not be removed.
+extern "C" int32_t SnapshotStoreDrop(void *handle, const uint8_t *id) {
+    Store *store = asStore(handle);
+    if (store == nullptr) {
+        return -1;
+    }
+    store->waitUntilReady();
+    std::lock_guard<std::mutex> captures(store->captureMutex);
+
+    const GameID game = makeID(id);
+    Manifest manifest;
+    const std::string path = store->manifestPath(game);
+    if (!readManifest(path, manifest)) {
+        manifest = Manifest{};
+    }
+    if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+        return -1;
+    }
+    syncDirectory(store->directory);
+
+    for (const SnapshotRecord &record : manifest.records) {
+        std::vector<ChunkRef> chunks;
+        const std::string list = store->chunkListPath(game, record.sequence);
+        if (readChunkList(list, chunks)) {
+            store->release(chunks);
+        }
+        ::unlink(list.c_str());
+    }
+    ::rmdir(store->listDirectoryPath(game).c_str());
+    return 0;
+}
@@ -0,0 +1,203 @@
+import Foundation
+
+@_silgen_name("SnapshotStoreOpen")
+private func SnapshotStoreOpen(
+    _ directory: UnsafePointer<CChar>,
+    _ errorBuffer: UnsafeMutablePointer<CChar>,
+    _ errorCapacity: Int32
+) -> OpaquePointer?
+@_silgen_name("SnapshotStoreClose")
+private func SnapshotStoreClose(_ handle: OpaquePointer)
+@_silgen_name("SnapshotStoreCapture")
+private func SnapshotStoreCapture(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ day: Int32,
+    _ createdAt: Double,
+    _ world: UnsafePointer<UInt8>?,
+    _ length: Int64
+) -> Int32
+@_silgen_name("SnapshotStoreList")
+private func SnapshotStoreList(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ capacity: Int32,
+    _ sequences: UnsafeMutablePointer<UInt64>,
+    _ days: UnsafeMutablePointer<Int32>,
+    _ createdAt: UnsafeMutablePointer<Double>,
+    _ lengths: UnsafeMutablePointer<Int64>,
+    _ addedBytes: UnsafeMutablePointer<Int64>
+) -> Int32
+@_silgen_name("SnapshotStoreRestore")
+private func SnapshotStoreRestore(
+    _ handle: OpaquePointer,
+    _ id: UnsafePointer<UInt8>,
+    _ sequence: UInt64,
+    _ world: UnsafeMutablePointer<UInt8>?,
+    _ length: Int64
+) -> Int32
+@_silgen_name("SnapshotStoreDrop")
+private func SnapshotStoreDrop(_ handle: OpaquePointer, _ id: UnsafePointer<UInt8>) -> Int32
+
+enum SnapshotStoreError: LocalizedError {
+    case unavailable(String)
+    case damaged(day: Int)
+
+    var errorDescription: String? {
+        switch self {
+        case .unavailable(let reason):
+            return Localization.shared.snapshotsUnavailableMessage(reason)
+        case .damaged(let day):
+            return Localization.shared.snapshotDamagedMessage(day: day)
+        }
+    }
+}
+
+/// Past saved worlds of every game, kept in `snapshots/` next to the saves
+/// for rewinding and auditing. Chunks are stored once by content, so a
+/// snapshot costs about as much disk as it differs from the others, and a
+/// game's snapshots are listed from one small manifest. Captures run on a
+/// background queue; unreferenced chunks are deleted by a collector thread.
+final class SnapshotStore {
+    struct Snapshot {
+        let sequence: UInt64
+        let day: Int
+        let createdAt: Date
+        /// Bytes of the archived world.
+        let length: Int
+        /// Bytes this snapshot added to the store when it was captured.
+        let addedBytes: Int
+    }
+
+    /// Snapshots kept per game; older ones are dropped as new ones arrive.
+    static let capacity = 64
+
+    private let queue = DispatchQueue(label: "com.capitalistworld.snapshots", qos: .background)
+    private let handle: OpaquePointer?
+    private let openError: String
+    private let pendingLock = NSLock()
+    /// Latest uncaptured world per game. A newer world replaces one still
+    /// waiting, so a slow disk costs snapshots, not memory.
+    private var pending: [UUID: (day: Int, world: Data)] = [:]
+
+    /// Opens the snapshot history in `directory`. One that cannot be opened
+    /// disables snapshots rather than the game.
+    init(directory: URL) {
+        let path = directory.appendingPathComponent("snapshots", isDirectory: true).path
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        handle = path.withCString { SnapshotStoreOpen($0, &errorBuffer, Int32(errorBuffer.count)) }
+        openError = String(cString: errorBuffer)
+    }
+
+    deinit {
+        if let handle {
+            queue.sync { SnapshotStoreClose(handle) }
+        }
+    }
+
+    /// Queues `world`, an encoded archive of game `id` on `day`, as the
+    /// game's newest snapshot. A failed capture loses that snapshot only.
+    func capture(_ id: UUID, day: Int, world: Data) {
+        guard handle != nil else { return }
+        pendingLock.lock()
+        let queued = pending.updateValue((day, world), forKey: id) != nil
+        pendingLock.unlock()
+        guard queued == false else { return }
+
+        queue.async { [weak self] in
+            guard let self, let handle = self.handle else { return }
+            self.pendingLock.lock()
+            let next = self.pending.removeValue(forKey: id)
+            self.pendingLock.unlock()
+            guard let next else { return }
+
+            _ = withUnsafeBytes(of: id.uuid) { idBytes in
+                next.world.withUnsafeBytes { world in
+                    SnapshotStoreCapture(
+                        handle,
+                        idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                        Int32(next.day),
+                        Date().timeIntervalSince1970,
+                        world.bindMemory(to: UInt8.self).baseAddress,
+                        Int64(world.count)
+                    )
+                }
+            }
+        }
+    }
+
+    /// Queues deletion of every snapshot of the game with `id`, after any
+    /// capture of it still queued.
+    func drop(_ id: UUID) {
+        guard let handle else { return }
+        queue.async {
+            _ = withUnsafeBytes(of: id.uuid) { idBytes in
+                SnapshotStoreDrop(handle, idBytes.bindMemory(to: UInt8.self).baseAddress!)
+            }
+        }
+    }
+
+    /// Snapshots of the game with `id`, newest first.
+    func snapshots(of id: UUID) throws -> [Snapshot] {
+        guard let handle else {
+            throw SnapshotStoreError.unavailable(openError)
+        }
+
+        let capacity = Self.capacity
+        var sequences = [UInt64](repeating: 0, count: capacity)
+        var days = [Int32](repeating: 0, count: capacity)
+        var createdAt = [Double](repeating: 0, count: capacity)
+        var lengths = [Int64](repeating: 0, count: capacity)
+        var addedBytes = [Int64](repeating: 0, count: capacity)
+        let count = withUnsafeBytes(of: id.uuid) { idBytes in
+            SnapshotStoreList(
+                handle,
+                idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                Int32(capacity),
+                &sequences,
+                &days,
+                &createdAt,
+                &lengths,
+                &addedBytes
+            )
+        }
+        guard count >= 0 else {
+            throw SnapshotStoreError.unavailable(id.uuidString)
+        }
+
+        return (0..<Int(count)).map { index in
+            Snapshot(
+                sequence: sequences[index],
+                day: Int(days[index]),
+                createdAt: Date(timeIntervalSince1970: createdAt[index]),
+                length: Int(lengths[index]),
+                addedBytes: Int(addedBytes[index])
+            )
+        }
+    }
+
+    /// The archived world of `snapshot` of the game with `id`, checked
+    /// chunk by chunk against the hashes it was stored under.
+    func world(of id: UUID, snapshot: Snapshot) throws -> Data {
+        guard let handle else {
+            throw SnapshotStoreError.unavailable(openError)
+        }
+
+        var world = Data(count: snapshot.length)
+        let result = withUnsafeBytes(of: id.uuid) { idBytes in
+            world.withUnsafeMutableBytes { buffer in
+                SnapshotStoreRestore(
+                    handle,
+                    idBytes.bindMemory(to: UInt8.self).baseAddress!,
+                    snapshot.sequence,
+                    buffer.bindMemory(to: UInt8.self).baseAddress,
+                    Int64(buffer.count)
+                )
+            }
+        }
+        guard result == 0 else {
+            throw SnapshotStoreError.damaged(day: snapshot.day)
+        }
+        return world
+    }
+}
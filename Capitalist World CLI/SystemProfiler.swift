@@ -0,0 +1,134 @@
+import Foundation
+
+@_silgen_name("ProfilerCreate")
+private func ProfilerCreate(_ systemCount: Int32) -> OpaquePointer
+@_silgen_name("ProfilerDestroy")
+private func ProfilerDestroy(_ handle: OpaquePointer)
+@_silgen_name("ProfilerNow")
+private func ProfilerNow() -> UInt64
+@_silgen_name("ProfilerRecord")
+private func ProfilerRecord(_ handle: OpaquePointer, _ system: Int32, _ startTicks: UInt64, _ endTicks: UInt64)
+@_silgen_name("ProfilerStatistics")
+private func ProfilerStatistics(
+    _ handle: OpaquePointer,
+    _ system: Int32,
+    _ count: UnsafeMutablePointer<UInt64>,
+    _ totalNanoseconds: UnsafeMutablePointer<UInt64>,
+    _ maxNanoseconds: UnsafeMutablePointer<UInt64>,
+    _ p50Nanoseconds: UnsafeMutablePointer<UInt64>,
+    _ p99Nanoseconds: UnsafeMutablePointer<UInt64>
+)
+@_silgen_name("ProfilerReset")
+private func ProfilerReset(_ handle: OpaquePointer)
+
+/// Scoped timers around each step of the simulated day, read from the CPU
+/// cycle counter and aggregated natively into per-system histograms. Only
+/// used from the simulation queue.
+final class SystemProfiler {
+    enum System: Int32, CaseIterable {
+        case marketing
+        case finance
+        case insolvency
+        case inventory
+        case demand
+        case prices
+        case growth
+        case achievements
+        case liquidations
+        case acquisitions
+        /// The whole simulated day, including everything above.
+        case day
+
+        var key: String {
+            switch self {
+            case .marketing:
+                return "profile.system.marketing"
+            case .finance:
+                return "profile.system.finance"
+            case .insolvency:
+                return "profile.system.insolvency"
+            case .inventory:
+                return "profile.system.inventory"
+            case .demand:
+                return "profile.system.demand"
+            case .prices:
+                return "profile.system.prices"
+            case .growth:
+                return "profile.system.growth"
+            case .achievements:
+                return "profile.system.achievements"
+            case .liquidations:
+                return "profile.system.liquidations"
+            case .acquisitions:
+                return "profile.system.acquisitions"
+            case .day:
+                return "profile.system.day"
+            }
+        }
+    }
+
+    struct Statistics {
+        let system: System
+        let samples: UInt64
+        let totalNanoseconds: UInt64
+        let maxNanoseconds: UInt64
+        let p50Nanoseconds: UInt64
+        let p99Nanoseconds: UInt64
+
+        var meanNanoseconds: Double {
+            samples == 0 ? 0 : Double(totalNanoseconds) / Double(samples)
+        }
+    }
+
+    static let defaultBudgetShare = 0.1
+    static let budgetShareRange = 0.001...1.0
+
+    /// Share of the real time a simulated day takes at the current speed
+    /// that each system may use before it is flagged.
+    var budgetShare = defaultBudgetShare
+
+    private let handle = ProfilerCreate(Int32(System.allCases.count))
+
+    deinit {
+        ProfilerDestroy(handle)
+    }
+
+    @inline(__always)
+    func measure<T>(_ system: System, _ body: () throws -> T) rethrows -> T {
+        let start = ProfilerNow()
+        defer { ProfilerRecord(handle, system.rawValue, start, ProfilerNow()) }
+        return try body()
+    }
+
+    func statistics() -> [Statistics] {
+        System.allCases.map { system in
+            var samples: UInt64 = 0
+            var total: UInt64 = 0
+            var maximum: UInt64 = 0
+            var p50: UInt64 = 0
+            var p99: UInt64 = 0
+            ProfilerStatistics(handle, system.rawValue, &samples, &total, &maximum, &p50, &p99)
+            return Statistics(
+                system: system,
+                samples: samples,
+                totalNanoseconds: total,
+                maxNanoseconds: maximum,
+                p50Nanoseconds: p50,
+                p99Nanoseconds: p99
+            )
+        }
+    }
+
+    func reset() {
+        ProfilerReset(handle)
+    }
+
+    /// Per-system budget for one simulated day at `speed`, or `nil` while
+    /// the clock is paused.
+    func budgetNanoseconds(at speed: SimulationClock.Speed) -> Double? {
+        let ratio = speed.simulatedSecondsPerRealSecond
+        guard ratio > 0 else { return nil }
+        let realSecondsPerDay = 86_400 / ratio
+        return realSecondsPerDay * budgetShare * 1_000_000_000
+    }
+}
@@ -1,10 +1,19 @@
 import Foundation
+#if canImport(Darwin)
 import Darwin
+#else
+import Glibc
+#endif
 
 enum TerminalLauncher {
     private static let terminalFlagKey = "CAPITALIST_WORLD_CLI_TERMINAL"
 
     static func ensureInteractiveSession() {
+        #if !os(macOS)
+        // Terminal.app only exists on macOS; elsewhere the binary is always
+        // started from a shell already.
+        return
+        #else
         let environment = ProcessInfo.processInfo.environment
         if environment["CAPITALIST_DISABLE_TERMINAL"] != nil { return }
         guard environment[terminalFlagKey] == nil else { return }
@@ -54,6 +63,7 @@ enum TerminalLauncher {
         }
 
         exit(0)
+        #endif
     }
 
     private static func shellQuote(_ value: String) -> String {
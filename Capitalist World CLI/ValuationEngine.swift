@@ -0,0 +1,106 @@
+import Foundation
+
+@_silgen_name("ValueCompaniesDCF")
+private func ValueCompaniesDCF(
+    _ cashFlows: UnsafePointer<Double>,
+    _ terminalGrowth: UnsafePointer<Double>,
+    _ companyCount: Int32,
+    _ horizonYears: Int32,
+    _ discountRate: Double,
+    _ sensitivityBasisPoints: Double,
+    _ baseValues: UnsafeMutablePointer<Double>,
+    _ lowerRateValues: UnsafeMutablePointer<Double>,
+    _ higherRateValues: UnsafeMutablePointer<Double>
+)
+
+struct CompanyValuation {
+    let enterpriseValue: Double
+    let valueAtLowerRate: Double
+    let valueAtHigherRate: Double
+}
+
+/// Values every company in the world with one batched DCF pass and caches
+/// the result until `World.financialsRevision` changes.
+final class ValuationEngine {
+    static let horizonYears = 10
+
+    let discountRate: Double
+    let sensitivityBasisPoints: Double
+
+    private var cachedRevision: UInt64?
+    private var cachedSeed: UInt64?
+    private var cashFlows: [Double] = []
+    private var terminalGrowth: [Double] = []
+    private var baseValues: [Double] = []
+    private var lowerRateValues: [Double] = []
+    private var higherRateValues: [Double] = []
+
+    init(discountRate: Double = 0.08, sensitivityBasisPoints: Double = 100) {
+        self.discountRate = discountRate
+        self.sensitivityBasisPoints = sensitivityBasisPoints
+    }
+
+    func valuation(of index: Int, in world: World) -> CompanyValuation {
+        refreshIfNeeded(for: world)
+        return CompanyValuation(
+            enterpriseValue: baseValues[index],
+            valueAtLowerRate: lowerRateValues[index],
+            valueAtHigherRate: higherRateValues[index]
+        )
+    }
+
+    func invalidate() {
+        cachedRevision = nil
+        cachedSeed = nil
+    }
+
+    private func refreshIfNeeded(for world: World) {
+        let count = world.companyCount
+        if cachedRevision == world.financialsRevision, cachedSeed == world.seed, baseValues.count == count {
+            return
+        }
+
+        let horizon = Self.horizonYears
+        cashFlows = [Double](repeating: 0, count: count * horizon)
+        terminalGrowth = Array(world.companyGrowth)
+        baseValues = [Double](repeating: 0, count: count)
+        lowerRateValues = [Double](repeating: 0, count: count)
+        higherRateValues = [Double](repeating: 0, count: count)
+
+        for company in 0..<count {
+            let growth = 1 + world.companyGrowth[company]
+            var flow = world.companyRevenue[company] - world.companyCosts[company]
+            for year in 0..<horizon {
+                flow *= growth
+                cashFlows[year * count + company] = flow
+            }
+        }
+
+        if count > 0 {
+            cashFlows.withUnsafeBufferPointer { flows in
+                terminalGrowth.withUnsafeBufferPointer { growth in
+                    baseValues.withUnsafeMutableBufferPointer { base in
+                        lowerRateValues.withUnsafeMutableBufferPointer { lower in
+                            higherRateValues.withUnsafeMutableBufferPointer { higher in
+                                ValueCompaniesDCF(
+                                    flows.baseAddress!,
+                                    growth.baseAddress!,
+                                    Int32(count),
+                                    Int32(horizon),
+                                    discountRate,
+                                    sensitivityBasisPoints,
+                                    base.baseAddress!,
+                                    lower.baseAddress!,
+                                    higher.baseAddress!
+                                )
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        cachedRevision = world.financialsRevision
+        cachedSeed = world.seed
+    }
+}
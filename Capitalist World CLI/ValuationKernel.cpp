@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+constexpr double kBasisPoint = 0.0001;
+constexpr double kMinimumGrowthSpread = 0.005;
+}  // namespace
+
+// Discounted cash-flow valuation for a batch of companies.
+//
+// `cashFlows` is year-major: the projection for year `y` of company `c` lives
+// at `cashFlows[y * companyCount + c]`, so the inner loop walks contiguous
+// memory across companies and vectorizes. The base rate and the rate shifted
+// down/up by `sensitivityBasisPoints` are evaluated in the same pass.
+extern "C" void ValueCompaniesDCF(const double *cashFlows,
+                                  const double *terminalGrowth,
+                                  int32_t companyCount,
+                                  int32_t horizonYears,
+                                  double discountRate,
+                                  double sensitivityBasisPoints,
+                                  double *baseValues,
+                                  double *lowerRateValues,
+                                  double *higherRateValues) {
+    if (cashFlows == nullptr || companyCount <= 0 || horizonYears <= 0) {
+        return;
+    }
+
+    const double shift = sensitivityBasisPoints * kBasisPoint;
+    const double baseRate = discountRate;
+    const double lowerRate = std::max(discountRate - shift, kMinimumGrowthSpread * 2);
+    const double higherRate = discountRate + shift;
+
+    std::fill(baseValues, baseValues + companyCount, 0.0);
+    std::fill(lowerRateValues, lowerRateValues + companyCount, 0.0);
+    std::fill(higherRateValues, higherRateValues + companyCount, 0.0);
+
+    double baseFactor = 1.0;
+    double lowerFactor = 1.0;
+    double higherFactor = 1.0;
+
+    for (int32_t year = 0; year < horizonYears; ++year) {
+        baseFactor /= 1.0 + baseRate;
+        lowerFactor /= 1.0 + lowerRate;
+        higherFactor /= 1.0 + higherRate;
+
+        const double *row = cashFlows + static_cast<int64_t>(year) * companyCount;
+        for (int32_t company = 0; company < companyCount; ++company) {
+            const double flow = row[company];
+            baseValues[company] += flow * baseFactor;
+            lowerRateValues[company] += flow * lowerFactor;
+            higherRateValues[company] += flow * higherFactor;
+        }
+    }
+
+    // Gordon growth terminal value on the final projected year. Growth is
+    // clamped below the lowest rate so the perpetuity stays finite.
+    const double *lastRow = cashFlows + static_cast<int64_t>(horizonYears - 1) * companyCount;
+    const double maxGrowth = lowerRate - kMinimumGrowthSpread;
+    for (int32_t company = 0; company < companyCount; ++company) {
+        const double growth = terminalGrowth != nullptr ? std::min(terminalGrowth[company], maxGrowth) : 0.0;
+        const double nextFlow = lastRow[company] * (1.0 + growth);
+        baseValues[company] += nextFlow / (baseRate - growth) * baseFactor;
+        lowerRateValues[company] += nextFlow / (lowerRate - growth) * lowerFactor;
+        higherRateValues[company] += nextFlow / (higherRate - growth) * higherFactor;
+    }
+}
@@ -0,0 +1,645 @@
+import Foundation
+
+@_silgen_name("FindInsolventCompanies")
+private func FindInsolventCompanies(
+    _ cash: UnsafePointer<Double>,
+    _ creditLimit: UnsafePointer<Double>,
+    _ owner: UnsafePointer<Int32>,
+    _ count: Int32,
+    _ baseIndex: Int32,
+    _ insolvent: UnsafeMutablePointer<Int32>
+) -> Int32
+
+/// Simulation state for a single game. Companies are stored as parallel
+/// arrays so daily systems sweep contiguous memory instead of objects. The
+/// arrays are `ChunkedArray`s, which makes `fork()` O(1).
+final class World {
+    static let playerCompanyIndex = 0
+    static let independentOwner: Int32 = -1
+
+    private static let rivalCount = 24
+    private static let daysPerYear = 365.0
+    static let daysPerMonth = 30
+    /// Market makers buy back goods at this share of the asking price.
+    static let sellPriceRatio = 0.95
+    private static let dailyPriceVolatility = 0.02
+    private static let priceMeanReversion = 0.05
+    /// Monthly chance that an independent rival launches a campaign.
+    private static let rivalCampaignChance = 0.1
+    /// Rivals advertise with this share of their daily revenue.
+    private static let rivalAdvertisingShare = 0.03
+    /// Credit line granted to each company, as a share of annual revenue.
+    private static let creditLimitShare = 0.1
+    /// Liquidated stock is auctioned at this share of its carrying value.
+    private static let liquidationDiscount = 0.5
+
+    /// Cumulative income statement of the player's company.
+    struct Ledger: Codable {
+        var revenue: Double = 0
+        var costOfGoodsSold: Double = 0
+        var subsidiaryIncome: Double = 0
+        var marketingExpense: Double = 0
+
+        var profit: Double { revenue - costOfGoodsSold + subsidiaryIncome - marketingExpense }
+
+        init() {}
+
+        // Ledgers saved before marketing existed lack `marketingExpense`.
+        init(from decoder: Decoder) throws {
+            let container = try decoder.container(keyedBy: CodingKeys.self)
+            revenue = try container.decode(Double.self, forKey: .revenue)
+            costOfGoodsSold = try container.decode(Double.self, forKey: .costOfGoodsSold)
+            subsidiaryIncome = try container.decode(Double.self, forKey: .subsidiaryIncome)
+            marketingExpense = try container.decodeIfPresent(Double.self, forKey: .marketingExpense) ?? 0
+        }
+    }
+
+    struct State: Codable {
+        var seed: UInt64
+        var day: Int
+        var companyNames: [String]
+        var companyCash: [Double]
+        var companyRevenue: [Double]
+        var companyCosts: [Double]
+        var companyGrowth: [Double]
+        var companyOwner: [Int32]
+        // Optional so worlds saved before inventory existed still decode.
+        var randomState: UInt64?
+        var warehouseNames: [String]?
+        var warehouseOwner: [Int32]?
+        var goodPrices: [Double]?
+        var inventoryMethod: InventoryLedger.CostingMethod?
+        var inventoryLayers: [InventoryLedger.Layer]?
+        var ledger: Ledger?
+        var regionNames: [String]?
+        var companyRegion: [Int32]?
+        var goodBasePrices: [Double]?
+        var startDayOfYear: Int?
+        var marketing: Marketing.State?
+        var achievements: [String: Int]?
+        var companyCreditLimit: [Double]?
+        var companyHandles: CompanyHandleTable.State?
+    }
+
+    let seed: UInt64
+    private(set) var day: Int
+
+    var companyNames: ChunkedArray<String>
+    var companyCash: ChunkedArray<Double>
+    /// Annual revenue and operating costs; their difference is the free cash
+    /// flow projected by `ValuationEngine`.
+    var companyRevenue: ChunkedArray<Double>
+    var companyCosts: ChunkedArray<Double>
+    var companyGrowth: ChunkedArray<Double>
+    /// Index of the owning company, or `independentOwner`.
+    var companyOwner: ChunkedArray<Int32>
+    /// Covenant: a company fails once its cash falls below minus this limit.
+    var companyCreditLimit: ChunkedArray<Double>
+    /// Stable IDs for the dense company indices, which move on compaction.
+    private(set) var companyHandles: CompanyHandleTable
+    /// Insolvent companies found today, liquidated at the end of the day.
+    private var pendingLiquidations: [Int] = []
+
+    /// Home region of each company, indexing `regionNames`.
+    var companyRegion: ChunkedArray<Int32>
+    let regionNames: [String]
+
+    var warehouseNames: ChunkedArray<String>
+    var warehouseOwner: ChunkedArray<Int32>
+    /// Current asking price per `Good`, indexed by raw value.
+    var goodPrices: [Double]
+    /// Prices the market reverts to; set by the scenario.
+    let goodBasePrices: [Double]
+    /// Day of the year (0-based) the game started on; anchors seasonality.
+    let startDayOfYear: Int
+    /// Shared between forks: seasonal tables are derived from the seed and
+    /// never change.
+    let demandModel: DemandModel
+    /// Today's demand multiplier per region and good, laid out as
+    /// `regionalDemand[region * Good.allCases.count + good]`.
+    private(set) var regionalDemand: [Double] = []
+    /// Mean of `regionalDemand` over goods, per region; scales revenue.
+    private(set) var regionDemandIndex: [Double] = []
+    let inventory: InventoryLedger
+    var marketing: Marketing
+    private(set) var achievements: AchievementTracker
+    var ledger: Ledger
+    var generator: SeededGenerator
+
+    /// Bumped whenever revenue, costs, growth or the company set changes, so
+    /// cached valuations know when they are stale.
+    private(set) var financialsRevision: UInt64 = 0
+
+    var companyCount: Int { companyNames.count }
+
+    var dayOfYear: Int { (startDayOfYear + day) % DemandModel.daysPerYear }
+
+    var playerCash: Double {
+        get { companyCash[Self.playerCompanyIndex] }
+        set { companyCash[Self.playerCompanyIndex] = newValue }
+    }
+
+    init(state: State) {
+        seed = state.seed
+        day = state.day
+        companyNames = ChunkedArray(state.companyNames)
+        companyCash = ChunkedArray(state.companyCash)
+        companyRevenue = ChunkedArray(state.companyRevenue)
+        companyCosts = ChunkedArray(state.companyCosts)
+        companyGrowth = ChunkedArray(state.companyGrowth)
+        companyOwner = ChunkedArray(state.companyOwner)
+        companyCreditLimit = ChunkedArray(state.companyCreditLimit ?? state.companyRevenue.map { $0 * Self.creditLimitShare })
+        companyHandles = state.companyHandles.map(CompanyHandleTable.init(state:)) ?? CompanyHandleTable(count: state.companyNames.count)
+        generator = SeededGenerator(seed: state.randomState ?? state.seed)
+        warehouseNames = ChunkedArray(state.warehouseNames ?? state.companyNames)
+        warehouseOwner = ChunkedArray(state.warehouseOwner ?? state.companyNames.indices.map { Int32($0) })
+        goodBasePrices = state.goodBasePrices ?? Good.allCases.map(\.basePrice)
+        goodPrices = state.goodPrices ?? goodBasePrices
+        regionNames = state.regionNames ?? ScenarioPack.defaultRegionNames
+        companyRegion = ChunkedArray(state.companyRegion ?? [Int32](repeating: 0, count: state.companyNames.count))
+        startDayOfYear = state.startDayOfYear ?? 0
+        demandModel = DemandModel(regionCount: regionNames.count, seed: state.seed)
+        marketing = Marketing(brandCount: state.companyNames.count, regionCount: regionNames.count, state: state.marketing)
+        achievements = AchievementTracker(unlocked: state.achievements ?? [:])
+        ledger = state.ledger ?? Ledger()
+        inventory = InventoryLedger(
+            method: state.inventoryMethod ?? .fifo,
+            pairCount: warehouseNames.count * Good.allCases.count,
+            layers: state.inventoryLayers ?? []
+        )
+        updateRegionalDemand()
+    }
+
+    /// Copy-on-write fork: shares every chunk with `source` until one side
+    /// writes to it.
+    private init(forking source: World) {
+        seed = source.seed
+        day = source.day
+        companyNames = source.companyNames
+        companyCash = source.companyCash
+        companyRevenue = source.companyRevenue
+        companyCosts = source.companyCosts
+        companyGrowth = source.companyGrowth
+        companyOwner = source.companyOwner
+        companyCreditLimit = source.companyCreditLimit
+        companyHandles = source.companyHandles
+        pendingLiquidations = source.pendingLiquidations
+        warehouseNames = source.warehouseNames
+        warehouseOwner = source.warehouseOwner
+        companyRegion = source.companyRegion
+        regionNames = source.regionNames
+        goodPrices = source.goodPrices
+        goodBasePrices = source.goodBasePrices
+        startDayOfYear = source.startDayOfYear
+        demandModel = source.demandModel
+        regionalDemand = source.regionalDemand
+        regionDemandIndex = source.regionDemandIndex
+        inventory = source.inventory.fork()
+        marketing = source.marketing
+        achievements = source.achievements
+        ledger = source.ledger
+        generator = source.generator
+        financialsRevision = source.financialsRevision
+    }
+
+    func fork() -> World {
+        World(forking: self)
+    }
+
+    /// Everything `WorldArchive` does not store as a column: company and
+    /// warehouse arrays, inventory layers and brand awareness are left
+    /// empty. Settles pending inventory first so the saved ledger matches
+    /// the layers exported afterwards.
+    func scalarState() -> State {
+        settleInventory()
+        var marketingState = marketing.state
+        marketingState.awareness = []
+        return State(
+            seed: seed,
+            day: day,
+            companyNames: [],
+            companyCash: [],
+            companyRevenue: [],
+            companyCosts: [],
+            companyGrowth: [],
+            companyOwner: [],
+            randomState: generator.state,
+            warehouseNames: [],
+            warehouseOwner: [],
+            goodPrices: goodPrices,
+            inventoryMethod: inventory.method,
+            inventoryLayers: nil,
+            ledger: ledger,
+            regionNames: regionNames,
+            companyRegion: [],
+            goodBasePrices: goodBasePrices,
+            startDayOfYear: startDayOfYear,
+            marketing: marketingState,
+            achievements: achievements.unlocked,
+            companyCreditLimit: [],
+            companyHandles: companyHandles.state
+        )
+    }
+
+    /// Decodes a world saved as `WorldArchive` data.
+    static func decode(_ data: Data) throws -> World {
+        try WorldArchive.decode(data)
+    }
+
+    /// Builds the opening world. Rivals come from the scenario pack when it
+    /// defines companies, otherwise they are generated from `seed`.
+    static func generate(
+        seed: UUID,
+        playerCompanyName: String,
+        startingBalance: Double,
+        scenario: ScenarioPack = .shared
+    ) -> World {
+        var generator = SeededGenerator(uuid: seed)
+        var state = State(
+            seed: generator.next(),
+            day: 0,
+            companyNames: [playerCompanyName],
+            companyCash: [startingBalance],
+            companyRevenue: [0],
+            companyCosts: [0],
+            companyGrowth: [0],
+            companyOwner: [independentOwner],
+            randomState: nil,
+            warehouseNames: nil,
+            warehouseOwner: nil,
+            goodPrices: nil,
+            inventoryMethod: .fifo,
+            inventoryLayers: nil,
+            ledger: nil,
+            regionNames: scenario.regionNames,
+            companyRegion: [0],
+            goodBasePrices: scenario.goodBasePrices,
+            startDayOfYear: (Calendar(identifier: .gregorian).ordinality(of: .day, in: .year, for: scenario.referenceDate) ?? 1) - 1,
+            marketing: nil,
+            achievements: nil,
+            companyCreditLimit: nil,
+            companyHandles: nil
+        )
+
+        var usedNames = Set([playerCompanyName.lowercased()])
+        for index in 0..<scenario.companyCount {
+            let company = scenario.company(at: index)
+            guard usedNames.insert(company.name.lowercased()).inserted else { continue }
+
+            state.companyNames.append(company.name)
+            state.companyCash.append(company.cash)
+            state.companyRevenue.append(company.revenue)
+            state.companyCosts.append(company.revenue * (1 - company.margin))
+            state.companyGrowth.append(company.growth)
+            state.companyOwner.append(independentOwner)
+            state.companyRegion?.append(Int32(company.region))
+        }
+
+        while scenario.companyCount == 0, state.companyNames.count <= rivalCount {
+            let name = "\(rivalPrefixes.randomElement(using: &generator)!) \(rivalSuffixes.randomElement(using: &generator)!)"
+            guard usedNames.insert(name.lowercased()).inserted else { continue }
+
+            let revenue = Double.random(in: 500_000...20_000_000, using: &generator)
+            let margin = Double.random(in: 0.04...0.22, using: &generator)
+            state.companyNames.append(name)
+            state.companyCash.append(Double.random(in: 1_000_000...30_000_000, using: &generator))
+            state.companyRevenue.append(revenue)
+            state.companyCosts.append(revenue * (1 - margin))
+            state.companyGrowth.append(Double.random(in: -0.02...0.08, using: &generator))
+            state.companyOwner.append(independentOwner)
+            state.companyRegion?.append(Int32.random(in: 0..<Int32(scenario.regionNames.count), using: &generator))
+        }
+
+        return World(state: state)
+    }
+
+    func index(ofCompanyNamed name: String) -> Int? {
+        let lowercased = name.lowercased()
+        return companyNames.firstIndex { $0.lowercased() == lowercased }
+    }
+
+    func pairIndex(warehouse: Int, good: Good) -> Int {
+        warehouse * Good.allCases.count + good.rawValue
+    }
+
+    func warehouses(ownedBy company: Int) -> [Int] {
+        warehouseOwner.indices.filter { warehouseOwner[$0] == Int32(company) }
+    }
+
+    /// Bid for the player's goods; brand awareness in the player's home
+    /// region earns a premium.
+    func sellPrice(of good: Good) -> Double {
+        let lift = marketing.revenueLift(brand: Self.playerCompanyIndex, region: Int(companyRegion[Self.playerCompanyIndex]))
+        return goodPrices[good.rawValue] * Self.sellPriceRatio * lift
+    }
+
+    /// Company that receives the profits of `index`: its owner if it has one,
+    /// otherwise itself.
+    func beneficiary(of index: Int) -> Int {
+        let owner = companyOwner[index]
+        return owner == Self.independentOwner ? index : Int(owner)
+    }
+
+    /// Whether the day just simulated closed a month.
+    var isMonthEnd: Bool { day % Self.daysPerMonth == 0 }
+
+    /// Advances one simulated day: runs marketing, books each company's
+    /// daily operating result and applies monthly revenue growth. Each step
+    /// is timed under its own `profiler` system.
+    func advanceDay(profiler: SystemProfiler) {
+        day += 1
+
+        profiler.measure(.marketing) {
+            marketing.processEvents(through: day)
+            chargeMarketingSpend()
+            marketing.advanceDay()
+        }
+        profiler.measure(.demand, updateRegionalDemand)
+        profiler.measure(.finance, bookOperatingResults)
+        profiler.measure(.insolvency, queueInsolventCompanies)
+        profiler.measure(.inventory, settleInventory)
+        profiler.measure(.prices, updateGoodPrices)
+
+        if isMonthEnd {
+            profiler.measure(.growth) {
+                applyMonthlyGrowth()
+                launchRivalCampaigns()
+                markFinancialsChanged()
+            }
+        }
+
+        profiler.measure(.achievements) {
+            achievements.update(day: day, measure: measure(_:))
+        }
+        profiler.measure(.liquidations, processLiquidations)
+    }
+
+    private func bookOperatingResults() {
+        for index in 0..<companyCount {
+            let region = Int(companyRegion[index])
+            let revenue = companyRevenue[index] * regionDemandIndex[region] * marketing.revenueLift(brand: index, region: region)
+            let dailyProfit = (revenue - companyCosts[index]) / Self.daysPerYear
+            let recipient = beneficiary(of: index)
+            companyCash[recipient] += dailyProfit
+            if recipient == Self.playerCompanyIndex, index != recipient {
+                ledger.subsidiaryIncome += dailyProfit
+            }
+        }
+    }
+
+    private func applyMonthlyGrowth() {
+        for index in 0..<companyCount {
+            let factor = 1 + companyGrowth[index] / 12
+            companyRevenue[index] *= factor
+            companyCosts[index] *= factor
+            companyCreditLimit[index] = companyRevenue[index] * Self.creditLimitShare
+        }
+    }
+
+    /// Sweeps cash, credit and owner chunk by chunk in a native kernel and
+    /// queues every independent rival that has run out of both.
+    private func queueInsolventCompanies() {
+        var found = [Int32](repeating: 0, count: companyCount)
+        var total = 0
+
+        for chunk in 0..<companyCash.chunkCount {
+            let offset = total
+            let written = companyCash.withUnsafeChunk(chunk) { cash, start in
+                companyCreditLimit.withUnsafeChunk(chunk) { credit, _ in
+                    companyOwner.withUnsafeChunk(chunk) { owner, _ in
+                        found.withUnsafeMutableBufferPointer { output in
+                            Int(FindInsolventCompanies(
+                                cash.baseAddress!,
+                                credit.baseAddress!,
+                                owner.baseAddress!,
+                                Int32(cash.count),
+                                Int32(start),
+                                output.baseAddress! + offset
+                            ))
+                        }
+                    }
+                }
+            }
+            total += written
+        }
+
+        for index in found.prefix(total) where Int(index) != Self.playerCompanyIndex {
+            pendingLiquidations.append(Int(index))
+        }
+    }
+
+    /// Liquidates the day's insolvent companies in one batch: auctions their
+    /// warehouses, spins off their subsidiaries, then compacts every company
+    /// array so no hot loop walks over dead firms.
+    private func processLiquidations() {
+        guard pendingLiquidations.isEmpty == false else { return }
+        let removed = Array(Set(pendingLiquidations)).sorted()
+        pendingLiquidations.removeAll()
+        let isRemoved = Set(removed)
+
+        for company in removed {
+            auctionWarehouses(of: company, excluding: isRemoved)
+            for index in 0..<companyCount where companyOwner[index] == Int32(company) {
+                companyOwner[index] = Self.independentOwner
+            }
+        }
+
+        var newIndex = [Int32](repeating: Self.independentOwner, count: companyCount)
+        var next: Int32 = 0
+        for index in 0..<companyCount where isRemoved.contains(index) == false {
+            newIndex[index] = next
+            next += 1
+        }
+
+        companyNames.remove(atSortedOffsets: removed)
+        companyCash.remove(atSortedOffsets: removed)
+        companyRevenue.remove(atSortedOffsets: removed)
+        companyCosts.remove(atSortedOffsets: removed)
+        companyGrowth.remove(atSortedOffsets: removed)
+        companyOwner.remove(atSortedOffsets: removed)
+        companyRegion.remove(atSortedOffsets: removed)
+        companyCreditLimit.remove(atSortedOffsets: removed)
+        companyHandles.compact(removing: removed)
+        marketing.removeBrands(removed)
+
+        for index in 0..<companyCount where companyOwner[index] != Self.independentOwner {
+            companyOwner[index] = newIndex[Int(companyOwner[index])]
+        }
+        for warehouse in 0..<warehouseOwner.count where warehouseOwner[warehouse] != Self.independentOwner {
+            warehouseOwner[warehouse] = newIndex[Int(warehouseOwner[warehouse])]
+        }
+
+        markFinancialsChanged()
+    }
+
+    /// Sells each warehouse of a failed company, stock included, to the
+    /// richest surviving independent rival that can pay the discounted
+    /// carrying value. Unsold warehouses are left without an owner.
+    private func auctionWarehouses(of company: Int, excluding failed: Set<Int>) {
+        for warehouse in warehouses(ownedBy: company) {
+            let stockValue = Good.allCases.reduce(0) { total, good in
+                total + inventory.carryingValue(pair: pairIndex(warehouse: warehouse, good: good))
+            }
+            let price = stockValue * Self.liquidationDiscount
+
+            let bidder = (0..<companyCount)
+                .filter { index in
+                    index != Self.playerCompanyIndex
+                        && companyOwner[index] == Self.independentOwner
+                        && failed.contains(index) == false
+                        && companyCash[index] >= price
+                }
+                .max { companyCash[$0] < companyCash[$1] }
+
+            if let bidder {
+                companyCash[bidder] -= price
+                warehouseOwner[warehouse] = Int32(bidder)
+            } else {
+                warehouseOwner[warehouse] = Self.independentOwner
+            }
+        }
+    }
+
+    func companyID(of index: Int) -> CompanyID {
+        companyHandles.id(of: index)
+    }
+
+    /// Current index of `id`, or `nil` if the company has been liquidated.
+    func companyIndex(of id: CompanyID) -> Int? {
+        companyHandles.index(of: id)
+    }
+
+    /// Current value of a metric read by achievement rules.
+    private func measure(_ metric: AchievementPlan.Metric) -> Double {
+        let player = Self.playerCompanyIndex
+        switch metric {
+        case .cash:
+            return playerCash
+        case .profit:
+            return ledger.profit
+        case .sales:
+            return ledger.revenue
+        case .subsidiaries:
+            return Double(companyOwner.lazy.filter { $0 == Int32(player) }.count)
+        case .monopolies:
+            var companies = [Int](repeating: 0, count: regionNames.count)
+            var controlled = [Int](repeating: 0, count: regionNames.count)
+            for index in 0..<companyCount {
+                let region = Int(companyRegion[index])
+                companies[region] += 1
+                if index == player || companyOwner[index] == Int32(player) {
+                    controlled[region] += 1
+                }
+            }
+            return Double(regionNames.indices.filter { companies[$0] > 1 && controlled[$0] == companies[$0] }.count)
+        case .awareness:
+            return regionNames.indices.map { marketing.share(brand: player, region: $0) }.max() ?? 0
+        case .days:
+            return Double(day)
+        case .stock(let good):
+            return warehouses(ownedBy: player).reduce(0) { total, warehouse in
+                total + inventory.availableQuantity(pair: pairIndex(warehouse: warehouse, good: good))
+            }
+        }
+    }
+
+    /// Pays each brand's running campaigns from its beneficiary's cash.
+    private func chargeMarketingSpend() {
+        for brand in 0..<marketing.brandCount where marketing.brandSpend[brand] > 0 {
+            let spend = marketing.brandSpend[brand]
+            let payer = beneficiary(of: brand)
+            companyCash[payer] -= spend
+            if payer == Self.playerCompanyIndex {
+                ledger.marketingExpense += spend
+            }
+        }
+    }
+
+    private func launchRivalCampaigns() {
+        for index in 0..<companyCount where index != Self.playerCompanyIndex && companyOwner[index] == Self.independentOwner {
+            guard Double.random(in: 0..<1, using: &generator) < Self.rivalCampaignChance else { continue }
+
+            let dailySpend = companyRevenue[index] / Self.daysPerYear * Self.rivalAdvertisingShare
+            guard dailySpend > 0 else { continue }
+            marketing.launchCampaign(
+                brand: index,
+                region: Int(companyRegion[index]),
+                dailySpend: dailySpend,
+                startDay: day + 1,
+                days: Self.daysPerMonth
+            )
+        }
+    }
+
+    /// Transfers `target` (and anything it owns) to `acquirer` for `price`.
+    /// The target's cash is consolidated into the acquirer, and the price is
+    /// paid to the seller: the target's previous owner, or for an
+    /// independent target its shareholders, whose proceeds stay on the
+    /// target's books. No cash enters or leaves the economy.
+    func transferOwnership(of target: Int, to acquirer: Int, price: Double) {
+        let seller = beneficiary(of: target)
+        companyCash[acquirer] += companyCash[target] - price
+        companyCash[target] = 0
+        companyCash[seller] += price
+        companyOwner[target] = Int32(acquirer)
+
+        for index in 0..<companyCount where companyOwner[index] == Int32(target) {
+            companyOwner[index] = Int32(acquirer)
+        }
+    }
+
+    /// Applies the day's queued receipts and issues and books the cost of
+    /// goods sold.
+    func settleInventory() {
+        ledger.costOfGoodsSold += inventory.processDailyBatch()
+    }
+
+    /// Looks up today's seasonal demand and applies the day's weather.
+    private func updateRegionalDemand() {
+        demandModel.fillDemand(&regionalDemand, dayOfYear: dayOfYear, weather: demandModel.weatherAnomalies(day: day))
+
+        let goodCount = Good.allCases.count
+        regionDemandIndex = (0..<demandModel.regionCount).map { region in
+            regionalDemand[region * goodCount..<(region + 1) * goodCount].reduce(0, +) / Double(goodCount)
+        }
+    }
+
+    /// Average demand multiplier for `good` across regions.
+    func demandIndex(of good: Good) -> Double {
+        let goodCount = Good.allCases.count
+        let regions = demandModel.regionCount
+        guard regions > 0 else { return 1 }
+
+        var total = 0.0
+        for region in 0..<regions {
+            total += regionalDemand[region * goodCount + good.rawValue]
+        }
+        return total / Double(regions)
+    }
+
+    /// Mean-reverting random walk around each good's base price scaled by
+    /// current demand.
+    private func updateGoodPrices() {
+        for good in Good.allCases {
+            let current = goodPrices[good.rawValue]
+            let target = goodBasePrices[good.rawValue] * demandIndex(of: good)
+            let shock = Double.random(in: -Self.dailyPriceVolatility...Self.dailyPriceVolatility, using: &generator)
+            let reversion = (target - current) / current * Self.priceMeanReversion
+            goodPrices[good.rawValue] = current * (1 + shock + reversion)
+        }
+    }
+
+    func markFinancialsChanged() {
+        financialsRevision &+= 1
+    }
+
+    private static let rivalPrefixes = [
+        "Atlas", "Boreal", "Cobalt", "Delta", "Everest", "Fulton", "Granite", "Harbor",
+        "Imperial", "Juniper", "Keystone", "Liberty", "Meridian", "Northwind", "Orion", "Pioneer"
+    ]
+
+    private static let rivalSuffixes = [
+        "Steel", "Textiles", "Railways", "Mining", "Foods", "Chemicals", "Shipping", "Lumber",
+        "Petroleum", "Machinery", "Trading Co.", "Holdings"
+    ]
+}
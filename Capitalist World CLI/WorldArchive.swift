@@ -0,0 +1,463 @@
+import Foundation
+
+enum WorldArchiveError: LocalizedError {
+    case malformed
+
+    var errorDescription: String? {
+        Localization.shared.worldArchiveMalformedMessage()
+    }
+}
+
+/// Binary save format of a `World`, laid out to be used straight from a
+/// memory mapping:
+///
+///     header (64 bytes): magic "CWWA" · version · section count ·
+///                        section table offset · archive length
+///     section table:     per section: kind · layout version · offset ·
+///                        byte length · element count (32 bytes each)
+///     sections:          each starting on a 64-byte boundary
+///
+/// Offsets are relative to the start of the archive. Numeric columns hold
+/// raw little-endian elements, so decoding one is a bounds check and bulk
+/// copies, with no per-element parsing; names are length-prefixed UTF-8 and
+/// the scalar state is a small property list, both parsed. `decode` copies
+/// every section into the world's arrays, so the whole archive is read on
+/// load: the mapping saves a read buffer, not the reads. Sections of
+/// unknown kinds are skipped, so newer saves can add columns without
+/// breaking older readers.
+///
+/// Each section carries its own layout version, so a future layout change
+/// touches one section, not the archive version. Every section is still at
+/// its first layout and no upgrade steps exist; a section at any other
+/// version is rejected. The first change adds its step to `section` in
+/// `decode`, where it runs for that section only.
+enum WorldArchive {
+    private static let magic: UInt32 = 0x4157_5743  // "CWWA"
+    private static let version: UInt32 = 2
+    private static let alignment = 64
+    private static let headerSize = 64
+    private static let sectionEntrySize = 32
+
+    enum Section: UInt32, CaseIterable {
+        case scalarState = 1
+        case companyNames
+        case companyCash
+        case companyRevenue
+        case companyCosts
+        case companyGrowth
+        case companyOwner
+        case companyCreditLimit
+        case companyRegion
+        case warehouseNames
+        case warehouseOwner
+        case inventoryPairs
+        case inventoryQuantities
+        case inventoryCosts
+        case marketingAwareness
+
+        /// Layout version this release writes. Raising it requires an
+        /// upgrade step from the previous version.
+        var version: UInt32 { 1 }
+    }
+
+    /// Encodes worlds, reusing the bytes of every `ChunkedArray` chunk still
+    /// shared with the world it encoded last. The previous world is
+    /// retained, which is what keeps `ChunkedArray.sharesChunk` sound. Not
+    /// thread-safe.
+    final class Encoder {
+        private var doubleChunks: [Section: ChunkCache<Double>] = [:]
+        private var int32Chunks: [Section: ChunkCache<Int32>] = [:]
+        private var stringChunks: [Section: ChunkCache<String>] = [:]
+        /// Offset of every piece of the archive encoded last, by section.
+        private var pieceOffsets: [Section: [Int]] = [:]
+        /// Which pieces of the current encode were reused, by section.
+        private var reusedPieces: [Section: [Bool]] = [:]
+        private(set) var lastDirtyChunks = 0
+        private(set) var lastTotalChunks = 0
+        /// Byte ranges of the archive encoded last that may differ from the
+        /// one encoded before it, up to the shorter length; `nil` when there
+        /// was none to compare with. Reused chunks that kept their offset
+        /// are left out, so a save can write just these ranges.
+        private(set) var lastChanges: [Range<Int>]?
+
+        /// Forgets the cached chunks, e.g. when a different game is loaded
+        /// or a save of the last archive failed.
+        func reset() {
+            doubleChunks = [:]
+            int32Chunks = [:]
+            stringChunks = [:]
+            pieceOffsets = [:]
+        }
+
+        func encode(_ world: World) throws -> Data {
+            let encoder = PropertyListEncoder()
+            encoder.outputFormat = .binary
+            let scalar = try encoder.encode(world.scalarState())
+            let layers = world.inventory.exportLayers()
+
+            lastDirtyChunks = 0
+            lastTotalChunks = 0
+            reusedPieces = [:]
+            let sections: [(Section, pieces: [Data], count: Int)] = Section.allCases.map { section in
+                switch section {
+                case .scalarState:
+                    return (section, [scalar], 1)
+                case .companyNames, .warehouseNames:
+                    let values = section == .companyNames ? world.companyNames : world.warehouseNames
+                    return (section, update(&stringChunks, section, values, encode: WorldArchive.encodeStrings), values.count)
+                case .companyOwner, .companyRegion, .warehouseOwner:
+                    let values = WorldArchive.int32Column(section, of: world)
+                    return (section, update(&int32Chunks, section, values, encode: WorldArchive.encodeValues), values.count)
+                case .companyCash, .companyRevenue, .companyCosts, .companyGrowth, .companyCreditLimit:
+                    let values = WorldArchive.doubleColumn(section, of: world)
+                    return (section, update(&doubleChunks, section, values, encode: WorldArchive.encodeValues), values.count)
+                case .inventoryPairs:
+                    return (section, [WorldArchive.encodeArray(layers.map(\.pair))], layers.count)
+                case .inventoryQuantities:
+                    return (section, [WorldArchive.encodeArray(layers.map(\.quantity))], layers.count)
+                case .inventoryCosts:
+                    return (section, [WorldArchive.encodeArray(layers.map(\.unitCost))], layers.count)
+                case .marketingAwareness:
+                    return (section, [WorldArchive.encodeArray(world.marketing.awareness)], world.marketing.awareness.count)
+                }
+            }
+            let (data, offsets) = WorldArchive.assemble(sections)
+            lastChanges = pieceOffsets.isEmpty ? nil : changes(in: data, sections: sections, offsets: offsets)
+            pieceOffsets = Dictionary(uniqueKeysWithValues: zip(sections.map(\.0), offsets))
+            return data
+        }
+
+        /// Everything in `data` except the reused pieces found at the same
+        /// offset in the previous archive, merged into ranges.
+        private func changes(
+            in data: Data,
+            sections: [(Section, pieces: [Data], count: Int)],
+            offsets: [[Int]]
+        ) -> [Range<Int>] {
+            var clean: [Range<Int>] = []
+            for ((section, pieces, _), sectionOffsets) in zip(sections, offsets) {
+                guard let flags = reusedPieces[section], let previous = pieceOffsets[section] else { continue }
+                for (piece, offset) in sectionOffsets.enumerated()
+                where flags[piece] && piece < previous.count && previous[piece] == offset {
+                    clean.append(offset..<offset + pieces[piece].count)
+                }
+            }
+            clean.sort { $0.lowerBound < $1.lowerBound }
+
+            var ranges: [Range<Int>] = []
+            var start = 0
+            for range in clean {
+                if range.lowerBound > start {
+                    ranges.append(start..<range.lowerBound)
+                }
+                start = max(start, range.upperBound)
+            }
+            if start < data.count {
+                ranges.append(start..<data.count)
+            }
+            return ranges
+        }
+
+        private func update<Element>(
+            _ caches: inout [Section: ChunkCache<Element>],
+            _ section: Section,
+            _ values: ChunkedArray<Element>,
+            encode: (UnsafeBufferPointer<Element>) -> Data
+        ) -> [Data] {
+            var cache = caches[section] ?? ChunkCache()
+            lastDirtyChunks += cache.update(values, encode: encode)
+            lastTotalChunks += values.chunkCount
+            reusedPieces[section] = cache.reused
+            caches[section] = cache
+            return cache.chunks
+        }
+    }
+
+    private struct ChunkCache<Element> {
+        var source = ChunkedArray<Element>()
+        var chunks: [Data] = []
+        /// Whether each chunk was reused by the last `update`.
+        var reused: [Bool] = []
+
+        /// Re-encodes the chunks of `values` not shared with the previous
+        /// source and returns how many that was.
+        mutating func update(_ values: ChunkedArray<Element>, encode: (UnsafeBufferPointer<Element>) -> Data) -> Int {
+            var updated: [Data] = []
+            updated.reserveCapacity(values.chunkCount)
+            reused = []
+            reused.reserveCapacity(values.chunkCount)
+            var dirty = 0
+            for chunk in 0..<values.chunkCount {
+                if chunk < chunks.count, values.sharesChunk(chunk, with: source) {
+                    updated.append(chunks[chunk])
+                    reused.append(true)
+                } else {
+                    updated.append(values.withUnsafeChunk(chunk) { buffer, _ in encode(buffer) })
+                    reused.append(false)
+                    dirty += 1
+                }
+            }
+            source = values
+            chunks = updated
+            return dirty
+        }
+    }
+
+    private struct SectionEntry {
+        let kind: UInt32
+        let version: UInt32
+        let offset: Int
+        let length: Int
+        let count: Int
+    }
+
+    static func decode(_ data: Data) throws -> World {
+        try data.withUnsafeBytes { raw in
+            let entries = try sectionTable(raw)
+            // Calls `body` with the section's bytes and its element count;
+            // `nil` if the section is absent.
+            func section<Value>(
+                _ section: Section,
+                _ body: (UnsafeRawBufferPointer, Int) throws -> Value
+            ) throws -> Value? {
+                guard let entry = entries[section] else { return nil }
+                return try body(UnsafeRawBufferPointer(rebasing: raw[entry.offset..<entry.offset + entry.length]), entry.count)
+            }
+
+            guard var state = try section(.scalarState, { bytes, _ in
+                try PropertyListDecoder().decode(World.State.self, from: Data(bytes))
+            }) else {
+                throw WorldArchiveError.malformed
+            }
+
+            for kind in Section.allCases where kind != .scalarState {
+                _ = try section(kind) { buffer, count in
+                    try decodeColumn(kind, from: buffer, count: count, into: &state)
+                }
+            }
+
+            let pairs: [Int32]? = try section(.inventoryPairs) { try decodeValues($0, count: $1) }
+            let quantities: [Double]? = try section(.inventoryQuantities) { try decodeValues($0, count: $1) }
+            let costs: [Double]? = try section(.inventoryCosts) { try decodeValues($0, count: $1) }
+            if let pairs, let quantities, let costs {
+                guard quantities.count == pairs.count, costs.count == pairs.count else {
+                    throw WorldArchiveError.malformed
+                }
+                state.inventoryLayers = pairs.indices.map { index in
+                    InventoryLedger.Layer(pair: pairs[index], quantity: quantities[index], unitCost: costs[index])
+                }
+            }
+
+            guard state.companyCash.count == state.companyNames.count,
+                  state.companyOwner.count == state.companyNames.count else {
+                throw WorldArchiveError.malformed
+            }
+            return World(state: state)
+        }
+    }
+
+    /// Decodes one column section into `state`. Inventory sections are
+    /// decoded together by the caller.
+    private static func decodeColumn(
+        _ section: Section,
+        from buffer: UnsafeRawBufferPointer,
+        count: Int,
+        into state: inout World.State
+    ) throws {
+        switch section {
+        case .scalarState, .inventoryPairs, .inventoryQuantities, .inventoryCosts:
+            break
+        case .companyNames:
+            state.companyNames = try decodeStrings(buffer, count: count)
+        case .warehouseNames:
+            state.warehouseNames = try decodeStrings(buffer, count: count)
+        case .companyOwner:
+            state.companyOwner = try decodeValues(buffer, count: count)
+        case .companyRegion:
+            state.companyRegion = try decodeValues(buffer, count: count)
+        case .warehouseOwner:
+            state.warehouseOwner = try decodeValues(buffer, count: count)
+        case .companyCash:
+            state.companyCash = try decodeValues(buffer, count: count)
+        case .companyRevenue:
+            state.companyRevenue = try decodeValues(buffer, count: count)
+        case .companyCosts:
+            state.companyCosts = try decodeValues(buffer, count: count)
+        case .companyGrowth:
+            state.companyGrowth = try decodeValues(buffer, count: count)
+        case .companyCreditLimit:
+            state.companyCreditLimit = try decodeValues(buffer, count: count)
+        case .marketingAwareness:
+            state.marketing?.awareness = try decodeValues(buffer, count: count)
+        }
+    }
+
+    /// Validates the header and section table against the archive bounds.
+    private static func sectionTable(_ raw: UnsafeRawBufferPointer) throws -> [Section: SectionEntry] {
+        func load<Value: FixedWidthInteger>(_ offset: Int, as type: Value.Type) -> Value {
+            Value(littleEndian: raw.loadUnaligned(fromByteOffset: offset, as: Value.self))
+        }
+
+        guard raw.count >= headerSize, load(0, as: UInt32.self) == magic, load(4, as: UInt32.self) == version else {
+            throw WorldArchiveError.malformed
+        }
+        let sectionCount = Int(load(8, as: UInt32.self))
+        let tableOffset = Int(load(16, as: UInt64.self))
+        guard Int(load(24, as: UInt64.self)) == raw.count,
+              tableOffset >= headerSize,
+              sectionCount <= (raw.count - tableOffset) / sectionEntrySize else {
+            throw WorldArchiveError.malformed
+        }
+
+        var entries: [Section: SectionEntry] = [:]
+        for index in 0..<sectionCount {
+            let base = tableOffset + index * sectionEntrySize
+            let entry = SectionEntry(
+                kind: load(base, as: UInt32.self),
+                version: load(base + 4, as: UInt32.self),
+                offset: Int(load(base + 8, as: UInt64.self)),
+                length: Int(load(base + 16, as: UInt64.self)),
+                count: Int(load(base + 24, as: UInt64.self))
+            )
+            guard entry.offset % alignment == 0, entry.offset <= raw.count, entry.length <= raw.count - entry.offset else {
+                throw WorldArchiveError.malformed
+            }
+            if let section = Section(rawValue: entry.kind) {
+                // No layout but the current one can be read yet.
+                guard entry.version == section.version else { throw WorldArchiveError.malformed }
+                entries[section] = entry
+            }
+        }
+        return entries
+    }
+
+    /// Lays out the header, the section table and the 64-byte-aligned
+    /// sections, concatenating each section's pieces. Also returns the
+    /// offset of every piece, by section.
+    private static func assemble(_ sections: [(Section, pieces: [Data], count: Int)]) -> (Data, [[Int]]) {
+        func aligned(_ offset: Int) -> Int {
+            (offset + alignment - 1) / alignment * alignment
+        }
+
+        let tableOffset = headerSize
+        var offset = aligned(tableOffset + sections.count * sectionEntrySize)
+        var entries: [SectionEntry] = []
+        for (section, pieces, count) in sections {
+            let length = pieces.reduce(0) { $0 + $1.count }
+            entries.append(
+                SectionEntry(kind: section.rawValue, version: section.version, offset: offset, length: length, count: count)
+            )
+            offset = aligned(offset + length)
+        }
+
+        var data = Data(capacity: offset)
+        data.append(value: magic)
+        data.append(value: version)
+        data.append(value: UInt32(sections.count))
+        data.append(value: UInt32(0))
+        data.append(value: UInt64(tableOffset))
+        data.append(value: UInt64(offset))
+        data.pad(to: headerSize)
+
+        for entry in entries {
+            data.append(value: entry.kind)
+            data.append(value: entry.version)
+            data.append(value: UInt64(entry.offset))
+            data.append(value: UInt64(entry.length))
+            data.append(value: UInt64(entry.count))
+        }
+
+        var pieceOffsets: [[Int]] = []
+        for (entry, section) in zip(entries, sections) {
+            data.pad(to: entry.offset)
+            var offsets: [Int] = []
+            for piece in section.pieces {
+                offsets.append(data.count)
+                data.append(piece)
+            }
+            pieceOffsets.append(offsets)
+        }
+        data.pad(to: offset)
+        return (data, pieceOffsets)
+    }
+
+    private static func doubleColumn(_ section: Section, of world: World) -> ChunkedArray<Double> {
+        switch section {
+        case .companyCash:
+            return world.companyCash
+        case .companyRevenue:
+            return world.companyRevenue
+        case .companyCosts:
+            return world.companyCosts
+        case .companyGrowth:
+            return world.companyGrowth
+        default:
+            return world.companyCreditLimit
+        }
+    }
+
+    private static func int32Column(_ section: Section, of world: World) -> ChunkedArray<Int32> {
+        switch section {
+        case .companyOwner:
+            return world.companyOwner
+        case .companyRegion:
+            return world.companyRegion
+        default:
+            return world.warehouseOwner
+        }
+    }
+
+    private static func encodeValues<Element>(_ buffer: UnsafeBufferPointer<Element>) -> Data {
+        Data(buffer: buffer)
+    }
+
+    private static func encodeArray<Element>(_ values: [Element]) -> Data {
+        values.withUnsafeBufferPointer { Data(buffer: $0) }
+    }
+
+    private static func encodeStrings(_ buffer: UnsafeBufferPointer<String>) -> Data {
+        var data = Data()
+        for value in buffer {
+            let utf8 = Array(value.utf8)
+            data.append(value: UInt32(utf8.count))
+            data.append(contentsOf: utf8)
+        }
+        return data
+    }
+
+    private static func decodeValues<Element>(_ bytes: UnsafeRawBufferPointer, count: Int) throws -> [Element] {
+        guard bytes.count == count * MemoryLayout<Element>.stride else { throw WorldArchiveError.malformed }
+        return [Element](unsafeUninitializedCapacity: count) { buffer, initialized in
+            UnsafeMutableRawBufferPointer(buffer).copyMemory(from: bytes)
+            initialized = count
+        }
+    }
+
+    private static func decodeStrings(_ bytes: UnsafeRawBufferPointer, count: Int) throws -> [String] {
+        var values: [String] = []
+        values.reserveCapacity(count)
+        var offset = 0
+        while offset < bytes.count {
+            guard bytes.count - offset >= 4 else { throw WorldArchiveError.malformed }
+            let length = Int(UInt32(littleEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt32.self)))
+            offset += 4
+            guard bytes.count - offset >= length else { throw WorldArchiveError.malformed }
+            values.append(String(decoding: UnsafeRawBufferPointer(rebasing: bytes[offset..<offset + length]), as: UTF8.self))
+            offset += length
+        }
+        guard values.count == count else { throw WorldArchiveError.malformed }
+        return values
+    }
+}
+
+private extension Data {
+    mutating func append<Value: FixedWidthInteger>(value: Value) {
+        Swift.withUnsafeBytes(of: value.littleEndian) { append(contentsOf: $0) }
+    }
+
+    mutating func pad(to length: Int) {
+        if count < length {
+            append(Data(count: length - count))
+        }
+    }
+}
@@ -0,0 +1,865 @@
+// Tests of the native code, run by `native-tests.sh`. Each test gets an
+// empty directory of its own and drives the code through the same C entry
+// points the Swift side calls, so crash and damage scenarios are staged on
+// the real files: journals cut mid-entry, flipped bytes in world and
+// catalog files.
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+extern "C" void *SaveStoreOpen(const char *directory, char *errorBuffer, int32_t errorCapacity);
+extern "C" void SaveStoreClose(void *handle);
+extern "C" int64_t SaveStorePut(void *handle,
+                                const uint8_t *id,
+                                int32_t status,
+                                double balance,
+                                double createdAt,
+                                double updatedAt,
+                                double lastSavedAt,
+                                const char *name,
+                                int32_t nameLength,
+                                const char *playerName,
+                                int32_t playerNameLength,
+                                const char *companyName,
+                                int32_t companyNameLength,
+                                const uint8_t *world,
+                                int64_t worldLength);
+extern "C" int64_t SaveStoreRemove(void *handle, const uint8_t *id);
+extern "C" int32_t SaveStoreCommit(void *handle, int64_t sequence);
+extern "C" void *SaveStoreListingOpen(void *handle);
+extern "C" void SaveStoreListingClose(void *listing);
+extern "C" int32_t SaveStoreListingCount(void *listing);
+extern "C" int32_t SaveStoreListingFind(void *listing, const uint8_t *id);
+extern "C" void SaveStoreListingRecord(void *listing,
+                                       int32_t index,
+                                       uint8_t *id,
+                                       int32_t *status,
+                                       double *balance,
+                                       double *createdAt,
+                                       double *updatedAt,
+                                       double *lastSavedAt);
+extern "C" const char *SaveStoreListingString(void *listing, int32_t index, int32_t field, int32_t *length);
+extern "C" int32_t SaveStoreCompact(void *handle);
+extern "C" int64_t SaveStoreWriteWorld(void *handle,
+                                       const uint8_t *id,
+                                       const uint8_t *world,
+                                       int64_t worldLength,
+                                       int64_t base,
+                                       int64_t baseLength,
+                                       const int64_t *ranges,
+                                       int32_t rangeCount);
+extern "C" const uint8_t *SaveStoreMapWorld(void *handle, const uint8_t *id, int64_t *length, int64_t *mappedLength);
+extern "C" void SaveStoreUnmapWorld(const uint8_t *mapping, int64_t length);
+extern "C" void *SaveTransferArchiveOpen(const char *path, char *errorBuffer, int32_t errorCapacity);
+extern "C" int32_t SaveTransferArchiveAppend(void *archive,
+                                             void *store,
+                                             const uint8_t *id,
+                                             int32_t status,
+                                             double balance,
+                                             double createdAt,
+                                             double updatedAt,
+                                             double lastSavedAt,
+                                             const char *name,
+                                             int32_t nameLength,
+                                             const char *playerName,
+                                             int32_t playerNameLength,
+                                             const char *companyName,
+                                             int32_t companyNameLength,
+                                             char *errorBuffer,
+                                             int32_t errorCapacity);
+extern "C" int32_t SaveTransferArchiveSync(void *archive, char *errorBuffer, int32_t errorCapacity);
+extern "C" void SaveTransferArchiveClose(void *archive);
+extern "C" int32_t SaveTransferImportAll(void *store,
+                                         const char *path,
+                                         void (*imported)(void *context, const uint8_t *id),
+                                         void *context,
+                                         char *errorBuffer,
+                                         int32_t errorCapacity);
+extern "C" int32_t SaveStoreImportCoreData(void *handle, const char *path, char *errorBuffer, int32_t errorCapacity);
+extern "C" void *SnapshotStoreOpen(const char *directory, char *errorBuffer, int32_t errorCapacity);
+extern "C" void SnapshotStoreClose(void *handle);
+extern "C" int32_t SnapshotStoreCapture(void *handle,
+                                        const uint8_t *id,
+                                        int32_t day,
+                                        double createdAt,
+                                        const uint8_t *world,
+                                        int64_t length);
+extern "C" int32_t SnapshotStoreList(void *handle,
+                                     const uint8_t *id,
+                                     int32_t capacity,
+                                     uint64_t *sequences,
+                                     int32_t *days,
+                                     double *createdAt,
+                                     int64_t *lengths,
+                                     int64_t *addedBytes);
+extern "C" int32_t SnapshotStoreRestore(void *handle,
+                                        const uint8_t *id,
+                                        uint64_t sequence,
+                                        uint8_t *world,
+                                        int64_t length);
+extern "C" void *InventoryCreate(int32_t costingMethod, int32_t pairCount);
+extern "C" void *InventoryClone(void *handle);
+extern "C" void InventoryDestroy(void *handle);
+extern "C" void InventoryApplyReceipts(void *handle,
+                                       const int32_t *pairIndices,
+                                       const double *quantities,
+                                       const double *unitCosts,
+                                       int32_t count);
+extern "C" double InventoryApplyIssues(void *handle,
+                                       const int32_t *pairIndices,
+                                       const double *quantities,
+                                       int32_t count,
+                                       double *issuedCosts);
+extern "C" double InventoryOnHand(void *handle, int32_t pairIndex);
+extern "C" double InventoryCarryingValue(void *handle, int32_t pairIndex);
+extern "C" int32_t InventoryLayerCount(void *handle);
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) expect((condition), #condition, __FILE__, __LINE__)
+
+void expect(bool condition, const char *text, const char *file, int line) {
+    if (!condition) {
+        std::fprintf(stderr, "  %s:%d: expected %s\n", file, line, text);
+        ++failures;
+    }
+}
+
+using GameID = std::vector<uint8_t>;
+
+GameID gameID(uint8_t seed) {
+    GameID id(16);
+    for (size_t index = 0; index < id.size(); ++index) {
+        id[index] = static_cast<uint8_t>(seed * 31 + index);
+    }
+    return id;
+}
+
+void *openStore(const std::string &directory) {
+    char error[512] = {};
+    void *store = SaveStoreOpen(directory.c_str(), error, sizeof(error));
+    if (store == nullptr) {
+        std::fprintf(stderr, "  cannot open store: %s\n", error);
+    }
+    return store;
+}
+
+// Records a game named `name` with `world`, or without one when it is
+// empty, and commits it.
+bool putGame(void *store, const GameID &id, const std::string &name, double balance,
+             const std::vector<uint8_t> &world = {}) {
+    const int64_t sequence = SaveStorePut(store, id.data(), 0, balance, 1, 2, 3, name.data(),
+                                          static_cast<int32_t>(name.size()), "player", 6, "company", 7,
+                                          world.empty() ? nullptr : world.data(),
+                                          world.empty() ? 0 : static_cast<int64_t>(world.size()));
+    return sequence >= 0 && SaveStoreCommit(store, sequence) == 0;
+}
+
+struct ListedGame {
+    bool found = false;
+    int32_t status = 0;
+    double balance = 0;
+    double createdAt = 0;
+    std::string name;
+};
+
+ListedGame findGame(void *store, const GameID &id) {
+    ListedGame game;
+    void *listing = SaveStoreListingOpen(store);
+    const int32_t index = SaveStoreListingFind(listing, id.data());
+    if (index >= 0) {
+        uint8_t listedID[16];
+        double updatedAt = 0;
+        double lastSavedAt = 0;
+        SaveStoreListingRecord(listing, index, listedID, &game.status, &game.balance, &game.createdAt, &updatedAt,
+                               &lastSavedAt);
+        int32_t length = 0;
+        const char *name = SaveStoreListingString(listing, index, 0, &length);
+        game.found = true;
+        game.name.assign(name, static_cast<size_t>(length));
+    }
+    SaveStoreListingClose(listing);
+    return game;
+}
+
+int32_t gameCount(void *store) {
+    void *listing = SaveStoreListingOpen(store);
+    const int32_t count = SaveStoreListingCount(listing);
+    SaveStoreListingClose(listing);
+    return count;
+}
+
+off_t fileSize(const std::string &path) {
+    struct stat info {};
+    return ::stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+void appendToFile(const std::string &path, const std::vector<uint8_t> &bytes) {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+    if (fd >= 0) {
+        EXPECT(::write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+        ::close(fd);
+    }
+}
+
+// Committed puts and removes come back from the journal alone, and a torn
+// entry at its end, as a crash mid-write leaves, is dropped without losing
+// the entries before it or the ones written after the next open.
+void testJournalReplay(const std::string &directory) {
+    void *store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(putGame(store, gameID(1), "first", 100));
+    EXPECT(putGame(store, gameID(2), "second", 200));
+    EXPECT(putGame(store, gameID(1), "first renamed", 150));
+    EXPECT(putGame(store, gameID(3), "third", 300));
+    EXPECT(SaveStoreCommit(store, SaveStoreRemove(store, gameID(3).data())) == 0);
+    SaveStoreClose(store);
+
+    const std::string journal = directory + "/saves.journal";
+    const off_t intactLength = fileSize(journal);
+    EXPECT(intactLength > 0);
+    // A header claiming more payload than follows, then a few stray bytes.
+    std::vector<uint8_t> torn(40, 0xA5);
+    const uint32_t magic = 0x4C575743;
+    std::memcpy(torn.data(), &magic, sizeof(magic));
+    appendToFile(journal, torn);
+
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(fileSize(journal) == intactLength);
+    EXPECT(gameCount(store) == 2);
+    const ListedGame first = findGame(store, gameID(1));
+    EXPECT(first.found && first.name == "first renamed" && first.balance == 150);
+    EXPECT(findGame(store, gameID(2)).balance == 200);
+    EXPECT(!findGame(store, gameID(3)).found);
+    EXPECT(putGame(store, gameID(4), "fourth", 400));
+    SaveStoreClose(store);
+
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(gameCount(store) == 3);
+    EXPECT(findGame(store, gameID(4)).name == "fourth");
+    SaveStoreClose(store);
+}
+
+// Flips one bit of the byte at `offset` of the file at `path`.
+void damage(const std::string &path, off_t offset) {
+    const int fd = ::open(path.c_str(), O_RDWR);
+    uint8_t byte = 0;
+    EXPECT(fd >= 0 && ::pread(fd, &byte, 1, offset) == 1);
+    byte ^= 0x40;
+    EXPECT(fd >= 0 && ::pwrite(fd, &byte, 1, offset) == 1);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+std::string worldPath(const std::string &directory, const GameID &id) {
+    static const char digits[] = "0123456789abcdef";
+    std::string name;
+    for (uint8_t byte : id) {
+        name.push_back(digits[byte >> 4]);
+        name.push_back(digits[byte & 0x0F]);
+    }
+    return directory + "/worlds/" + name + ".world";
+}
+
+// World the store maps for `id`: its first byte, which the tests use as a
+// version, or -1 when no checkpoint is intact and 0 when there is none.
+int worldVersion(void *store, const GameID &id, size_t expectedLength) {
+    int64_t length = 0;
+    int64_t mappedLength = 0;
+    const uint8_t *world = SaveStoreMapWorld(store, id.data(), &length, &mappedLength);
+    if (world == nullptr) {
+        return length < 0 ? -1 : 0;
+    }
+    const int version = static_cast<size_t>(length) == expectedLength ? world[0] : -2;
+    SaveStoreUnmapWorld(world, mappedLength);
+    return version;
+}
+
+// A world file with a damaged block falls back to the previous checkpoint,
+// a save never promotes a damaged file to previous, and a game whose
+// checkpoints are both damaged reports it instead of loading garbage.
+void testDamagedWorldFallback(const std::string &directory) {
+    void *store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    // Several checksum blocks, so the damage lands in one in the middle.
+    std::vector<uint8_t> world(300000, 0);
+    const GameID id = gameID(1);
+    const std::string path = worldPath(directory, id);
+    world[0] = 1;
+    EXPECT(putGame(store, id, "game", 1, world));
+    world[0] = 2;
+    EXPECT(putGame(store, id, "game", 1, world));
+    EXPECT(worldVersion(store, id, world.size()) == 2);
+    SaveStoreClose(store);
+
+    // Reopened, so the damage is not hidden by this process having
+    // verified the file already.
+    damage(path, 100000);
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(worldVersion(store, id, world.size()) == 1);
+
+    // The damaged version 2 must not replace version 1 as previous.
+    world[0] = 3;
+    EXPECT(putGame(store, id, "game", 1, world));
+    EXPECT(worldVersion(store, id, world.size()) == 3);
+    SaveStoreClose(store);
+    damage(path, 200000);
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(worldVersion(store, id, world.size()) == 1);
+    SaveStoreClose(store);
+
+    damage(path + ".prev", 10);
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(worldVersion(store, id, world.size()) == -1);
+    SaveStoreClose(store);
+}
+
+// A damaged catalog falls back to the previous one and is replaced by a
+// fresh catalog at the same open.
+void testCatalogRecovery(const std::string &directory) {
+    void *store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(putGame(store, gameID(1), "kept", 10));
+    EXPECT(SaveStoreCompact(store) == 0);
+    EXPECT(putGame(store, gameID(2), "also kept", 20));
+    EXPECT(SaveStoreCompact(store) == 0);
+    SaveStoreClose(store);
+
+    const std::string catalog = directory + "/saves.catalog";
+    EXPECT(fileSize(catalog + ".prev") > 0);
+    damage(catalog, fileSize(catalog) - 1);
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(findGame(store, gameID(1)).name == "kept");
+    SaveStoreClose(store);
+
+    // The catalog written at recovery opens on its own.
+    ::unlink((catalog + ".prev").c_str());
+    store = openStore(directory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(findGame(store, gameID(1)).name == "kept");
+    SaveStoreClose(store);
+}
+
+// World of `length` bytes for game `seed`: runs of repeated bytes, which
+// LZ4 compresses, broken up by noise, which it does not.
+std::vector<uint8_t> sampleWorld(uint8_t seed, size_t length) {
+    std::vector<uint8_t> world(length);
+    uint32_t state = seed * 2654435761u + 1;
+    for (size_t index = 0; index < length; ++index) {
+        state = state * 1664525u + 1013904223u;
+        const bool run = (index / 4096) % 2 == 0;
+        world[index] = run ? static_cast<uint8_t>(index / 4096 + seed) : static_cast<uint8_t>(state >> 24);
+    }
+    return world;
+}
+
+bool sameWorld(void *store, const GameID &id, const std::vector<uint8_t> &expected) {
+    int64_t length = 0;
+    int64_t mappedLength = 0;
+    const uint8_t *world = SaveStoreMapWorld(store, id.data(), &length, &mappedLength);
+    if (world == nullptr) {
+        return false;
+    }
+    const bool same = static_cast<size_t>(length) == expected.size() &&
+                      std::memcmp(world, expected.data(), expected.size()) == 0;
+    SaveStoreUnmapWorld(world, mappedLength);
+    return same;
+}
+
+void collectID(void *context, const uint8_t *id) {
+    static_cast<std::vector<GameID> *>(context)->emplace_back(id, id + 16);
+}
+
+void copyFile(const std::string &source, const std::string &destination, off_t length) {
+    std::vector<uint8_t> contents(static_cast<size_t>(length));
+    const int input = ::open(source.c_str(), O_RDONLY);
+    const int output = ::open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    EXPECT(input >= 0 && output >= 0);
+    EXPECT(::pread(input, contents.data(), contents.size(), 0) == length);
+    EXPECT(::pwrite(output, contents.data(), contents.size(), 0) == length);
+    ::close(input);
+    ::close(output);
+}
+
+// An archive imports whole, with every world streamed back through LZ4
+// intact, or not at all: a damaged or truncated last record removes the
+// games read before it, so the store is left as it was.
+void testAllOrNothingImport(const std::string &directory) {
+    const std::string source = directory + "/source";
+    const std::string destination = directory + "/destination";
+    EXPECT(::mkdir(source.c_str(), 0755) == 0 && ::mkdir(destination.c_str(), 0755) == 0);
+    void *store = openStore(source);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    const std::string path = directory + "/archive.cwex";
+    char error[512] = {};
+    void *archive = SaveTransferArchiveOpen(path.c_str(), error, sizeof(error));
+    EXPECT(archive != nullptr);
+    if (archive == nullptr) {
+        SaveStoreClose(store);
+        return;
+    }
+    std::vector<std::vector<uint8_t>> worlds;
+    for (uint8_t seed = 1; seed <= 3; ++seed) {
+        worlds.push_back(sampleWorld(seed, 200000 + seed * 50000));
+        const std::string name = "game " + std::to_string(seed);
+        EXPECT(putGame(store, gameID(seed), name, seed, worlds.back()));
+        EXPECT(SaveTransferArchiveAppend(archive, store, gameID(seed).data(), 0, seed, 1, 2, 3, name.data(),
+                                         static_cast<int32_t>(name.size()), "player", 6, "company", 7, error,
+                                         sizeof(error)) == 0);
+    }
+    EXPECT(SaveTransferArchiveSync(archive, error, sizeof(error)) == 0);
+    SaveTransferArchiveClose(archive);
+    SaveStoreClose(store);
+
+    store = openStore(destination);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(putGame(store, gameID(9), "local", 9));
+    const off_t length = fileSize(path);
+    const std::string truncated = directory + "/truncated.cwex";
+    copyFile(path, truncated, length - 1000);
+    const std::string damaged = directory + "/damaged.cwex";
+    copyFile(path, damaged, length);
+    damage(damaged, length - 1000);
+    for (const std::string &broken : {truncated, damaged}) {
+        std::vector<GameID> ids;
+        EXPECT(SaveTransferImportAll(store, broken.c_str(), collectID, &ids, error, sizeof(error)) == -1);
+        EXPECT(ids.empty());
+        EXPECT(gameCount(store) == 1);
+    }
+
+    std::vector<GameID> ids;
+    EXPECT(SaveTransferImportAll(store, path.c_str(), collectID, &ids, error, sizeof(error)) == 3);
+    EXPECT(ids.size() == 3 && gameCount(store) == 4);
+    for (size_t index = 0; index < ids.size() && index < worlds.size(); ++index) {
+        EXPECT(findGame(store, ids[index]).name == "game " + std::to_string(index + 1));
+        EXPECT(sameWorld(store, ids[index], worlds[index]));
+    }
+    SaveStoreClose(store);
+
+    // The rolled-back games stay removed after a reopen.
+    store = openStore(destination);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(gameCount(store) == 4);
+    SaveStoreClose(store);
+}
+
+std::vector<uint8_t> readFile(const std::string &path) {
+    std::vector<uint8_t> contents(static_cast<size_t>(std::max<off_t>(fileSize(path), 0)));
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    EXPECT(fd >= 0 && ::pread(fd, contents.data(), contents.size(), 0) == static_cast<ssize_t>(contents.size()));
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    return contents;
+}
+
+// A world file patched with only the changed ranges is byte for byte the
+// file a full write of the same world produces, as the world grows and
+// shrinks; a base that is no longer the current file is rewritten whole.
+void testWorldDelta(const std::string &directory) {
+    const std::string patched = directory + "/patched";
+    const std::string full = directory + "/full";
+    EXPECT(::mkdir(patched.c_str(), 0755) == 0 && ::mkdir(full.c_str(), 0755) == 0);
+    void *store = openStore(patched);
+    void *reference = openStore(full);
+    EXPECT(store != nullptr && reference != nullptr);
+    if (store == nullptr || reference == nullptr) {
+        SaveStoreClose(store);
+        SaveStoreClose(reference);
+        return;
+    }
+    const GameID id = gameID(1);
+    std::vector<uint8_t> world = sampleWorld(1, 1000000);
+    int64_t generation = SaveStoreWriteWorld(store, id.data(), world.data(), static_cast<int64_t>(world.size()), 0,
+                                             0, nullptr, 0);
+    EXPECT(generation > 0);
+
+    uint32_t state = 12345;
+    const auto next = [&state](uint32_t bound) {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) % bound;
+    };
+    bool identical = true;
+    for (int round = 0; round < 24; ++round) {
+        const size_t baseLength = world.size();
+        std::vector<int64_t> ranges;
+        for (uint32_t edit = next(5); edit > 0; --edit) {
+            const size_t offset = next(static_cast<uint32_t>(world.size()));
+            const size_t length = std::min<size_t>(1 + next(100000), world.size() - offset);
+            for (size_t index = offset; index < offset + length; ++index) {
+                world[index] = static_cast<uint8_t>(next(256));
+            }
+            ranges.push_back(static_cast<int64_t>(offset));
+            ranges.push_back(static_cast<int64_t>(length));
+        }
+        const uint32_t resize = next(3);
+        if (resize == 1) {
+            world.resize(world.size() + next(200000));
+        } else if (resize == 2) {
+            world.resize(world.size() - next(200000));
+        }
+        for (size_t index = std::min(baseLength, world.size()); index < world.size(); ++index) {
+            world[index] = static_cast<uint8_t>(next(256));
+        }
+
+        generation = SaveStoreWriteWorld(store, id.data(), world.data(), static_cast<int64_t>(world.size()),
+                                         generation, static_cast<int64_t>(baseLength), ranges.data(),
+                                         static_cast<int32_t>(ranges.size() / 2));
+        EXPECT(generation > 0);
+        EXPECT(putGame(reference, id, "game", 1, world));
+        identical = identical && readFile(worldPath(patched, id)) == readFile(worldPath(full, id));
+    }
+    EXPECT(identical);
+
+    // Another writer replaces the file; a delta against the old generation
+    // must not be applied on top of it.
+    EXPECT(putGame(store, id, "game", 1, world));
+    world[0] ^= 1;
+    world[1] ^= 1;
+    const int64_t firstByte[] = {0, 1};
+    EXPECT(SaveStoreWriteWorld(store, id.data(), world.data(), static_cast<int64_t>(world.size()), generation,
+                               static_cast<int64_t>(world.size()), firstByte, 1) > 0);
+    EXPECT(putGame(reference, id, "game", 1, world));
+    EXPECT(readFile(worldPath(patched, id)) == readFile(worldPath(full, id)));
+    EXPECT(sameWorld(store, id, world));
+    SaveStoreClose(store);
+    SaveStoreClose(reference);
+}
+
+bool execute(sqlite3 *db, const char *sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+// Games of a store in the Core Data layout of the first releases are
+// added once, with their ids and dates, and rows without a valid id are
+// skipped.
+void testCoreDataImport(const std::string &directory) {
+    const std::string legacy = directory + "/CapitalistWorldCLI.sqlite";
+    sqlite3 *db = nullptr;
+    EXPECT(sqlite3_open(legacy.c_str(), &db) == SQLITE_OK);
+    EXPECT(execute(db, "PRAGMA journal_mode=WAL"));
+    EXPECT(execute(db, R"sql(
+CREATE TABLE ZGAME (Z_PK INTEGER PRIMARY KEY, Z_ENT INTEGER, Z_OPT INTEGER, ZBALANCE FLOAT, ZCREATEDAT TIMESTAMP,
+                    ZLASTSAVEDAT TIMESTAMP, ZUPDATEDAT TIMESTAMP, ZCOMPANYNAME VARCHAR, ZNAME VARCHAR,
+                    ZPLAYERNAME VARCHAR, ZSTATUS VARCHAR, ZID BLOB);
+INSERT INTO ZGAME VALUES
+    (1, 1, 1, 1500.5, 700000000, 700000100, 700000200, 'Acme', 'Partida', 'Ana', 'active',
+     X'00112233445566778899AABBCCDDEEFF'),
+    (2, 1, 1, 3, 1, 2, 3, 'Broken', NULL, 'Bea', 'active', X'FF'),
+    (3, 1, 1, 9, 10, 20, 30, 'Corp', 'Vieja', 'Carla', 'abandoned', X'0F0E0D0C0B0A09080706050403020100');
+)sql"));
+    sqlite3_close(db);
+
+    const std::string storeDirectory = directory + "/store";
+    EXPECT(::mkdir(storeDirectory.c_str(), 0755) == 0);
+    void *store = openStore(storeDirectory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    char error[512] = {};
+    EXPECT(SaveStoreImportCoreData(store, legacy.c_str(), error, sizeof(error)) == 2);
+    EXPECT(SaveStoreImportCoreData(store, legacy.c_str(), error, sizeof(error)) == 0);
+    EXPECT(SaveStoreImportCoreData(store, (directory + "/missing.sqlite").c_str(), error, sizeof(error)) == -1);
+    SaveStoreClose(store);
+
+    store = openStore(storeDirectory);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(gameCount(store) == 2);
+    const GameID active = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                           0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+    const ListedGame imported = findGame(store, active);
+    EXPECT(imported.found && imported.name == "Partida" && imported.status == 0 && imported.balance == 1500.5);
+    EXPECT(imported.createdAt == 700000000.0 + 978307200.0);
+    const GameID abandoned = {0x0F, 0x0E, 0x0D, 0x0C, 0x0B, 0x0A, 0x09, 0x08,
+                              0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00};
+    EXPECT(findGame(store, abandoned).status == 1);
+    SaveStoreClose(store);
+}
+
+struct Snapshot {
+    uint64_t sequence;
+    int64_t length;
+    int64_t addedBytes;
+};
+
+std::vector<Snapshot> listSnapshots(void *store, const GameID &id) {
+    constexpr int32_t kCapacity = 64;
+    uint64_t sequences[kCapacity];
+    int32_t days[kCapacity];
+    double createdAt[kCapacity];
+    int64_t lengths[kCapacity];
+    int64_t addedBytes[kCapacity];
+    const int32_t count = SnapshotStoreList(store, id.data(), kCapacity, sequences, days, createdAt, lengths,
+                                            addedBytes);
+    std::vector<Snapshot> snapshots;
+    for (int32_t index = 0; index < count; ++index) {
+        snapshots.push_back(Snapshot{sequences[index], lengths[index], addedBytes[index]});
+    }
+    return snapshots;
+}
+
+bool restores(void *store, const GameID &id, const Snapshot &snapshot, const std::vector<uint8_t> &expected) {
+    std::vector<uint8_t> world(static_cast<size_t>(snapshot.length));
+    return SnapshotStoreRestore(store, id.data(), snapshot.sequence, world.data(), snapshot.length) == 0 &&
+           world == expected;
+}
+
+// Content-defined chunking keeps the chunks around an edit apart from the
+// rest: overwriting a few bytes, or inserting some that shift everything
+// after them, stores a few chunks rather than the tail of the world. Every
+// snapshot restores to the bytes it captured, also after reopening.
+void testSnapshotChunking(const std::string &directory) {
+    // Well above the 64 KiB maximum chunk, so a whole-world copy would show.
+    constexpr int64_t kEditBudget = 3 * (64 << 10);
+    void *store = SnapshotStoreOpen(directory.c_str(), nullptr, 0);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    const GameID id = gameID(1);
+    const std::vector<uint8_t> original = sampleWorld(1, 4 << 20);
+    std::vector<uint8_t> overwritten = original;
+    for (size_t index = 2000000; index < 2000100; ++index) {
+        overwritten[index] ^= 0x5A;
+    }
+    std::vector<uint8_t> inserted = original;
+    inserted.insert(inserted.begin() + 100000, 10, 0x42);
+    const std::vector<uint8_t> *worlds[] = {&original, &overwritten, &inserted};
+    int32_t day = 0;
+    for (const std::vector<uint8_t> *world : worlds) {
+        EXPECT(SnapshotStoreCapture(store, id.data(), ++day, 0, world->data(), static_cast<int64_t>(world->size())) ==
+               0);
+    }
+
+    std::vector<Snapshot> snapshots = listSnapshots(store, id);
+    EXPECT(snapshots.size() == 3);
+    if (snapshots.size() == 3) {
+        EXPECT(snapshots[2].addedBytes == static_cast<int64_t>(original.size()));
+        EXPECT(snapshots[1].addedBytes > 0 && snapshots[1].addedBytes <= kEditBudget);
+        EXPECT(snapshots[0].addedBytes > 0 && snapshots[0].addedBytes <= kEditBudget);
+        EXPECT(restores(store, id, snapshots[2], original));
+        EXPECT(restores(store, id, snapshots[1], overwritten));
+        EXPECT(restores(store, id, snapshots[0], inserted));
+    }
+    SnapshotStoreClose(store);
+
+    // After reopening, the rebuilt reference counts still know every chunk.
+    store = SnapshotStoreOpen(directory.c_str(), nullptr, 0);
+    EXPECT(store != nullptr);
+    if (store == nullptr) {
+        return;
+    }
+    EXPECT(SnapshotStoreCapture(store, id.data(), ++day, 0, original.data(), static_cast<int64_t>(original.size())) ==
+           0);
+    snapshots = listSnapshots(store, id);
+    EXPECT(snapshots.size() == 4);
+    if (snapshots.size() == 4) {
+        EXPECT(snapshots[0].addedBytes == 0);
+        EXPECT(restores(store, id, snapshots[0], original));
+        EXPECT(restores(store, id, snapshots[1], inserted));
+    }
+    SnapshotStoreClose(store);
+}
+
+bool near(double lhs, double rhs) {
+    return std::fabs(lhs - rhs) <= 1e-6 * std::max(1.0, std::fabs(rhs));
+}
+
+// FIFO issues cost the oldest lots first, lots of one pair are kept apart
+// from those of another, and a clone keeps its own layers once either side
+// writes to a shared chunk. Random batches are checked against a plain
+// queue of lots per pair.
+void testFIFOLayerCosting(const std::string &) {
+    constexpr int32_t kFIFO = 0;
+    // Pairs 1 and 1500 sit in different chunks of the ledger.
+    void *inventory = InventoryCreate(kFIFO, 2000);
+    const int32_t receiptPairs[] = {1, 1500, 1, 1};
+    const double receiptQuantities[] = {10, 4, 5, 10};
+    const double receiptCosts[] = {1, 7, 2, 1};
+    InventoryApplyReceipts(inventory, receiptPairs, receiptQuantities, receiptCosts, 4);
+    EXPECT(InventoryLayerCount(inventory) == 4);
+
+    void *clone = InventoryClone(inventory);
+    const int32_t issuePairs[] = {1, 1};
+    const double issueQuantities[] = {8, 4};
+    double issued[2] = {};
+    // 8 of the first lot at 1, then its last 2 and 2 of the second at 2.
+    EXPECT(near(InventoryApplyIssues(inventory, issuePairs, issueQuantities, 2, issued), 14));
+    EXPECT(near(issued[0], 8) && near(issued[1], 6));
+    EXPECT(near(InventoryOnHand(inventory, 1), 13) && near(InventoryCarryingValue(inventory, 1), 16));
+    EXPECT(InventoryLayerCount(inventory) == 3);
+    EXPECT(near(InventoryOnHand(inventory, 1500), 4) && near(InventoryCarryingValue(inventory, 1500), 28));
+
+    // The clone still has every lot; issuing more than is on hand issues
+    // what there is.
+    EXPECT(near(InventoryOnHand(clone, 1), 25) && near(InventoryCarryingValue(clone, 1), 30));
+    const double everything[] = {100};
+    EXPECT(near(InventoryApplyIssues(clone, issuePairs, everything, 1, nullptr), 30));
+    EXPECT(InventoryOnHand(clone, 1) == 0 && InventoryLayerCount(clone) == 1);
+    EXPECT(near(InventoryOnHand(inventory, 1), 13));
+    InventoryDestroy(clone);
+    InventoryDestroy(inventory);
+
+    struct Lot {
+        double quantity;
+        double unitCost;
+    };
+    constexpr int32_t kPairs = 3000;
+    std::vector<std::deque<Lot>> lots(kPairs);
+    inventory = InventoryCreate(kFIFO, kPairs);
+    uint32_t state = 777;
+    const auto next = [&state](uint32_t bound) {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) % bound;
+    };
+    bool matches = true;
+    for (int batch = 0; batch < 200; ++batch) {
+        std::vector<int32_t> pairs(64);
+        std::vector<double> quantities(64);
+        std::vector<double> costs(64);
+        for (size_t line = 0; line < pairs.size(); ++line) {
+            pairs[line] = static_cast<int32_t>(next(kPairs / 100)) * 100;
+            quantities[line] = 1 + next(50);
+            costs[line] = 1 + next(4);
+        }
+        if (batch % 2 == 0) {
+            InventoryApplyReceipts(inventory, pairs.data(), quantities.data(), costs.data(), 64);
+            for (size_t line = 0; line < pairs.size(); ++line) {
+                lots[static_cast<size_t>(pairs[line])].push_back(Lot{quantities[line], costs[line]});
+            }
+            continue;
+        }
+        std::vector<double> issuedCosts(64);
+        InventoryApplyIssues(inventory, pairs.data(), quantities.data(), 64, issuedCosts.data());
+        for (size_t line = 0; line < pairs.size(); ++line) {
+            std::deque<Lot> &queue = lots[static_cast<size_t>(pairs[line])];
+            double remaining = quantities[line];
+            double cost = 0;
+            while (remaining > 0 && !queue.empty()) {
+                const double taken = std::min(remaining, queue.front().quantity);
+                cost += taken * queue.front().unitCost;
+                remaining -= taken;
+                queue.front().quantity -= taken;
+                if (queue.front().quantity == 0) {
+                    queue.pop_front();
+                }
+            }
+            matches = matches && near(issuedCosts[line], cost);
+        }
+    }
+    for (int32_t pair = 0; pair < kPairs; ++pair) {
+        double quantity = 0;
+        double value = 0;
+        for (const Lot &lot : lots[static_cast<size_t>(pair)]) {
+            quantity += lot.quantity;
+            value += lot.quantity * lot.unitCost;
+        }
+        matches = matches && near(InventoryOnHand(inventory, pair), quantity) &&
+                  near(InventoryCarryingValue(inventory, pair), value);
+    }
+    EXPECT(matches);
+    InventoryDestroy(inventory);
+}
+
+struct Test {
+    const char *name;
+    void (*run)(const std::string &directory);
+};
+
+const Test kTests[] = {
+    {"journal replay", testJournalReplay},
+    {"Core Data import", testCoreDataImport},
+    {"damaged world fallback", testDamagedWorldFallback},
+    {"catalog recovery", testCatalogRecovery},
+    {"all-or-nothing import", testAllOrNothingImport},
+    {"world delta", testWorldDelta},
+    {"FIFO layer costing", testFIFOLayerCosting},
+    {"snapshot chunking", testSnapshotChunking},
+};
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s directory\n", argv[0]);
+        return 2;
+    }
+    const std::string root = argv[1];
+    int failed = 0;
+    int number = 0;
+    for (const Test &test : kTests) {
+        const std::string directory = root + "/" + std::to_string(++number);
+        if (::mkdir(directory.c_str(), 0755) != 0) {
+            std::fprintf(stderr, "cannot create %s\n", directory.c_str());
+            return 2;
+        }
+        const int before = failures;
+        test.run(directory);
+        const bool passed = failures == before;
+        std::printf("%s %s\n", passed ? "ok  " : "FAIL", test.name);
+        failed += passed ? 0 : 1;
+    }
+    std::printf("%d of %zu tests failed\n", failed, sizeof(kTests) / sizeof(kTests[0]));
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#!/bin/sh
+# Builds and runs the tests of the native code in a new temporary
+# directory. Needs a C++20 compiler and SQLite; CXXFLAGS adds compiler
+# flags, e.g. CXXFLAGS=-fsanitize=address,undefined.
+#
+#   Tests/native-tests.sh
+set -eu
+
+here=$(cd "$(dirname "$0")" && pwd)
+sources="$here/../Capitalist World CLI"
+binary=$(mktemp)
+directory=$(mktemp -d)
+trap 'rm -f "$binary"; rm -rf "$directory"' EXIT
+
+# shellcheck disable=SC2086
+${CXX:-c++} -std=gnu++20 -O1 -g -pthread ${CXXFLAGS:-} -o "$binary" "$here/NativeTests.cpp" \
+    "$sources/SaveStore.cpp" "$sources/SaveIO.cpp" "$sources/SaveTransfer.cpp" "$sources/CoreDataImport.cpp" \
+    "$sources/SnapshotStore.cpp" "$sources/InventoryLedger.cpp" \
+    -lsqlite3
+
+"$binary" "$directory"